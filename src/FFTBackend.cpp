@@ -0,0 +1,367 @@
+#include "FFTBackend.hpp"
+#include "PlanCache.hpp"
+#include "RadixFFT.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+namespace FFTBackend {
+namespace {
+
+// Two‑for‑one: z[n] = a[n] + i·b[n]
+template <typename T, typename C>
+void packPair(const T* a, const T* b, C* z, int n) {
+    for (int i = 0; i < n; ++i) {
+        z[i][0] = a[i];
+        z[i][1] = b[i];
+    }
+}
+
+// Z = FFT(z) -> A[k] = (Z[k] + Z*[N−k])/2, B[k] = (Z[k] − Z*[N−k])/2i, k = 0..N/2
+template <typename T, typename C>
+void splitPair(const C* Z, C* A, C* B, int n) {
+    for (int k = 0; k <= n / 2; ++k) {
+        const int m = k ? n - k : 0;
+        const T zr = Z[k][0], zi = Z[k][1];
+        const T cr = Z[m][0], ci = -Z[m][1];            // Z*[N−k]
+        A[k][0] = T(0.5) * (zr + cr);
+        A[k][1] = T(0.5) * (zi + ci);
+        B[k][0] = T(0.5) * (zi - ci);                   // (d_r + i·d_i)/2i = d_i/2 − i·d_r/2
+        B[k][1] = T(-0.5) * (zr - cr);
+    }
+}
+
+// Z[k] = A[k] + i·B[k], k = 0..N−1 (A e B hermitianos; imag. de DC/Nyquist ignorada, como no c2r)
+template <typename T, typename C>
+void mergePair(const C* A, const C* B, C* Z, int n) {
+    const int h = n / 2;
+    for (int k = 0; k <= h; ++k) {
+        const bool edge = (k == 0 || k == h);
+        const T ar = A[k][0], ai = edge ? T(0) : A[k][1];
+        const T br = B[k][0], bi = edge ? T(0) : B[k][1];
+        Z[k][0] = ar - bi;
+        Z[k][1] = ai + br;
+        if (!edge) {                                    // A*[k] + i·B*[k]
+            Z[n - k][0] = ar + bi;
+            Z[n - k][1] = br - ai;
+        }
+    }
+}
+
+// IFFT(Z) = N·(a + i·b) -> a, b (sem normalização, como o c2r)
+template <typename T, typename C>
+void unpackPair(const C* z, T* a, T* b, int n) {
+    for (int i = 0; i < n; ++i) {
+        a[i] = z[i][0];
+        b[i] = z[i][1];
+    }
+}
+
+// FFTW (planos partilhados do PlanCache): C vozes em lotes de 16, 8, 4, 2 e 1
+template <typename T>
+class FftwFFT : public RealFFT<T> {
+public:
+    using typename RealFFT<T>::Complex;
+    using RealFFT<T>::N;
+    using RealFFT<T>::freqDist;
+    static constexpr int NUM_BATCHES = 5;
+
+    // batches < NUM_BATCHES: só lotes até 2^(batches−1) vozes (candidatos do micro‑benchmark)
+    FftwFFT(int n, int freqDist, int threads, bool pairs, int batches = NUM_BATCHES)
+        : RealFFT<T>(n, freqDist), batches(batches) {
+        for (int b = 0; b < batches; ++b) {
+            PlanCache::Key key;
+            key.n        = n;
+            key.howmany  = 1 << b;
+            key.timeDist = n;
+            key.freqDist = freqDist;
+            key.threads  = threads;
+            key.single   = std::is_same<T, float>::value;
+            fwd[b] = PlanCache::acquire(key);
+            key.inverse = true;
+            inv[b] = PlanCache::acquire(key);
+        }
+        if (pairs) {
+            // FFT complexa de N pontos, z -> Z (out‑of‑place)
+            PlanCache::Key key;
+            key.n        = n;
+            key.timeDist = n;
+            key.freqDist = n;
+            key.threads  = threads;
+            key.single   = std::is_same<T, float>::value;
+            key.complex  = true;
+            pairFwd = PlanCache::acquire(key);
+            key.inverse = true;
+            pairInv = PlanCache::acquire(key);
+            z  = Fftw<T>::allocComplex(n);
+            zf = Fftw<T>::allocComplex(n);
+        }
+    }
+
+    ~FftwFFT() override {
+        Fftw<T>::free(z);
+        Fftw<T>::free(zf);
+    }
+
+    void forward(T* time, Complex* freq, int count) override {
+        int v = 0;
+        for (int b = batches - 1; b >= 0; --b)
+            for (const int howmany = 1 << b; v + howmany <= count; v += howmany)
+                Fftw<T>::r2c(fwd[b]->template get<T>(), time + (size_t)v * N, freq + (size_t)v * freqDist);
+    }
+
+    void inverse(Complex* freq, T* time, int count) override {
+        int v = 0;
+        for (int b = batches - 1; b >= 0; --b)
+            for (const int howmany = 1 << b; v + howmany <= count; v += howmany)
+                Fftw<T>::c2r(inv[b]->template get<T>(), freq + (size_t)v * freqDist, time + (size_t)v * N);
+    }
+
+    void forwardPairs(T* a, T* b, Complex* A, Complex* B, int count) override {
+        if (!pairFwd) return RealFFT<T>::forwardPairs(a, b, A, B, count);
+        for (int v = 0; v < count; ++v) {
+            packPair<T>(a + (size_t)v * N, b + (size_t)v * N, z, N);
+            Fftw<T>::c2c(pairFwd->template get<T>(), z, zf);
+            splitPair<T>(zf, A + (size_t)v * freqDist, B + (size_t)v * freqDist, N);
+        }
+    }
+
+    void inversePairs(Complex* A, Complex* B, T* a, T* b, int count) override {
+        if (!pairInv) return RealFFT<T>::inversePairs(A, B, a, b, count);
+        for (int v = 0; v < count; ++v) {
+            mergePair<T>(A + (size_t)v * freqDist, B + (size_t)v * freqDist, zf, N);
+            Fftw<T>::c2c(pairInv->template get<T>(), zf, z);
+            unpackPair<T>(z, a + (size_t)v * N, b + (size_t)v * N, N);
+        }
+    }
+
+    bool plansFinal() const override {
+        for (int b = 0; b < batches; ++b)
+            if (!fwd[b]->isFinal() || !inv[b]->isFinal()) return false;
+        return true;
+    }
+
+private:
+    const int batches;
+    PlanCache::PlanRef fwd[NUM_BATCHES], inv[NUM_BATCHES];
+    PlanCache::PlanRef pairFwd, pairInv;        // two‑for‑one (só com pairs)
+    Complex* z  = nullptr;                      // [N] a + i·b
+    Complex* zf = nullptr;                      // [N] FFT(z)
+};
+
+// FFT real in‑tree, voz a voz
+template <typename T>
+class RadixBackend : public RealFFT<T> {
+public:
+    using typename RealFFT<T>::Complex;
+    using RealFFT<T>::N;
+    using RealFFT<T>::freqDist;
+
+    RadixBackend(int n, int freqDist, bool pairs) : RealFFT<T>(n, freqDist) {
+        fft.setup(n);
+        if (pairs) {
+            pairFft.setup(2 * n);                   // complexFFT de N pontos
+            z = Fftw<T>::allocComplex(n);
+        }
+    }
+
+    ~RadixBackend() override { Fftw<T>::free(z); }
+
+    void forward(T* time, Complex* freq, int count) override {
+        for (int v = 0; v < count; ++v)
+            fft.forward(time + (size_t)v * N, &freq[(size_t)v * freqDist][0]);
+    }
+
+    void inverse(Complex* freq, T* time, int count) override {
+        for (int v = 0; v < count; ++v)
+            fft.inverse(&freq[(size_t)v * freqDist][0], time + (size_t)v * N);
+    }
+
+    void forwardPairs(T* a, T* b, Complex* A, Complex* B, int count) override {
+        if (!z) return RealFFT<T>::forwardPairs(a, b, A, B, count);
+        for (int v = 0; v < count; ++v) {
+            packPair<T>(a + (size_t)v * N, b + (size_t)v * N, z, N);
+            pairFft.complexFFT(&z[0][0], false);
+            splitPair<T>(z, A + (size_t)v * freqDist, B + (size_t)v * freqDist, N);
+        }
+    }
+
+    void inversePairs(Complex* A, Complex* B, T* a, T* b, int count) override {
+        if (!z) return RealFFT<T>::inversePairs(A, B, a, b, count);
+        for (int v = 0; v < count; ++v) {
+            mergePair<T>(A + (size_t)v * freqDist, B + (size_t)v * freqDist, z, N);
+            pairFft.complexFFT(&z[0][0], true);
+            unpackPair<T>(z, a + (size_t)v * N, b + (size_t)v * N, N);
+        }
+    }
+
+private:
+    RadixFFT<T> fft;
+    RadixFFT<T> pairFft;                            // two‑for‑one (só com pairs)
+    Complex* z = nullptr;                           // [N] a + i·b, in‑place
+};
+
+// DFT direta O(N²) (referência para verificação; acumula sempre em double)
+template <typename T>
+class ReferenceDFT : public RealFFT<T> {
+public:
+    using typename RealFFT<T>::Complex;
+    using RealFFT<T>::N;
+    using RealFFT<T>::freqDist;
+
+    ReferenceDFT(int n, int freqDist) : RealFFT<T>(n, freqDist), cosT(n), sinT(n) {
+        for (int i = 0; i < n; ++i) {
+            cosT[i] = std::cos(2.0 * M_PI * i / n);
+            sinT[i] = std::sin(2.0 * M_PI * i / n);
+        }
+    }
+
+    void forward(T* time, Complex* freq, int count) override {
+        for (int v = 0; v < count; ++v) {
+            const T* x = time + (size_t)v * N;
+            Complex* X = freq + (size_t)v * freqDist;
+            for (int k = 0; k <= N / 2; ++k) {
+                double re = 0.0, im = 0.0;
+                for (int n = 0, idx = 0; n < N; ++n, idx = (idx + k) & (N - 1)) {
+                    re += x[n] * cosT[idx];
+                    im -= x[n] * sinT[idx];
+                }
+                X[k][0] = (T)re;
+                X[k][1] = (T)im;
+            }
+        }
+    }
+
+    // x[n] = X0 + (−1)^n·X_{N/2} + 2·Σ Re(X[k]·e^{+2πikn/N}), k = 1..N/2−1
+    void inverse(Complex* freq, T* time, int count) override {
+        for (int v = 0; v < count; ++v) {
+            const Complex* X = freq + (size_t)v * freqDist;
+            T* x = time + (size_t)v * N;
+            for (int n = 0; n < N; ++n) {
+                double acc = (double)X[0][0] + ((n & 1) ? -(double)X[N / 2][0] : (double)X[N / 2][0]);
+                for (int k = 1, idx = n; k < N / 2; ++k, idx = (idx + n) & (N - 1))
+                    acc += 2.0 * ((double)X[k][0] * cosT[idx] - (double)X[k][1] * sinT[idx]);
+                x[n] = (T)acc;
+            }
+        }
+    }
+
+private:
+    std::vector<double> cosT, sinT;
+};
+
+// Candidatos do modo AUTO (a DFT de referência fica de fora)
+constexpr Kind kCandidates[] = { Kind::FFTW, Kind::FFTW_THREADS, Kind::RADIX };
+
+// Candidato do micro‑benchmark: só os planos de 1 voz, os únicos que measure() usa
+template <typename T>
+std::unique_ptr<RealFFT<T>> candidate(Kind kind, int n, int freqDist) {
+    if (kind == Kind::RADIX) return std::make_unique<RadixBackend<T>>(n, freqDist, false);
+    return std::make_unique<FftwFFT<T>>(n, freqDist, kind == Kind::FFTW_THREADS ? 2 : 1, false, 1);
+}
+
+// ns por par forward+inverse de 1 voz: melhor de 5 rondas de ~1 ms
+template <typename T>
+double measure(RealFFT<T>& fft) {
+    using Clock = std::chrono::steady_clock;
+    T* time = Fftw<T>::allocReal(fft.N);
+    typename Fftw<T>::Complex* freq = Fftw<T>::allocComplex(fft.freqDist);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<T> uni(-1, 1);
+    for (int i = 0; i < fft.N; ++i) time[i] = uni(rng);
+
+    fft.forward(time, freq, 1);                 // aquecimento (caches, páginas)
+    fft.inverse(freq, time, 1);
+
+    double best = 1e30;
+    for (int round = 0; round < 5; ++round) {
+        int iters = 0;
+        const auto t0 = Clock::now();
+        std::chrono::duration<double, std::nano> el {};
+        do {
+            fft.forward(time, freq, 1);
+            fft.inverse(freq, time, 1);
+            for (int i = 0; i < fft.N; ++i) time[i] *= T(1) / fft.N;  // mantém a escala
+            ++iters;
+            el = Clock::now() - t0;
+        } while (el.count() < 1e6 && iters < 4096);
+        best = std::min(best, el.count() / iters);
+    }
+    Fftw<T>::free(time);
+    Fftw<T>::free(freq);
+    return best;
+}
+
+} // namespace
+
+template <typename T>
+std::unique_ptr<RealFFT<T>> create(Kind kind, int n, int freqDist, bool pairs) {
+    if (kind == Kind::AUTO) kind = select<T>(n, freqDist).best;
+    switch (kind) {
+        case Kind::FFTW_THREADS: return std::make_unique<FftwFFT<T>>(n, freqDist, 2, pairs);
+        case Kind::RADIX:        return std::make_unique<RadixBackend<T>>(n, freqDist, pairs);
+        case Kind::REFERENCE:    return std::make_unique<ReferenceDFT<T>>(n, freqDist);
+        case Kind::FFTW:
+        default:                 return std::make_unique<FftwFFT<T>>(n, freqDist, 1, pairs);
+    }
+}
+
+template <typename T>
+const Selection& select(int n, int freqDist) {
+    struct Entry {
+        const Selection* sel = nullptr;
+        std::vector<std::unique_ptr<RealFFT<T>>> held;  // candidatos de um resultado provisório
+    };
+    static std::mutex mutex;
+    static std::deque<Selection> results;   // por T; nunca alterados nem movidos: referências válidas
+    static std::map<std::pair<int, int>, Entry> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Provisório: mede de novo só quando os planos FFTW dos candidatos já forem finais
+    Entry& e = cache[{ n, freqDist }];
+    if (e.sel && (!e.sel->provisional ||
+                  !std::all_of(e.held.begin(), e.held.end(), [](const auto& f) { return f->plansFinal(); })))
+        return *e.sel;
+
+    Selection sel;
+    std::vector<std::unique_ptr<RealFFT<T>>> held;
+    double bestNs = 1e30;
+    for (Kind k : kCandidates) {
+        auto fft = candidate<T>(k, n, freqDist);
+        const double ns = measure(*fft);
+        sel.nsPerPair[(int)k] = ns;
+        if (ns < bestNs) { bestNs = ns; sel.best = k; }
+        if (!fft->plansFinal()) {
+            sel.provisional = true;
+            held.push_back(std::move(fft));     // vivos: o PlanCache melhora-os em fundo
+        }
+    }
+    results.push_back(sel);
+    e.sel = &results.back();
+    e.held = std::move(held);
+    return *e.sel;
+}
+
+template std::unique_ptr<RealFFT<double>> create<double>(Kind, int, int, bool);
+template std::unique_ptr<RealFFT<float>>  create<float>(Kind, int, int, bool);
+template const Selection& select<double>(int, int);
+template const Selection& select<float>(int, int);
+
+const char* name(Kind kind) {
+    switch (kind) {
+        case Kind::AUTO:         return "auto";
+        case Kind::FFTW:         return "FFTW";
+        case Kind::FFTW_THREADS: return "FFTW 2 threads";
+        case Kind::RADIX:        return "radix (in-tree)";
+        case Kind::REFERENCE:    return "reference DFT";
+        default:                 return "?";
+    }
+}
+
+} // namespace FFTBackend
@@ -0,0 +1,109 @@
+#pragma once
+#include "FftwTraits.hpp"
+#include <memory>
+#include <cstdint>
+
+/*
+ FFTBackend
+
+ Interface interna para as transformadas reais do STFT, com várias
+ implementações intermutáveis:
+
+    FFTW          : FFTW num só thread (planos do PlanCache).
+    FFTW_THREADS  : FFTW com 2 threads por plano (só compensa para N grande;
+                    com N pequeno a sincronização custa mais do que poupa e
+                    ocupa núcleos que os threads do Rack já usam).
+    RADIX         : FFT real in‑tree (ver RadixFFT.hpp), sem dependências.
+    REFERENCE     : DFT direta O(N²) em double; só para verificação
+                    ('spectrofx-bench --verify-fft'), nunca escolhida em AUTO.
+
+ Precisão
+    RealFFT<T> com T = double (fftw_*) ou float (fftwf_*, pipeline de
+    precisão simples do SpectroEngine). Cada backend existe nas duas
+    precisões; o micro‑benchmark de AUTO é feito por precisão.
+
+ Two‑for‑one (pares de sinais reais)
+    forwardPairs/inversePairs transformam os pares (a[v], b[v]) — no
+    SpectroEngine, a voz v de L com a voz v de R — numa só FFT complexa de
+    N pontos: z = a + i·b, Z = FFT(z) e os dois espectros separados por
+    simetria conjugada, A[k] = (Z[k] + Z*[N−k])/2, B[k] = (Z[k] − Z*[N−k])/2i.
+    No inverso, Z[k] = A[k] + i·B[k] e a = Re(IFFT(Z)), b = Im(IFFT(Z)).
+    Os backends criados com pairs = true (FFTW e radix) preparam a FFT
+    complexa e um rascunho de N complexos (forwardPairs/inversePairs deixam
+    de ser reentrantes); os restantes fazem as duas transformadas reais.
+
+ Convenções (iguais às do FFTW r2c/c2r)
+    - forward: count transformadas de N reais ([count][N]) para N/2+1 bins
+      ([count][freqDist]), sem normalização.
+    - inverse: o inverso, também sem normalização (devolve N·x). A parte
+      imaginária dos bins 0 e N/2 é ignorada. O espectro pode ser destruído.
+    - Buffers alinhados com Fftw<T>::alloc* (requisito do new‑array execute).
+    - Sem alocações nem locks em forward()/inverse().
+
+ Escolha automática (AUTO)
+    select<T>(N) corre, uma vez por N, precisão e processo, um micro‑benchmark curto
+    (forward + inverse de 1 voz) de cada backend candidato e guarda os tempos;
+    o mais rápido é usado pelos Cores seguintes. Os planos FFTW medidos são os
+    do PlanCache: da wisdom, ou ESTIMATE na 1ª sessão. Nesse caso o resultado
+    fica 'provisional' e os candidatos FFTW ficam vivos (o PlanCache melhora
+    os seus planos em fundo); quando esses planos são finais, o select()
+    seguinte mede de novo e os Cores construídos a partir daí usam o novo
+    vencedor.
+ */
+namespace FFTBackend {
+
+enum class Kind : uint8_t { AUTO = 0, FFTW, FFTW_THREADS, RADIX, REFERENCE, NUM_KINDS };
+
+// Transformadas reais em lote para um N e uma distância entre espectros.
+template <typename T>
+class RealFFT {
+public:
+    using Complex = typename Fftw<T>::Complex;
+
+    RealFFT(int n, int freqDist) : N(n), freqDist(freqDist) {}
+    virtual ~RealFFT() = default;
+
+    RealFFT(const RealFFT&) = delete;
+    RealFFT& operator=(const RealFFT&) = delete;
+
+    virtual void forward(T* time, Complex* freq, int count) = 0;
+    virtual void inverse(Complex* freq, T* time, int count) = 0;
+
+    // 'count' pares: a/b [count][N] <-> A/B [count][freqDist] (por omissão, como 2 lotes reais)
+    virtual void forwardPairs(T* a, T* b, Complex* A, Complex* B, int count) {
+        forward(a, A, count);
+        forward(b, B, count);
+    }
+    virtual void inversePairs(Complex* A, Complex* B, T* a, T* b, int count) {
+        inverse(A, a, count);
+        inverse(B, b, count);
+    }
+
+    // Planos definitivos (FFTW: já FFTW_PATIENT); backends sem planos: sempre
+    virtual bool plansFinal() const { return true; }
+
+    const int N;            // tamanho da transformada (tempo: distância entre transformadas)
+    const int freqDist;     // distância entre espectros (complexos, ≥ N/2+1)
+};
+
+// Resultado do micro‑benchmark para um N e uma precisão.
+struct Selection {
+    Kind best = Kind::FFTW;
+    double nsPerPair[(int)Kind::NUM_KINDS] = {};    // forward+inverse de 1 voz (0 = não medido)
+    bool provisional = false;   // FFTW medido com planos ainda não finais (refeito por select())
+};
+
+// Cria um backend concreto (AUTO resolve com select()). Fora do thread de áudio.
+// T = double ou float (instanciados em FFTBackend.cpp). pairs: prepara o two‑for‑one.
+template <typename T>
+std::unique_ptr<RealFFT<T>> create(Kind kind, int n, int freqDist, bool pairs = false);
+
+// Micro‑benchmark dos candidatos para N (em cache por processo, refeito se provisório; thread‑safe).
+// A referência devolvida fica válida até ao fim do processo.
+template <typename T>
+const Selection& select(int n, int freqDist);
+
+// Nome curto para menus e relatórios.
+const char* name(Kind kind);
+
+} // namespace FFTBackend
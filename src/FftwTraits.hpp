@@ -0,0 +1,75 @@
+#pragma once
+#include <fftw3.h>
+#include <cstddef>
+
+/*
+ FftwTraits
+
+ API FFTW por precisão: Fftw<double> -> fftw_* (libfftw3), Fftw<float> ->
+ fftwf_* (libfftw3f). Permite escrever o PlanCache, os backends FFT e o
+ pipeline do SpectroEngine uma só vez, como templates sobre o tipo de
+ amostra.
+
+ As duas bibliotecas são independentes: cada uma tem o seu planeador (não
+ thread‑safe) e a sua wisdom.
+ */
+template <typename T> struct Fftw;
+
+template <> struct Fftw<double> {
+    using Complex = fftw_complex;
+    using Plan    = fftw_plan;
+
+    static double*  allocReal(size_t n)    { return fftw_alloc_real(n); }
+    static Complex* allocComplex(size_t n) { return fftw_alloc_complex(n); }
+    static void     free(void* p)          { fftw_free(p); }
+
+    // Lote de 'howmany' transformadas 1D de N pontos, contíguas (stride 1)
+    static Plan planR2C(int n, int howmany, double* in, int idist, Complex* out, int odist, unsigned flags) {
+        return fftw_plan_many_dft_r2c(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+    }
+    static Plan planC2R(int n, int howmany, Complex* in, int idist, double* out, int odist, unsigned flags) {
+        return fftw_plan_many_dft_c2r(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+    }
+    static Plan planC2C(int n, int howmany, Complex* in, int idist, Complex* out, int odist, int sign, unsigned flags) {
+        return fftw_plan_many_dft(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, sign, flags);
+    }
+    static void r2c(Plan p, double* in, Complex* out) { fftw_execute_dft_r2c(p, in, out); }
+    static void c2r(Plan p, Complex* in, double* out) { fftw_execute_dft_c2r(p, in, out); }
+    static void c2c(Plan p, Complex* in, Complex* out) { fftw_execute_dft(p, in, out); }
+    static void destroy(Plan p)                       { fftw_destroy_plan(p); }
+
+    static void initThreads()            { fftw_init_threads(); }
+    static void planWithThreads(int n)   { fftw_plan_with_nthreads(n); }
+    static void setTimeLimit(double s)   { fftw_set_timelimit(s); }
+    static int  exportWisdom(const char* file) { return fftw_export_wisdom_to_filename(file); }
+    static int  importWisdom(const char* file) { return fftw_import_wisdom_from_filename(file); }
+};
+
+template <> struct Fftw<float> {
+    using Complex = fftwf_complex;
+    using Plan    = fftwf_plan;
+
+    static float*   allocReal(size_t n)    { return fftwf_alloc_real(n); }
+    static Complex* allocComplex(size_t n) { return fftwf_alloc_complex(n); }
+    static void     free(void* p)          { fftwf_free(p); }
+
+    static Plan planR2C(int n, int howmany, float* in, int idist, Complex* out, int odist, unsigned flags) {
+        return fftwf_plan_many_dft_r2c(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+    }
+    static Plan planC2R(int n, int howmany, Complex* in, int idist, float* out, int odist, unsigned flags) {
+        return fftwf_plan_many_dft_c2r(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+    }
+    static Plan planC2C(int n, int howmany, Complex* in, int idist, Complex* out, int odist, int sign, unsigned flags) {
+        return fftwf_plan_many_dft(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, sign, flags);
+    }
+    static void r2c(Plan p, float* in, Complex* out) { fftwf_execute_dft_r2c(p, in, out); }
+    static void c2r(Plan p, Complex* in, float* out) { fftwf_execute_dft_c2r(p, in, out); }
+    static void c2c(Plan p, Complex* in, Complex* out) { fftwf_execute_dft(p, in, out); }
+    static void destroy(Plan p)                      { fftwf_destroy_plan(p); }
+
+    static void initThreads()            { fftwf_init_threads(); }
+    static void planWithThreads(int n)   { fftwf_plan_with_nthreads(n); }
+    static void setTimeLimit(double s)   { fftwf_set_timelimit(s); }
+    static int  exportWisdom(const char* file) { return fftwf_export_wisdom_to_filename(file); }
+    static int  importWisdom(const char* file) { return fftwf_import_wisdom_from_filename(file); }
+};
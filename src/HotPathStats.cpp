@@ -0,0 +1,105 @@
+#include "HotPathStats.hpp"
+#include <cstdio>
+
+const char* HotPathStats::kindName(int kind) {
+    static const char* names[NUM_KINDS] = { "window", "fft", "analyze", "effects", "synth", "ifft", "ola", "hop", "sample" };
+    return kind >= 0 && kind < NUM_KINDS ? names[kind] : "?";
+}
+
+HotPathStats::HotPathStats() : ticks0(now()), clock0(std::chrono::steady_clock::now()) {}
+
+void HotPathStats::clear() {
+    for (Histogram& h : hist) h.clear();
+}
+
+// Só com a captura parada: o áudio não toca no buffer fora de ARMED
+bool HotPathStats::armCapture(size_t events) {
+    if (capturing() || events == 0) return false;
+    trace.assign(events, Event {});
+    traceCount = 0;
+    traceState.store(ARMED, std::memory_order_release);
+    return true;
+}
+
+double HotPathStats::nsPerTick() const {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    const uint64_t ticks = now() - ticks0;
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - clock0).count();
+    return ticks > 0 && ns > 0.0 ? ns / (double)ticks : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+// Eventos "X" (início + duração, µs desde o 1º evento), um por linha
+bool HotPathStats::writeChromeTrace(const std::string& path, std::string* err) {
+    if (!captureDone()) { if (err) *err = "no finished capture"; return false; }
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) { if (err) *err = "cannot write " + path; return false; }
+    const double usPerTick = nsPerTick() * 1e-3;
+    const uint64_t origin = traceCount ? trace[0].start : 0;
+    std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"hop L\"}},\n");
+    std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"hop R\"}},\n");
+    std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"process()\"}}");
+    for (size_t i = 0; i < traceCount; ++i) {
+        const Event& e = trace[i];
+        std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", kindName(e.kind),
+                     e.kind == SAMPLE ? 2 : e.side, (double)(e.start - origin) * usPerTick, e.dur * usPerTick);
+    }
+    std::fprintf(f, "\n]}\n");
+    const bool ok = std::fclose(f) == 0;
+    if (!ok && err) *err = "error writing " + path;
+    return ok;
+}
+
+// p50/p99 da diferença entre contagens (meio do balde), máx exato da janela
+bool HotPathStats::View::update(HotPathStats& s, double period) {
+    const auto t = std::chrono::steady_clock::now();
+    const double dt = std::chrono::duration<double>(t - last).count();
+    if (valid && dt < period) return false;
+    const bool first = prev.empty() || last == std::chrono::steady_clock::time_point {};
+
+    constexpr int B = Histogram::BUCKETS;
+    std::vector<uint32_t> cur((size_t)NUM_KINDS * B);
+    const double nsPerTick = s.nsPerTick();
+    for (int k = 0; k < NUM_KINDS; ++k) {
+        Histogram& h = s.histogram(k);
+        uint32_t* c = &cur[(size_t)k * B];
+        h.snapshot(c);
+        const uint64_t peak = h.takePeak();
+        if (first) continue;
+
+        const uint32_t* p = &prev[(size_t)k * B];
+        Row& r = rows[k];
+        const uint64_t total = r.missesTotal;
+        r = Row {};
+        uint64_t n = 0;
+        for (int i = 0; i < B; ++i) {
+            const uint32_t d = c[i] - p[i];
+            n += d;
+            if (budgetNs[k] > 0.0 && Histogram::bucketLow(i) * nsPerTick >= budgetNs[k]) r.misses += d;
+        }
+        r.missesTotal = total + r.misses;
+        r.count = n;
+        r.rate  = n / dt;
+        r.max   = peak * nsPerTick;
+        if (n == 0) continue;
+        const uint64_t at50 = (n + 1) / 2, at99 = n - n / 100;
+        uint64_t acc = 0;
+        for (int i = 0; i < B; ++i) {
+            const uint32_t d = c[i] - p[i];
+            if (!d) continue;
+            const double mid = (Histogram::bucketLow(i) + 0.5 * (Histogram::bucketWidth(i) - 1.0)) * nsPerTick;
+            if (acc < at50 && acc + d >= at50) r.p50 = mid;
+            if (acc < at99 && acc + d >= at99) { r.p99 = mid; break; }
+            acc += d;
+        }
+        r.p50 = std::min(r.p50, r.max);
+        r.p99 = std::min(r.p99, r.max);
+    }
+    prev.swap(cur);
+    last = t;
+    valid = !first;
+    return valid;
+}
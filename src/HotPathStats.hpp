@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ HotPathStats
+
+ Instrumentação do caminho de áudio de uma instância: histogramas lock‑free
+ do tempo de cada estágio do hop, do hop inteiro e de cada chamada de
+ SpectroFXModule::process(), e captura de uma linha temporal (Chrome trace /
+ Perfetto) a pedido.
+
+ Compilação
+    - Só é ligada com -DSPECTROFX_PROFILE=1 ('make PROFILE=1'). Sem ela as
+      macros SFX_PROFILE_* não geram código e o motor não tem o membro
+      stats(): zero custo no build normal. A classe em si compila sempre
+      (o bench testa os histogramas), mas só o motor instrumentado a usa.
+
+ Medição
+    - Relógio: contador de ciclos (rdtsc) em x86, steady_clock noutras
+      arquiteturas. Ticks -> ns por calibração contra o steady_clock entre a
+      construção e a leitura (View), sem bloquear nenhum thread.
+    - Scope (RAII) mede um estágio, um hop (soma dos seus estágios, que em
+      SPREAD se repartem por várias amostras) ou uma amostra.
+
+ Segurança de threads
+    - Um só escritor (thread de áudio) por instância: contadores atómicos
+      com load+store relaxed (sem RMW). A UI lê a qualquer momento; um valor
+      pode vir um incremento atrasado, nunca corrompido.
+    - O máximo de cada janela é lido com exchange(0) pela UI: um máximo
+      escrito ao mesmo tempo pode perder‑se (só afeta essa janela).
+    - Trace: a UI reserva o buffer e arma a captura; o áudio preenche‑o e
+      marca DONE quando cheio; só então a UI o lê (handoff acquire/release).
+ */
+struct HotPathStats {
+    // Kinds medidos: os 7 estágios do hop (ordem de SpectroEngine::Stage), o hop e a amostra
+    enum Kind : uint8_t { WINDOW = 0, FFT, ANALYZE, EFFECTS, SYNTH, IFFT, OLA, HOP, SAMPLE, NUM_KINDS };
+    static const char* kindName(int kind);
+
+    static inline uint64_t now() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /*
+    Histograma log‑linear de durações em ticks: 8 sub‑baldes por oitava
+    (erro relativo ≤ 12.5%), valores < 8 exatos. 1 escritor, N leitores.
+    */
+    class Histogram {
+    public:
+        static constexpr int SUB = 8;
+        static constexpr int BUCKETS = 62 * SUB;
+
+        static inline int bucketOf(uint64_t v) {
+            if (v < SUB) return (int)v;
+            const int e = 63 - __builtin_clzll(v);             // ≥ 3
+            return (e - 2) * SUB + (int)((v >> (e - 3)) & (SUB - 1));
+        }
+        // Limite inferior do balde i (o valor representativo é o meio: ver View)
+        static inline double bucketLow(int i) {
+            if (i < SUB) return i;
+            const int e = i / SUB + 2;
+            return (double)((uint64_t)(SUB + i % SUB) << (e - 3));
+        }
+        static inline double bucketWidth(int i) {
+            return i < SUB ? 1.0 : (double)(1ull << (i / SUB - 1));
+        }
+
+        // Áudio
+        inline void add(uint64_t ticks) {
+            std::atomic<uint32_t>& c = counts[bucketOf(ticks)];
+            c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (ticks > peak.load(std::memory_order_relaxed)) peak.store(ticks, std::memory_order_relaxed);
+        }
+
+        // UI
+        void snapshot(uint32_t* out) const {
+            for (int i = 0; i < BUCKETS; ++i) out[i] = counts[i].load(std::memory_order_relaxed);
+        }
+        uint64_t takePeak() { return peak.exchange(0, std::memory_order_relaxed); }
+        void clear() {
+            for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+            peak.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<uint32_t> counts[BUCKETS] = {};
+        std::atomic<uint64_t> peak { 0 };
+    };
+
+    // Evento da linha temporal (ticks absolutos)
+    struct Event {
+        uint64_t start;
+        uint32_t dur;
+        uint8_t kind;
+        uint8_t side;
+    };
+
+    HotPathStats();
+
+    // ---- Áudio ------------------------------------------------------------
+
+    // Mede o scope e regista‑o (estágio: também no hop do lado; OLA fecha o hop)
+    struct Scope {
+        HotPathStats& s;
+        uint64_t t0;
+        uint8_t kind, side;
+        Scope(HotPathStats& stats, int k, int sd) : s(stats), t0(now()), kind((uint8_t)k), side((uint8_t)sd) {}
+        ~Scope() { s.end(kind, side, t0, now()); }
+    };
+
+    inline void end(int kind, int side, uint64_t t0, uint64_t t1) {
+        const uint64_t dur = t1 - t0;
+        hist[kind].add(dur);
+        if (kind < HOP) {
+            hopTicks[side] += dur;
+            if (kind == OLA) { hist[HOP].add(hopTicks[side]); hopTicks[side] = 0; }
+        }
+        if (traceState.load(std::memory_order_acquire) == ARMED) {
+            trace[traceCount++] = Event { t0, (uint32_t)std::min<uint64_t>(dur, UINT32_MAX), (uint8_t)kind, (uint8_t)side };
+            if (traceCount == trace.size()) traceState.store(DONE, std::memory_order_release);
+        }
+    }
+
+    // ---- UI ---------------------------------------------------------------
+
+    Histogram& histogram(int kind) { return hist[kind]; }
+    void clear();                           // zera os histogramas (contagens em voo podem sobreviver)
+
+    /*
+    Trace: armCapture(n) reserva n eventos e arma a captura (ignorado com
+    uma em curso); captureDone() diz quando o buffer encheu e
+    writeChromeTrace() grava‑o em JSON (chrome://tracing, ui.perfetto.dev),
+    com um 'tid' por lado (0 = L, 1 = R) e as amostras em 'tid' 2.
+    */
+    bool armCapture(size_t events);
+    bool capturing() const { return traceState.load(std::memory_order_acquire) == ARMED; }
+    bool captureDone() const { return traceState.load(std::memory_order_acquire) == DONE; }
+    bool writeChromeTrace(const std::string& path, std::string* err = nullptr);
+
+    // Ticks -> ns (calibrado desde a construção; 1 sem rdtsc)
+    double nsPerTick() const;
+
+    /*
+    Janela de estatísticas (UI): update() a cada ≥ 'period' s compara as
+    contagens com as da janela anterior e guarda p50/p99/máx (ns) e taxa
+    (eventos/s) de cada kind nessa janela. Com budgetNs[kind] > 0 conta
+    também os eventos acima do prazo (falhas: na janela e desde reset();
+    pelo limite inferior do balde, nunca a mais).
+    */
+    struct View {
+        struct Row {
+            double p50 = 0.0, p99 = 0.0, max = 0.0, rate = 0.0;
+            uint64_t count = 0;
+            uint64_t misses = 0, missesTotal = 0;
+        };
+        Row rows[NUM_KINDS];
+        double budgetNs[NUM_KINDS] = {};
+        bool valid = false;
+
+        bool update(HotPathStats& s, double period = 1.0);
+        void reset() { valid = false; last = {}; for (Row& r : rows) r = Row {}; }
+
+    private:
+        std::chrono::steady_clock::time_point last {};
+        std::vector<uint32_t> prev;         // [NUM_KINDS][BUCKETS]
+    };
+
+private:
+    enum : int { IDLE = 0, ARMED, DONE };
+
+    Histogram hist[NUM_KINDS];
+    uint64_t hopTicks[2] = {};              // hop em curso de cada lado (só áudio)
+
+    std::vector<Event> trace;               // reservado pela UI; escrito pelo áudio em ARMED
+    size_t traceCount = 0;
+    std::atomic<int> traceState { IDLE };
+
+    uint64_t ticks0 = 0;                    // calibração: par (ticks, steady_clock) inicial
+    std::chrono::steady_clock::time_point clock0;
+};
+
+// Macros de instrumentação: sem SPECTROFX_PROFILE não geram código (nem avaliam os argumentos)
+#ifndef SPECTROFX_PROFILE
+#define SPECTROFX_PROFILE 0
+#endif
+
+#if SPECTROFX_PROFILE
+#define SFX_PROFILE_CONCAT_(a, b) a##b
+#define SFX_PROFILE_CONCAT(a, b) SFX_PROFILE_CONCAT_(a, b)
+#define SFX_PROFILE_SCOPE(stats, kind, side) HotPathStats::Scope SFX_PROFILE_CONCAT(sfxProfile_, __LINE__)((stats), (kind), (side))
+#else
+#define SFX_PROFILE_SCOPE(stats, kind, side) ((void)0)
+#endif
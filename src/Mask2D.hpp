@@ -3,66 +3,162 @@
 #include <atomic>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 
 /*
  Mask2D
- 
+
  Máscara 2D leve para aplicar/pesar efeitos espectrais por bin e por coluna
- do espectrograma. É desenhada no thread de UI (em 'back') e lida no thread
- de áudio (a partir de 'front'), com troca lock‑free por flag 'dirty'.
- 
+ do espectrograma. É editada no thread de UI e lida no thread de áudio, com
+ troca lock‑free por triple buffer.
+
  Convenções
     - HIST  : nº de colunas (histórico temporal do espectrograma).
     - K     : nº de bins (frequências, N/2+1).
     - 'head': índice (ring) da coluna mais recente.
- 
- Segurança de threads
-    - A UI escreve apenas em 'back' e depois chama 'markDirty()'.
-    - O áudio chama 'swapIfDirty()' no início do frame para copiar 'back->front'.
-    - 'std::atomic' protege apenas os índices/flags; os buffers usam cópia inteira (custo baixo para HIST≈256 e K≈513 ≈ 130k floats).
+
+ Armazenamento
+    - 3 estados (State): pesos [HIST][stride] contíguos num só bloco
+      alinhado a 64 B (stride = K arredondado a 16 floats, cada coluna numa
+      linha de cache própria) + limites [lowBin, highBin] + enabled.
+    - Pesos em [0, 1], 1 por omissão (efeito inteiro). A UI pinta‑os com um
+      pincel com feather (paint()): várias regiões, qualquer forma.
+    - Os limites e o 'enabled' viajam com os pesos: o áudio vê sempre um
+      estado completo, nunca um par lowBin/highBin a meio de uma escrita.
+
+ Segurança de threads (triple buffer)
+    - A UI edita o seu estado ('edit()', setBounds(), setEnabled(), clear())
+      e publica‑o com 'publish()': uma troca atómica com o estado do meio,
+      seguida de uma cópia (no thread de UI) do estado publicado para o novo
+      estado de edição, para que as edições seguintes partam dele.
+    - O áudio chama 'acquire()' no início do hop: se houver estado novo,
+      troca o seu pelo do meio com um só exchange (sem cópia nem alocação).
+      'current()' devolve o estado adquirido.
+    - Só a UI escreve; o áudio só lê. O estado que a UI copia depois de
+      publicar nunca é escrito por ninguém enquanto é lido.
  */
 struct Mask2D {
-    // Dimensões (configuráveis via setup())
-    int HIST = 256;   // nº de colunas (tempo)
-    int K    = 513;   // nº de bins (freq)
+    // Estado completo de uma máscara (pesos + limites)
+    struct State {
+        float* weights = nullptr;   // [HIST][stride], ver column()
+        int  lowBin  = 0;           // bin mínimo ativo
+        int  highBin = 0;           // bin máximo ativo
+        bool enabled = true;        // máscara ativa/inativa
 
-    // Buffers (UI -> Back; DSP -> Front)
-    std::vector<std::vector<float>> front; // [HIST][K]
-    std::vector<std::vector<float>> back;  // [HIST][K]
+        float*       column(int col, int stride)       { return weights + (size_t)col * stride; }
+        const float* column(int col, int stride) const { return weights + (size_t)col * stride; }
+    };
 
-    // Estado 
-    std::atomic<bool> dirty {false};   // back foi modificado pela UI
-    std::atomic<int>  head  {0};       // coluna mais recente (ring)
-    std::atomic<int>  lowBin  {0};     // bin mínimo ativo    
-    std::atomic<int>  highBin {512};   // bin máximo ativo
-    std::atomic<bool> enabled {true};  // máscara ativa/inativa
+    // Dimensões (configuráveis via setup())
+    int HIST   = 256;   // nº de colunas (tempo)
+    int K      = 513;   // nº de bins (freq)
+    int stride = 528;   // floats por coluna (K arredondado a 16 -> 64 B)
+
+    std::atomic<int> head {0};      // coluna mais recente (ring; escrita pela UI)
 
-    /** Inicializa dimensões e limpa buffers/estado. */
+    /** Inicializa dimensões e limpa os 3 estados (fora do thread de áudio). */
     void setup(int hist, int k) {
-        HIST = hist; K = k;                             // dimensões
-        front.assign(HIST, std::vector<float>(K, 0.f)); // limpa
-        back  = front;                                  // limpa                          
-        head.store(HIST - 1);                           // início (última coluna)
-        lowBin.store(0);                                // todo o espectro
-        highBin.store(K - 1);                           // todo o espectro
-        enabled.store(true);                            // máscara ativa
-        dirty.store(false);                             // limpa flag  
+        HIST = hist; K = k;
+        stride = (K + 15) & ~15;
+        const size_t perState = (size_t)HIST * stride;
+        storage.assign(3 * perState + 16, 1.f);                     // +16: folga para alinhar a 64 B
+        float* base = storage.data();
+        base += ((64 - (uintptr_t)base % 64) % 64) / sizeof(float);
+        for (int i = 0; i < 3; ++i) {
+            State& s = states[i];
+            s.weights = base + i * perState;
+            s.lowBin  = 0;                                          // todo o espectro
+            s.highBin = K - 1;
+            s.enabled = true;                                       // máscara ativa
+        }
+        back  = 0;
+        front = 1;
+        published_ = 0;
+        shared.store(2, std::memory_order_relaxed);                 // sem estado novo
+        head.store(HIST - 1);                                       // início (última coluna)
+    }
+
+    // ---- UI ---------------------------------------------------------------
+
+    // Estado em edição (só UI). Publicar com publish().
+    State&       edit()       { return states[back]; }
+    const State& edit() const { return states[back]; }
+
+    /*
+    Publica o estado em edição (só UI). O áudio adota‑o no próximo acquire();
+    a edição continua sobre uma cópia dele.
+    */
+    void publish() {
+        const int published = back;
+        back = shared.exchange(published | DIRTY, std::memory_order_acq_rel) & INDEX;
+        copyState(states[published], states[back]);
+        ++published_;
     }
 
-    /* UI -> marcar sujo após escrever em 'back'. */
-    inline void markDirty() { dirty.store(true, std::memory_order_release); }
+    // Nº de publicações desde setup() (só UI; p.ex. para saber se a vista está em dia)
+    int version() const { return published_; }
+
+    // Limites (ordenados e limitados a [0, K−1]) e ativação, publicados já
+    void setBounds(int lo, int hi) {
+        lo = std::clamp(lo, 0, K-1); hi = std::clamp(hi, 0, K-1);
+        if (lo > hi) std::swap(lo, hi);
+        edit().lowBin = lo; edit().highBin = hi;
+        publish();
+    }
+    void setEnabled(bool on) { edit().enabled = on; publish(); }
+
+    // Preenche todos os pesos com 'value' e publica
+    void clear(float value) {
+        std::fill_n(edit().weights, (size_t)HIST * stride, value);
+        publish();
+    }
 
     /*
-    Áudio thread: copiar back->front (sem locks) apenas quando sujo.
-    Usa 'exchange' para limpar a flag de forma atómica.
+    Pincel (só UI, sem publicar): pinta o peso 'amount' na coluna 'col' do
+    ring, bins [k0, k1], com 'falloff(k)' ∈ [0, 1] (feather). amount = 1
+    aplica (máximo), amount = 0 apaga (mínimo).
     */
-    inline void swapIfDirty() {
-        if (dirty.exchange(false, std::memory_order_acq_rel)) {
-            // HIST×K — custo reduzido (≈130k floats com HIST=256, K≈513).
-            front = back;
+    template <typename Falloff>
+    void paint(int col, int k0, int k1, float amount, Falloff&& falloff) {
+        float* w = edit().column(((col % HIST) + HIST) % HIST, stride);
+        k0 = std::max(k0, 0); k1 = std::min(k1, K - 1);
+        for (int k = k0; k <= k1; ++k) {
+            const float f = std::clamp(falloff(k), 0.f, 1.f);
+            w[k] = amount > 0.5f ? std::max(w[k], f) : std::min(w[k], 1.f - f);
         }
     }
 
+    // Vista da UI (estado em edição = último publicado + edições por publicar)
+    int  lowBin()  const { return edit().lowBin; }
+    int  highBin() const { return edit().highBin; }
+    bool enabled() const { return edit().enabled; }
+
+    // ---- Áudio ------------------------------------------------------------
+
+    // Adota o último estado publicado, se houver (um exchange; sem cópia nem alocação)
+    const State& acquire() {
+        if (shared.load(std::memory_order_relaxed) & DIRTY)
+            front = shared.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return states[front];
+    }
+
+    // Estado adquirido pelo áudio
+    const State& current() const { return states[front]; }
+
+    /*
+    Novo Core (thread de áudio, antes de o publicar à UI): herda limites
+    (reescalados para o novo K) e ativação do estado que o áudio usava.
+    Os pesos recomeçam a 1 (outro K).
+    */
+    void inherit(const Mask2D& old) {
+        const State& o = old.current();
+        const double scale = (double)(K - 1) / (old.K - 1);
+        int lo = std::clamp((int)std::lround(o.lowBin * scale), 0, K - 1);
+        int hi = std::clamp((int)std::lround(o.highBin * scale), 0, K - 1);
+        for (State& s : states) { s.lowBin = lo; s.highBin = hi; s.enabled = o.enabled; }
+        head.store(old.head.load());
+    }
+
     // Avança "head" (chamar 1× por frame). Retorna o novo valor.
     inline int advanceHead() {
         int h = head.load(std::memory_order_relaxed);
@@ -72,27 +168,35 @@ struct Mask2D {
     }
 
     /*
-    Peso da máscara para (coluna atual, bin k) respeitando limites.
-    Retorna 0 fora de [lowBin, highBin], clamp [0..1] no interior.
+    Pesos por bin do estado do áudio na coluna atual (head), para um hop:
+    0 fora de [lowBin, highBin], pesos pintados (clamp [0..1]) no interior;
+    máscara desligada -> 1 em todos. out[K].
     */
-    inline float weightNow(int k) const {
-        int h = head.load(std::memory_order_relaxed);
-        int lo = lowBin.load(std::memory_order_relaxed);
-        int hi = highBin.load(std::memory_order_relaxed);
-        if (k < lo || k > hi) return 0.f;
-        return std::clamp(front[h][k], 0.f, 1.f);
+    inline void weightsNow(float* out) const {
+        const State& s = current();
+        if (!s.enabled) { std::fill_n(out, K, 1.f); return; }
+        const float* col = s.column(head.load(std::memory_order_relaxed), stride);
+        for (int k = 0; k < K; ++k)
+            out[k] = (k < s.lowBin || k > s.highBin) ? 0.f : std::clamp(col[k], 0.f, 1.f);
     }
 
-    // Utilitários de UI
-    inline void clearBack(float value) {    // limpa 'back' para um valor
-        for (auto& col : back) std::fill(col.begin(), col.end(), value);
-        markDirty();
-    }
-    // Definir peso na coluna atual (head) para todos os bins
-    inline void setBounds(int lo, int hi) {  // definir limites (UI)
-        lo = std::clamp(lo, 0, K-1); hi = std::clamp(hi, 0, K-1);       
-        if (lo > hi) std::swap(lo, hi);     
-        lowBin.store(lo); highBin.store(hi);      
+    /*
+    Os mesmos pesos noutra resolução (bins < K, p.ex. o Core dos agudos do modo
+    multi‑resolução): out[j] = média dos pesos dos bins de K que o bin j cobre.
+    */
+    inline void weightsNow(float* out, int bins) const {
+        const State& s = current();
+        if (!s.enabled) { std::fill_n(out, bins, 1.f); return; }
+        const float* col = s.column(head.load(std::memory_order_relaxed), stride);
+        const double r = (double)(K - 1) / (bins - 1);
+        for (int j = 0; j < bins; ++j) {
+            const int k0 = std::max(0, (int)std::lround((j - 0.5) * r));
+            const int k1 = std::max(k0, std::min(K - 1, (int)std::lround((j + 0.5) * r) - 1));
+            float sum = 0.f;
+            for (int k = k0; k <= k1; ++k)
+                sum += (k < s.lowBin || k > s.highBin) ? 0.f : std::clamp(col[k], 0.f, 1.f);
+            out[j] = sum / (k1 - k0 + 1);
+        }
     }
 
     /*
@@ -103,4 +207,22 @@ struct Mask2D {
         int h = head.load(std::memory_order_relaxed);           // coluna mais recente
         return (h - (HIST - 1 - displayCol) + HIST) % HIST;     // ring
     }
+
+private:
+    static constexpr int INDEX = 3;     // índice do estado do meio
+    static constexpr int DIRTY = 4;     // estado do meio ainda não adquirido pelo áudio
+
+    void copyState(const State& from, State& to) const {
+        std::copy_n(from.weights, (size_t)HIST * stride, to.weights);
+        to.lowBin  = from.lowBin;
+        to.highBin = from.highBin;
+        to.enabled = from.enabled;
+    }
+
+    std::vector<float> storage;         // 3 × [HIST][stride] (+ alinhamento)
+    State states[3];
+    int back  = 0;                      // estado em edição (só UI)
+    int published_ = 0;                 // nº de publish() (só UI)
+    int front = 1;                      // estado em uso (só áudio)
+    std::atomic<int> shared {2};        // estado do meio | DIRTY
 };
@@ -0,0 +1,91 @@
+#pragma once
+#include "FftwTraits.hpp"
+#include <algorithm>
+#include <cstdint>
+
+/*
+ MirrorRing
+
+ Buffer circular de C canais indexado pelo instante absoluto t, com tamanho
+ potência de 2 (posição = t & (size−1), sem divisões) e espelho: cada canal
+ tem size + span amostras e as span primeiras posições repetem‑se a seguir
+ à última. Qualquer janela de até span amostras, a começar em qualquer
+ instante, é assim um bloco contíguo (at()), e os laços de janela e de
+ overlap‑add ficam sem máscara por amostra (vetorizáveis).
+
+ Convenções
+    - Posições canónicas em [0, size); o espelho [size, size + span) é
+      cópia (entrada) ou transbordo (acumulação) das span primeiras.
+    - Entrada amostra a amostra: write() escreve também a cópia no
+      espelho, logo at(ch, t)[0..span) lê sempre valores atuais.
+    - Acumulação (OLA): soma‑se em at(ch, t)[0..n) e fold(ch, t, n) devolve
+      a parte que caiu no espelho ao início do canal (e zera‑a); a leitura
+      é por take(), que lê e zera n posições canónicas (até 2 troços).
+    - Canais contíguos (stride = size + span, múltiplo de 16), memória de
+      fftw*_alloc (alinhada) reservada em setup(), fora do thread de áudio.
+ */
+template <typename T>
+class MirrorRing {
+public:
+    MirrorRing() = default;
+    MirrorRing(const MirrorRing&) = delete;
+    MirrorRing& operator=(const MirrorRing&) = delete;
+    ~MirrorRing() { Fftw<T>::free(buf); }
+
+    // C canais; size potência de 2 ≥ span (janela contígua máxima). Tudo a zero.
+    void setup(int channels, int size, int span) {
+        Fftw<T>::free(buf);
+        C = channels;
+        mask = size - 1;
+        window = span;
+        stride = (size + span + 15) & ~15;
+        buf = Fftw<T>::allocReal((size_t)C * stride);
+        std::fill_n(buf, (size_t)C * stride, T(0));
+    }
+
+    int size() const { return mask + 1; }
+    int span() const { return window; }
+
+    // Janela contígua de span amostras a começar no instante t
+    T* at(int ch, uint64_t t) { return buf + (size_t)ch * stride + (t & mask); }
+    const T* at(int ch, uint64_t t) const { return buf + (size_t)ch * stride + (t & mask); }
+
+    // Posição canónica do instante t (acesso amostra a amostra)
+    T& operator()(int ch, uint64_t t) { return buf[(size_t)ch * stride + (t & mask)]; }
+
+    // Entrada: amostra t (e a sua cópia no espelho)
+    void write(int ch, uint64_t t, T x) {
+        T* row = buf + (size_t)ch * stride;
+        const int i = (int)(t & mask);
+        row[i] = x;
+        if (i < window) row[mask + 1 + i] = x;
+    }
+
+    // Acumulação: depois de somar em at(ch, t)[0..n), passa o transbordo para o início
+    void fold(int ch, uint64_t t, int n) {
+        T* row = buf + (size_t)ch * stride;
+        const int i = (int)(t & mask), over = i + n - (mask + 1);
+        if (over <= 0) return;
+        T* spill = row + mask + 1;
+        for (int k = 0; k < over; ++k) row[k] += spill[k];
+        std::fill_n(spill, over, T(0));
+    }
+
+    // Lê (convertido para U) e zera as n posições canónicas a partir do instante t
+    template <typename U>
+    void take(int ch, uint64_t t, int n, U* out) {
+        T* row = buf + (size_t)ch * stride;
+        const int i = (int)(t & mask), first = std::min(n, mask + 1 - i);
+        for (int k = 0; k < first; ++k) out[k] = (U)row[i + k];
+        for (int k = first; k < n; ++k) out[k] = (U)row[k - first];
+        std::fill_n(row + i, first, T(0));
+        std::fill_n(row, n - first, T(0));
+    }
+
+    // Zera um canal (posições e espelho)
+    void clear(int ch) { std::fill_n(buf + (size_t)ch * stride, stride, T(0)); }
+
+private:
+    T* buf = nullptr;                       // [C][stride]
+    int C = 0, mask = 0, window = 0, stride = 0;
+};
@@ -1,116 +1,251 @@
 #include "PhaseEngine.hpp"
 
-// Inicializa estrutura interna (numCh canais, K bins, hop H).
-void PhaseEngine::setup(int numCh, int bins, int hop) {
-    channels = numCh;   // nº de canais (1 ou 2)
-    K        = bins;    // nº de bins (N/2 + 1)
-    H        = hop  ;   // hop size (samples)
-    prevAnalysisPhase.assign(channels, std::vector<float>(K, 0.f)); // histórico de fase da análise
-    prevSynthPhase  .assign(channels, std::vector<float>(K, 0.f));  // histórico de fase da síntese
+// Inicializa estrutura interna (até maxCh vozes, K bins, hop H).
+void PhaseEngine::setup(int maxCh, int bins, int hop) {
+    maxChannels = std::max(1, maxCh);   // nº máximo de vozes
+    C           = 1;                    // nº de vozes atual
+    K           = bins;                 // nº de bins (N/2 + 1)
+    H           = hop  ;                // hop size (samples)
+    const size_t n = (size_t)K * maxChannels;
+    prevAnalysisPhase.assign(n, 0.f);   // histórico de fase da análise
+    prevSynthPhase   .assign(n, 0.f);   // histórico de fase da síntese
+    peakThresh       .assign(maxChannels, 0.f);
+    peaks            .assign(K, 0);
+
+    // Avanço de fase "esperado" entre frames para o bin k: 2π·k·H/N, com
+    // N = 2·(K−1); reduzido em double (k·H/N pode ser grande) antes do float.
+    expAdvance.resize(K);
+    const int N = 2 * (K - 1);
+    for (int k = 0; k < K; ++k) {
+        const double turns = (double)((int64_t)k * H % N) / N;        // fração de volta em [0, 1)
+        expAdvance[k] = (float)(2.0 * M_PI * (turns > 0.5 ? turns - 1.0 : turns));
+    }
+
+    // PGHI: λ da Gaussiana exp(−π·t²/λ) equivalente à √Hann do SpectroEngine.
+    // A √Hann não é Gaussiana: o ajuste no tempo (log w = −π·t²/λ até N/4 do
+    // centro) dá λ maior que o do lóbulo principal (log|W(ν)/W(0)| = −π·λ·ν² até
+    // 1 bin); usa‑se a média geométrica dos dois, ambos por mínimos quadrados.
+    double lambdaT = 0.0;
+    {
+        double num = 0.0, den = 0.0;
+        for (int j = 1; j <= 8; ++j) {
+            const double t = j * N / 32.0;
+            num += t * t * t * t;
+            den += t * t * std::log(std::cos(M_PI * t / N));    // √Hann centrada: cos(π·t/N)
+        }
+        lambdaT = -M_PI * num / den;
+    }
+    double w0 = 0.0, num = 0.0, den = 0.0;
+    for (int m = 0; m < N; ++m) w0 += std::sqrt(0.5 * (1 - std::cos(2 * M_PI * m / N)));
+    for (int j = 1; j <= 8; ++j) {
+        const double nu = j / (8.0 * N);
+        double W = 0.0;
+        for (int m = 0; m < N; ++m)
+            W += std::sqrt(0.5 * (1 - std::cos(2 * M_PI * m / N))) * std::cos(2 * M_PI * nu * (m - N / 2));
+        const double L = std::log(W / w0);
+        num += nu * nu * L;
+        den += nu * nu * nu * nu;
+    }
+    lambda = (float)std::sqrt(lambdaT * (-num / (M_PI * den)));
+
+    prevLog   .assign(n, 0.f);
+    prevDev   .assign(n, 0.f);
+    prevLogMax.assign(maxChannels, 0.f);
+    logMag    .assign(K, 0.f);
+    dev       .assign(K, 0.f);
+    pending   .assign(K, 0);
+    heap      .resize(2 * (size_t)K);
+    pghiPrimed = false;
 }
 
 // Limpa histórico de fase (usar ao alterar N/H ou no reset do módulo).
 void PhaseEngine::reset() {
-    for (int ch = 0; ch < channels; ++ch) {
-        std::fill(prevAnalysisPhase[ch].begin(), prevAnalysisPhase[ch].end(), 0.f);
-        std::fill(prevSynthPhase  [ch].begin(), prevSynthPhase  [ch].end(), 0.f);
-    }
+    std::fill(prevAnalysisPhase.begin(), prevAnalysisPhase.end(), 0.f);
+    std::fill(prevSynthPhase   .begin(), prevSynthPhase   .end(), 0.f);
+    pghiPrimed = false;
 }
 
-// Reconstrói o espectro de 1 frame (canal ch) segundo o modo pedido.
-void PhaseEngine::processFrame(int ch, Mode mode, const float* magProc, const float* phaseIn, float* outRe, float* outIm) {
+// Reconstrói o espectro de 1 frame de C vozes segundo o modo pedido.
+void PhaseEngine::processFrame(Mode mode, int channels, const float* magProc, const float* phaseIn, float* outRe, float* outIm) {
+    channels = std::clamp(channels, 1, maxChannels);
+    if (channels != C) {
+        C = channels;           // layout [K][C] mudou: histórico deixa de ser válido
+        reset();
+    }
+    const int KC = K * C;
+    float* prevA = prevAnalysisPhase.data();
+    float* phi   = prevSynthPhase.data();
+
     // Modo RAW: fase direta da análise (sem estimação)
     if (mode == Mode::RAW) {
         // Reconstrução direta: usa a fase de análise do próprio frame.
-        for (int k = 0; k < K; ++k) {
-            float phi = phaseIn[k];
-            outRe[k]  = magProc[k] * std::cos(phi);
-            outIm[k]  = magProc[k] * std::sin(phi);
-        }
+        SpectralMath::polarToCart(magProc, phaseIn, outRe, outIm, KC);
         // Atualiza histórico para continuidade quando alternar de modo.
-        std::copy(phaseIn, phaseIn + K, prevAnalysisPhase[ch].begin()); // última fase de análise
-        std::copy(prevAnalysisPhase[ch].begin(), prevAnalysisPhase[ch].end(), prevSynthPhase[ch].begin());  // última fase de síntese
+        std::copy_n(phaseIn, KC, prevA);    // última fase de análise
+        std::copy_n(phaseIn, KC, phi);      // última fase de síntese
+        pghiPrimed = false;
         return;
     }
 
-    // Phase‑Vocoder (frequência instantânea por bin)
-    if (mode == Mode::PV) {
-        for (int k = 0; k < K; ++k) {
-            float phi_a      = phaseIn[k];  // fase da análise atual        
-            float phi_prev_a = prevAnalysisPhase[ch][k]; // fase da análise anterior
-            // Avanço de fase "esperado" entre frames para o bin k:
-            // 2π * k * H / N, notando que N = 2*(K-1).
-            float dphi_exp = 2.f * (float)M_PI * k * (float)H / (float)(2*(K-1));
+    // PGHI: fase só a partir das magnitudes (a da análise fica para PV retomar)
+    if (mode == Mode::PGHI) {
+        for (int c = 0; c < C; ++c) integrateGradient(c, magProc);
+        std::copy_n(phaseIn, KC, prevA);
+        pghiPrimed = true;
+        SpectralMath::polarToCart(magProc, phi, outRe, outIm, KC);
+        return;
+    }
+    pghiPrimed = false;
 
-            // Desvio observado (removido o esperado) e "wrapped" para (-π, π].
-            float dphi     = princarg((phi_a - phi_prev_a) - dphi_exp);
+    // Phase‑Vocoder: desvio observado face ao avanço esperado e[k] (reduzido
+    // a (−π, π]) -> avanço real = e + desvio, acumulado na fase de síntese.
+    // Fases em (−π, π] e e ∈ (−π, π]: os dois argumentos de wrap() estão em (−3π, 3π].
+    for (int k = 0; k < K; ++k) {
+        const float e = expAdvance[k];
+        const int row = k * C;
+        for (int c = 0; c < C; ++c) {
+            const float phi_a = phaseIn[row + c];
+            const float dphi  = wrap((phi_a - prevA[row + c]) - e);
+            phi[row + c]  = wrap(phi[row + c] + (e + dphi));
+            prevA[row + c] = phi_a;
+        }
+    }
 
-            // Frequência instantânea (rad/amostra).
-            float omega    = (dphi_exp + dphi) / (float)H;
+    // PV‑Lock: fase de cada bin presa ao pico da sua região
+    if (mode == Mode::PV_LOCK) {
+        // Limiar de pico por voz (−60 dB do máximo do frame).
+        float* thresh = peakThresh.data();
+        std::fill_n(thresh, C, 0.f);
+        for (int k = 0; k < K; ++k)
+            for (int c = 0; c < C; ++c) thresh[c] = std::max(thresh[c], magProc[k * C + c]);
+        for (int c = 0; c < C; ++c) thresh[c] *= 0.001f;
 
-            // Acumula fase de síntese para continuidade temporal.
-            float phi_s    = prevSynthPhase[ch][k] + omega * (float)H;
+        for (int c = 0; c < C; ++c) lockToPeaks(c, magProc, phaseIn);
+    }
+
+    // Espectro de saída (a fase de síntese fica como histórico do próximo frame).
+    SpectralMath::polarToCart(magProc, phi, outRe, outIm, KC);
+}
 
-            // Guarda históricos para a próxima iteração.
-            prevAnalysisPhase[ch][k] = phi_a;
-            prevSynthPhase  [ch][k] = phi_s;
+/*
+ Identity Phase Locking de uma voz, O(K):
+  1. picos = máximos locais acima do limiar (fronteiras excluídas);
+  2. a região do pico i vai da fronteira anterior até ao bin de menor
+     magnitude entre os picos i e i+1 (inclusive; o último vai até K−1);
+  3. cada bin não‑pico da região roda com o pico: φs[k] = φs[p] + φa[k] − φa[p].
+ Sem picos (frame em silêncio) fica a fase PV.
+*/
+void PhaseEngine::lockToPeaks(int c, const float* magProc, const float* phaseIn) {
+    const float* mag = magProc + c;         // [k·C]
+    const float* pa  = phaseIn + c;
+    float*       ps  = prevSynthPhase.data() + c;
+    const float th = peakThresh[c];
 
-            // Espectro de saída.
-            outRe[k] = magProc[k] * std::cos(phi_s);
-            outIm[k] = magProc[k] * std::sin(phi_s);
-        }
+    int n = 0;
+    for (int k = 1; k < K - 1; ++k) {
+        const float m = mag[k * C];
+        if (m > th && m > mag[(k - 1) * C] && m >= mag[(k + 1) * C]) peaks[n++] = k;
     }
 
-    // PV‑Lock (Identity Phase Locking) - fase bloqueada a partir dos picos
-    if (mode == Mode::PV_LOCK) {
-        // 1. Fase PV base -> phi_s[k]
-        static thread_local std::vector<float> phi_s;
-        static thread_local std::vector<float> phi_lock;
-        if ((int)phi_s.size() != K) {
-            phi_s.assign(K, 0.f);
-            phi_lock.assign(K, 0.f);
+    int lo = 0;
+    for (int i = 0; i < n; ++i) {
+        const int p = peaks[i];
+        int hi = K - 1;                     // último bin da região (inclusive)
+        if (i + 1 < n) {
+            hi = p + 1;
+            for (int k = p + 2; k < peaks[i + 1]; ++k)
+                if (mag[k * C] < mag[hi * C]) hi = k;
         }
+        // φs[p] − φa[p] ∈ (−2π, 2π) e φa[k] ∈ (−π, π]: soma em (−3π, 3π)
+        const float rot = ps[p * C] - pa[p * C];
+        for (int k = lo; k < p; ++k)      ps[k * C] = wrap(rot + pa[k * C]);
+        for (int k = p + 1; k <= hi; ++k) ps[k * C] = wrap(rot + pa[k * C]);
+        lo = hi + 1;
+    }
+}
 
-        for (int k = 0; k < K; ++k) {
-            float phi_a      = phaseIn[k];
-            float phi_prev_a = prevAnalysisPhase[ch][k];
-            float dphi_exp   = 2.f * (float)M_PI * k * (float)H / (float)(2*(K-1));
-            float dphi       = princarg((phi_a - phi_prev_a) - dphi_exp);
-            float omega      = (dphi_exp + dphi) / (float)H;
-            float phi        = prevSynthPhase[ch][k] + omega * (float)H;
-
-            prevAnalysisPhase[ch][k] = phi_a;
-            prevSynthPhase  [ch][k]  = phi;
-            phi_s[k] = phi;
-        }
+/*
+ PGHI de uma voz (RTPGHI causal), O(K log K) e sem alocação:
+  1. s = log|X|; desvio de ∂φ/∂t face ao centro do bin, já multiplicado por
+     H/2 (regra do trapézio entre o frame anterior e o atual):
+        dev[k] = (H/2)·(N/λ)·(s[k+1] − s[k−1])/2
+  2. bins significativos (s > máx − 100 dB): entram na heap pela entrada do
+     frame anterior (chave = log|X| anterior); os restantes só avançam no tempo.
+  3. retira‑se sempre a entrada mais forte:
+      - do frame anterior: φ[k] += 2πkH/N + dev_ant[k] + dev[k]
+      - do frame atual: propaga aos vizinhos k±1 ainda sem fase,
+        Δφ = ∓λ/(2NH)·(Δs[k] + Δs[k±1]) ± π (Δs = s − s_ant; ±π: fase da FFT
+        referida ao início do frame, com a janela centrada em N/2)
+     e cada bin que recebe fase entra na heap como entrada do frame atual.
+ Todos os bins significativos têm entrada do frame anterior, logo a heap só
+ esvazia com todos resolvidos. No 1º frame (ou depois de outro modo) o frame
+ anterior é o próprio frame e a fase parte da fase de síntese em curso.
+*/
+void PhaseEngine::integrateGradient(int c, const float* magProc) {
+    constexpr float kTolLog = -11.512925f;          // log(1e−5): −100 dB
+    const float* mag = magProc + c;                 // [k·C]
+    float* phi = prevSynthPhase.data() + c;         // [k·C]
+    float* sP  = prevLog.data() + (size_t)c * K;
+    float* dP  = prevDev.data() + (size_t)c * K;
+    float* s   = logMag.data();
+    float* d   = dev.data();
+    const float* e = expAdvance.data();
+    const int N = 2 * (K - 1);
 
-        // 2. Detetar picos (threshold relativo simples).
-        std::vector<char> isPeak(K, 0);
-        float maxMag = 0.f;
-        for (int k = 0; k < K; ++k) if (magProc[k] > maxMag) maxMag = magProc[k];
-        const float thresh = 0.001f * maxMag;
-        for (int k = 1; k < K-1; ++k)
-            if (magProc[k] > thresh &&
-                magProc[k] > magProc[k-1] &&
-                magProc[k] >= magProc[k+1])
-                isPeak[k] = 1;
-
-        // 3. Propagar fase bloqueada a partir do pico mais próximo.
-        for (int k = 0; k < K; ++k) {
-            if (isPeak[k])
-                phi_lock[k] = phi_s[k];
-            else if (k == 0)
-                phi_lock[k] = phi_s[k]; // DC bin
-            else
-                // Integra diferença principal para evitar saltos.
-                phi_lock[k] = phi_lock[k-1] + princarg(phi_s[k] - phi_s[k-1]);
-        }
+    float sMax = -1e30f;
+    for (int k = 0; k < K; ++k) {
+        s[k] = std::log(mag[k * C] + 1e-30f);
+        sMax = std::max(sMax, s[k]);
+    }
+    const float tScale = (float)(0.25 * H * N / lambda);
+    d[0] = d[K - 1] = 0.f;                          // espectro simétrico em DC e Nyquist
+    for (int k = 1; k < K - 1; ++k) d[k] = tScale * (s[k + 1] - s[k - 1]);
+    if (!pghiPrimed) {
+        std::copy_n(s, K, sP);
+        std::copy_n(d, K, dP);
+        prevLogMax[c] = sMax;
+    }
 
-        // 4. Escreve espectro bloqueado.
-        for (int k = 0; k < K; ++k) {
-            outRe[k] = magProc[k] * std::cos(phi_lock[k]);
-            outIm[k] = magProc[k] * std::sin(phi_lock[k]);
+    const float th = std::max(sMax, prevLogMax[c]) + kTolLog;
+    const float fScale = (float)(-lambda / (2.0 * N * H));
+    uint64_t* h = heap.data();
+    int size = 0;
+    for (int k = 0; k < K; ++k) {
+        pending[k] = s[k] > th;
+        if (pending[k]) h[size++] = heapEntry(sP[k], k + K);
+        else            phi[k * C] = principal(phi[k * C] + e[k] + dP[k] + d[k]);
+    }
+    std::make_heap(h, h + size);
+
+    // Bin resolvido entra como entrada do frame atual. Se for ≥ ao topo da heap
+    // seria o próximo a sair: fica em 'next' (sem push + pop).
+    uint64_t next = 0;
+    bool hasNext = false;
+    auto settle = [&](int k, float phase) {
+        phi[k * C] = principal(phase);
+        pending[k] = 0;
+        uint64_t entry = heapEntry(s[k], k);
+        if (hasNext && entry > next) std::swap(entry, next);
+        if (!hasNext && (size == 0 || entry > h[0])) { next = entry; hasNext = true; }
+        else heapPush(h, size, entry);
+    };
+    while (hasNext || size > 0) {
+        const int idx = (int)(uint32_t)(hasNext ? next : heapPop(h, size));
+        hasNext = false;
+        if (idx >= K) {                             // tempo: frame anterior -> atual
+            const int k = idx - K;
+            if (pending[k]) settle(k, phi[k * C] + e[k] + dP[k] + d[k]);
+            continue;
         }
-        return;
+        const int k = idx;                          // frequência: k -> k±1
+        const float ds = s[k] - sP[k];
+        if (k + 1 < K && pending[k + 1])
+            settle(k + 1, phi[k * C] + fScale * (ds + s[k + 1] - sP[k + 1]) + (float)M_PI);
+        if (k > 0 && pending[k - 1])
+            settle(k - 1, phi[k * C] - fScale * (ds + s[k - 1] - sP[k - 1]) - (float)M_PI);
     }
+
+    std::copy_n(s, K, sP);
+    std::copy_n(d, K, dP);
+    prevLogMax[c] = sMax;
 }
@@ -3,6 +3,8 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <cstring>
+#include "SpectralMath.hpp"
 
 /*
  PhaseEngine
@@ -12,47 +14,125 @@
     RAW (0)     – Fase direta da análise (sem estimação).
     PV  (1)     – Phase‑Vocoder clássico: estima frequência instantânea
                   por bin e acumula fase de síntese continuamente.
-    PV_LOCK (2) – Identity Phase Locking: após a etapa PV, fixa a fase
-                  dos bins vizinhos à fase do pico espectral mais próximo.
+    PV_LOCK (2) – Identity Phase Locking (Laroche–Dolson): após a etapa PV,
+                  cada bin pertence à região de influência do pico mais
+                  próximo (fronteira no mínimo de magnitude entre dois picos)
+                  e roda com ele: φs[k] = φs[p] + φa[k] − φa[p].
+    PGHI (3)    – Phase Gradient Heap Integration (Průša et al., versão
+                  causal do RTPGHI): a fase é reconstruída só a partir da
+                  magnitude processada. O gradiente de fase vem do gradiente
+                  do log da magnitude, pela relação exata da janela Gaussiana
+                  (λ ajustado ao lóbulo principal da √Hann):
+                     ∂φ/∂t = 2πk/N + (1/λ)·∂s/∂ω      (s = log|X|)
+                     ∂φ/∂ω = −λ·∂s/∂t                 (diferença para trás: sem latência)
+                  e é integrado por ordem de magnitude decrescente (heap
+                  binária limitada a 2K entradas): cada bin recebe a fase do
+                  vizinho já conhecido mais forte, no tempo (frame anterior)
+                  ou na frequência (frame atual). Bins abaixo de −100 dB do
+                  máximo só avançam com ∂φ/∂t.
  
  Interface público é "stateless" (por frame), mas o motor mantém histórico
- de fase por canal/bin para PV e PV_LOCK.
+ de fase por voz/bin para PV e PV_LOCK.
  
  Convenções:
     - K: número de bins (N/2 + 1).
     - H: hop size (amostras).
-    - magnitudes e fases são arrays de tamanho K.
+    - C: nº de vozes processadas em conjunto (mesmo instante de hop).
+    - magnitudes e fases são arrays [K][C] (bin‑major: x[k·C + c]); os laços
+      internos percorrem as vozes.
+
+ Tempo real: todo o estado e scratch (históricos, avanço esperado por bin,
+ lista de picos) é alocado em setup(); processFrame() não aloca. O avanço
+ esperado 2π·k·H/N vem de uma tabela (já reduzida a (−π, π]) e as reduções
+ de fase são somas condicionais sem ramos (sem fmod), vetorizáveis.
+
+ A conversão fase -> re/im é feita por bloco com SpectralMath::polarToCart
+ (sincos vetorial); a fase de síntese acumulada é mantida em (-π, π].
  */
 class PhaseEngine {
 public:
-    enum class Mode : uint8_t { RAW = 0, PV = 1, PV_LOCK = 2 };
+    enum class Mode : uint8_t { RAW = 0, PV = 1, PV_LOCK = 2, PGHI = 3 };
 
-    // Inicializa estrutura interna (numCh canais, K bins, hop H). 
-    void setup(int numCh, int bins, int hop);
+    // Inicializa estrutura interna (até maxCh vozes, K bins, hop H). 
+    void setup(int maxCh, int bins, int hop);
 
     // Limpa histórico de fase (usar ao alterar N/H ou no reset do módulo). 
     void reset();
     
     /*
-    Reconstrói o espectro de 1 frame (canal ch) segundo o modo pedido.
-     - magProc[K] : magnitude processada (após efeitos).
-     - phaseIn[K] : fase da análise (do frame atual).
-     - outRe/outIm[K] : escrita do espectro complexo de síntese.
+    Reconstrói o espectro de 1 frame de C vozes segundo o modo pedido.
+     - channels          : nº de vozes C (1..maxCh); se mudar, o histórico é limpo.
+     - magProc[K·C]      : magnitude processada (após efeitos).
+     - phaseIn[K·C]      : fase da análise (do frame atual).
+     - outRe/outIm[K·C]  : escrita do espectro complexo de síntese.
     */
-    void processFrame(int ch, Mode mode, const float* magProc, const float* phaseIn, float* outRe, float* outIm);
+    void processFrame(Mode mode, int channels, const float* magProc, const float* phaseIn, float* outRe, float* outIm);
 
 private:
-    int channels = 0;   // nº de canais (1 ou 2)
-    int K        = 0;   // nº de bins (N/2 + 1)
-    int H        = 0;   // hop size (samples)
-
-    std::vector<std::vector<float>> prevAnalysisPhase; // [ch][K]
-    std::vector<std::vector<float>> prevSynthPhase;    // [ch][K]
-
-    /** Ângulo principal em (-π, π]. */
-    static inline float princarg(float x) {
-        x = std::fmod(x + (float)M_PI, 2.f * (float)M_PI);  // x em (-π, 3π]
-        if (x < 0.f) x += 2.f * (float)M_PI;                // x em [0, 3π]
-        return x - (float)M_PI;                             // x em (-π, π]
+    int maxChannels = 0;    // nº máximo de vozes
+    int C           = 1;    // nº de vozes do histórico atual
+    int K           = 0;    // nº de bins (N/2 + 1)
+    int H           = 0;    // hop size (samples)
+
+    std::vector<float> prevAnalysisPhase;   // [K][C]
+    std::vector<float> prevSynthPhase;      // [K][C] fase de síntese (do frame, depois de processFrame)
+    std::vector<float> expAdvance;          // [K]    2π·k·H/N reduzido a (−π, π]
+    std::vector<float> peakThresh;          // [C]    limiar de pico por voz
+    std::vector<int>   peaks;               // [K]    picos de uma voz (PV_LOCK)
+
+    // PGHI: estado por voz em [C][K] (a heap percorre uma voz de cada vez) e scratch [K]
+    float lambda     = 0.f;                     // λ da Gaussiana equivalente à √Hann (amostras²)
+    bool  pghiPrimed = false;                   // histórico de log‑magnitude válido (frame anterior em PGHI)
+    std::vector<float> prevLog;                 // [C][K] log|X| do frame anterior
+    std::vector<float> prevDev;                 // [C][K] (H/2)·(∂φ/∂t − 2πk/N) do frame anterior
+    std::vector<float> prevLogMax;              // [C]
+    std::vector<float> logMag, dev;             // [K]
+    std::vector<uint8_t> pending;               // [K] bin significativo ainda sem fase
+    std::vector<uint64_t> heap;                 // [2K] heap binária (máx.): log|X| ordenável << 32 | idx
+                                                // (idx < K: bin do frame atual; ≥ K: do anterior)
+
+    // Trava a fase de síntese (prevSynthPhase) de uma voz aos picos de magProc
+    void lockToPeaks(int c, const float* magProc, const float* phaseIn);
+
+    // PGHI de uma voz: fase de síntese (prevSynthPhase) a partir de magProc
+    void integrateGradient(int c, const float* magProc);
+
+    // Entrada da heap: chave float com ordem de inteiro sem sinal (uma comparação de 64 bits)
+    static inline uint64_t heapEntry(float key, int idx) {
+        uint32_t u;
+        std::memcpy(&u, &key, 4);
+        u = (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+        return (uint64_t)u << 32 | (uint32_t)idx;
+    }
+    static inline void heapPush(uint64_t* h, int& n, uint64_t e) {
+        int i = n++;
+        for (int p; i > 0 && h[p = (i - 1) >> 1] < e; i = p) h[i] = h[p];
+        h[i] = e;
+    }
+    // Retira o máximo: desce o buraco até uma folha pelo filho maior (escolha sem ramo) e sobe o último
+    static inline uint64_t heapPop(uint64_t* h, int& n) {
+        const uint64_t top = h[0], last = h[--n];
+        int i = 0;
+        for (int c; (c = 2 * i + 1) < n; i = c) {
+            c += (c + 1 < n) & (h[c + 1] > h[c]);
+            h[i] = h[c];
+        }
+        for (int p; i > 0 && h[p = (i - 1) >> 1] < last; i = p) h[i] = h[p];
+        h[i] = last;
+        return top;
+    }
+
+    /** Reduz x (|x| < 2³⁰) a [−π, π] (x − 2π·round(x/2π), arredondamento por truncagem: sem libm). */
+    static inline float principal(float x) {
+        const float twoPi = 2.f * (float)M_PI, t = x * (1.f / twoPi);
+        return x - twoPi * (float)(int)(t + (t < 0.f ? -0.5f : 0.5f));
+    }
+
+    /** Reduz x ∈ (−3π, 3π] a (−π, π] com duas somas condicionais (sem ramos nem fmod). */
+    static inline float wrap(float x) {
+        constexpr float pi = (float)M_PI, twoPi = 2.f * (float)M_PI;
+        x -= (x >   pi) ? twoPi : 0.f;
+        x += (x <= -pi) ? twoPi : 0.f;
+        return x;
     }
 };
@@ -0,0 +1,242 @@
+#include "PlanCache.hpp"
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+
+namespace PlanCache {
+
+bool Key::operator<(const Key& o) const {
+    if (n != o.n)               return n < o.n;
+    if (howmany != o.howmany)   return howmany < o.howmany;
+    if (inverse != o.inverse)   return inverse < o.inverse;
+    if (timeDist != o.timeDist) return timeDist < o.timeDist;
+    if (freqDist != o.freqDist) return freqDist < o.freqDist;
+    if (threads != o.threads)   return threads < o.threads;
+    if (single != o.single)     return single < o.single;
+    return complex < o.complex;
+}
+
+/*
+ Estado global. Dois mutexes, nunca tomados pelo mesmo thread em simultâneo
+ exceto na ordem state -> planner (acquire):
+    - state  : mapa de planos, fila de melhorias, thread de fundo.
+    - planner: todas as chamadas ao planeador FFTW (não thread‑safe).
+*/
+struct Registry {
+    using Clock = std::chrono::steady_clock;
+
+    std::mutex state;
+    std::map<Key, std::weak_ptr<Plan>> plans;
+    std::deque<std::weak_ptr<Plan>> upgrades;   // planos a melhorar em fundo
+    std::thread worker;
+    std::condition_variable cv;
+    bool running = false;                       // worker ativo (termina quando a fila esvazia)
+    bool stop = false;
+
+    std::mutex planner;
+    bool threadsReady = false;
+    std::string wisdomPath[2];                  // [single]: fftw_* / fftwf_*
+
+    // Pedidos em primeiro plano recentes: o worker cede-lhes o planeador
+    std::atomic<int> foreground { 0 };
+    std::atomic<int64_t> lastForegroundMs { 0 };
+
+    static Registry& get() {
+        static Registry r;
+        return r;
+    }
+
+    ~Registry() {
+        {
+            std::lock_guard<std::mutex> lock(state);
+            stop = true;
+            upgrades.clear();
+        }
+        cv.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    template <typename T>
+    static void* makeT(const Key& k, unsigned flags) {
+        using F = Fftw<T>;
+        F::planWithThreads(k.threads);
+        if (k.complex) {
+            typename F::Complex* in  = F::allocComplex((size_t)k.howmany * k.timeDist);
+            typename F::Complex* out = F::allocComplex((size_t)k.howmany * k.freqDist);
+            typename F::Plan p = k.inverse
+                ? F::planC2C(k.n, k.howmany, out, k.freqDist, in, k.timeDist, FFTW_BACKWARD, flags)
+                : F::planC2C(k.n, k.howmany, in, k.timeDist, out, k.freqDist, FFTW_FORWARD, flags);
+            F::free(in);
+            F::free(out);
+            return p;
+        }
+        T* time = F::allocReal((size_t)k.howmany * k.timeDist);
+        typename F::Complex* freq = F::allocComplex((size_t)k.howmany * k.freqDist);
+        typename F::Plan p = k.inverse
+            ? F::planC2R(k.n, k.howmany, freq, k.freqDist, time, k.timeDist, flags)
+            : F::planR2C(k.n, k.howmany, time, k.timeDist, freq, k.freqDist, flags);
+        F::free(time);
+        F::free(freq);
+        return p;
+    }
+
+    // Cria um plano sobre buffers de rascunho (chamar com 'planner' tomado).
+    void* make(const Key& k, unsigned flags) {
+        if (!threadsReady) {
+            Fftw<double>::initThreads();        // suporte a threads, apenas 1× globalmente
+            Fftw<float>::initThreads();
+            threadsReady = true;
+        }
+        return k.single ? makeT<float>(k, flags) : makeT<double>(k, flags);
+    }
+
+    // Destrói um plano da precisão da chave (chamar com 'planner' tomado).
+    static void destroy(const Key& k, void* p) {
+        if (!p) return;
+        if (k.single) Fftw<float>::destroy(static_cast<Fftw<float>::Plan>(p));
+        else          Fftw<double>::destroy(static_cast<Fftw<double>::Plan>(p));
+    }
+
+    static void setTimeLimit(bool single, double s) {
+        if (single) Fftw<float>::setTimeLimit(s);
+        else        Fftw<double>::setTimeLimit(s);
+    }
+
+    // Grava a wisdom acumulada de uma precisão (chamar com 'planner' tomado). Escrita via ficheiro temporário.
+    void saveWisdom(bool single) {
+        const std::string& path = wisdomPath[single];
+        if (path.empty()) return;
+        const std::string tmp = path + ".tmp";
+        const int ok = single ? Fftw<float>::exportWisdom(tmp.c_str()) : Fftw<double>::exportWisdom(tmp.c_str());
+        if (!ok) return;
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(path.c_str());                  // Windows: rename não substitui
+            std::rename(tmp.c_str(), path.c_str());
+        }
+    }
+
+    // Melhora os planos da fila com FFTW_PATIENT, um de cada vez
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(state);
+        for (;;) {
+            if (stop || upgrades.empty()) { running = false; return; }
+
+            // Cede o planeador enquanto houver instâncias a ser criadas
+            if (foreground.load() > 0 || nowMs() - lastForegroundMs.load() < 250) {
+                cv.wait_for(lock, std::chrono::milliseconds(100));
+                continue;
+            }
+
+            PlanRef p = upgrades.front().lock();
+            upgrades.pop_front();
+            if (!p || p->isFinal()) continue;
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> pl(planner);
+                setTimeLimit(p->key.single, PATIENT_TIME_LIMIT);
+                void* better = make(p->key, FFTW_PATIENT);
+                setTimeLimit(p->key.single, FFTW_NO_TIMELIMIT);
+                if (better) {
+                    // O plano anterior pode estar a ser executado: só é destruído com a entrada
+                    destroy(p->key, p->replaced);
+                    p->replaced = p->current.exchange(better, std::memory_order_acq_rel);
+                    p->final.store(true, std::memory_order_release);
+                    saveWisdom(p->key.single);
+                }
+            }
+            p.reset();                          // fora do 'planner' (~Plan toma-o)
+            lock.lock();
+        }
+    }
+
+    // 1º plano de uma entrada, sem medições (ver política em PlanCache.hpp)
+    void planInitial(Plan& p) {
+        std::lock_guard<std::mutex> lock(planner);
+        bool final = true;
+        void* f = make(p.key, FFTW_PATIENT | FFTW_WISDOM_ONLY);
+        if (!f) { final = false; f = make(p.key, FFTW_MEASURE | FFTW_WISDOM_ONLY); }
+        if (!f) f = make(p.key, FFTW_ESTIMATE);
+        p.current.store(f, std::memory_order_release);
+        p.final.store(final, std::memory_order_release);
+    }
+
+    void enqueueUpgrade(const PlanRef& p) {     // chamar com 'state' tomado
+        upgrades.push_back(p);
+        if (!running && !stop) {
+            if (worker.joinable()) worker.join();   // worker anterior já terminou
+            running = true;
+            worker = std::thread(&Registry::workerLoop, this);
+        }
+        cv.notify_one();
+    }
+};
+
+Plan::~Plan() {
+    Registry& r = Registry::get();
+    std::lock_guard<std::mutex> lock(r.planner);
+    Registry::destroy(key, current.load());
+    Registry::destroy(key, replaced);
+}
+
+PlanRef acquire(const Key& key) {
+    Registry& r = Registry::get();
+    r.foreground.fetch_add(1);
+
+    PlanRef p;
+    {
+        std::lock_guard<std::mutex> lock(r.state);
+        std::weak_ptr<Plan>& slot = r.plans[key];
+        p = slot.lock();
+        if (!p) {
+            p = std::make_shared<Plan>(key);
+            r.planInitial(*p);
+            slot = p;
+            if (!p->isFinal()) r.enqueueUpgrade(p);
+
+            // Limpa entradas de planos já destruídos
+            for (auto it = r.plans.begin(); it != r.plans.end(); )
+                it = it->second.expired() ? r.plans.erase(it) : std::next(it);
+        }
+    }
+
+    r.lastForegroundMs.store(Registry::nowMs());
+    r.foreground.fetch_sub(1);
+    return p;
+}
+
+void setWisdomFile(const std::string& path, bool single) {
+    Registry& r = Registry::get();
+    std::lock_guard<std::mutex> lock(r.planner);
+    r.wisdomPath[single] = path;
+    if (path.empty()) return;
+    if (single) Fftw<float>::importWisdom(path.c_str());    // ausente na 1ª execução
+    else        Fftw<double>::importWisdom(path.c_str());
+}
+
+void waitIdle() {
+    Registry& r = Registry::get();
+    std::unique_lock<std::mutex> lock(r.state);
+    while (r.running) {
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        lock.lock();
+    }
+}
+
+int size() {
+    Registry& r = Registry::get();
+    std::lock_guard<std::mutex> lock(r.state);
+    int n = 0;
+    for (auto& kv : r.plans) n += kv.second.expired() ? 0 : 1;
+    return n;
+}
+
+} // namespace PlanCache
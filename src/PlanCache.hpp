@@ -0,0 +1,95 @@
+#pragma once
+#include "FftwTraits.hpp"
+#include <atomic>
+#include <memory>
+#include <string>
+
+/*
+ PlanCache
+
+ Registo de planos FFTW partilhado por todo o processo (todas as instâncias
+ do módulo e as ferramentas headless). Cada plano é identificado pela sua
+ geometria (N, nº de transformadas do lote, sentido e distâncias entre
+ transformadas) e é contado por referência: a última instância a largá-lo
+ destrói-o.
+
+ Os planos são criados sobre buffers de rascunho próprios e executados pelos
+ utilizadores com o new‑array execute (fftw_execute_dft_r2c/c2r/dft), logo os
+ buffers de áudio nunca são escritos pelo planeador. Requisito: arrays com o
+ alinhamento do fftw_alloc_* e as mesmas distâncias da chave.
+
+ Política de planeamento (acquire() nunca mede):
+    1. FFTW_PATIENT só com wisdom     -> plano final, instantâneo.
+    2. FFTW_MEASURE só com wisdom     -> instantâneo; melhora em fundo.
+    3. FFTW_ESTIMATE                  -> instantâneo; melhora em fundo.
+ A melhoria (FFTW_PATIENT, limitado a PATIENT_TIME_LIMIT segundos por plano)
+ corre num thread de fundo do registo; o novo plano é publicado de forma
+ atómica em Plan::get() e o anterior só é destruído com a entrada. A wisdom
+ acumulada é gravada em disco (setWisdomFile) depois de cada melhoria, para
+ que a próxima sessão obtenha logo o plano final.
+
+ O nº de threads FFTW e a precisão (fftw_* double / fftwf_* float) fazem
+ parte da chave: planos de 1 e de 2 threads, e das duas precisões, coexistem
+ (ver FFTBackend). Cada precisão tem a sua wisdom e o seu ficheiro.
+
+ O planeador FFTW não é thread‑safe: toda a criação/destruição de planos
+ passa pelo mutex do registo.
+ */
+namespace PlanCache {
+
+constexpr double PATIENT_TIME_LIMIT = 2.0;  // s por plano melhorado em fundo
+
+// Geometria de um plano em lote (fftw_plan_many_dft_r2c / c2r, 1D).
+struct Key {
+    int n       = 0;        // tamanho da transformada
+    int howmany = 1;        // transformadas por execução
+    bool inverse = false;   // false: r2c (tempo -> espectro); true: c2r
+    int timeDist = 0;       // distância entre transformadas no tempo (reais)
+    int freqDist = 0;       // distância entre transformadas no espectro (complexos)
+    int threads  = 1;       // threads FFTW por execução (fftw_plan_with_nthreads)
+    bool single  = false;   // precisão: false = double (fftw_*), true = float (fftwf_*)
+    bool complex = false;   // c2c de N complexos, out‑of‑place (two‑for‑one do FFTBackend);
+                            // timeDist/freqDist em complexos, inverse = FFTW_BACKWARD
+
+    bool operator<(const Key& o) const;
+};
+
+// Plano partilhado. get() pode mudar (melhoria em fundo): ler a cada execução.
+// T tem de corresponder a key.single (double: fftw_plan, float: fftwf_plan).
+class Plan {
+public:
+    explicit Plan(const Key& k) : key(k) {}
+    ~Plan();
+
+    Plan(const Plan&) = delete;
+    Plan& operator=(const Plan&) = delete;
+
+    template <typename T>
+    typename Fftw<T>::Plan get() const { return static_cast<typename Fftw<T>::Plan>(current.load(std::memory_order_acquire)); }
+    bool isFinal() const { return final.load(std::memory_order_acquire); }
+
+    const Key key;
+
+private:
+    friend struct Registry;
+    std::atomic<void*> current { nullptr };     // fftw_plan ou fftwf_plan (key.single)
+    void* replaced = nullptr;               // plano anterior (em uso possível até ao fim)
+    std::atomic<bool> final { false };      // já é FFTW_PATIENT
+};
+
+using PlanRef = std::shared_ptr<Plan>;
+
+// Obtém (ou cria) o plano da chave. Nunca faz medições; chamar fora do thread de áudio.
+PlanRef acquire(const Key& key);
+
+// Ficheiro de wisdom de uma precisão: importado já (se existir) e regravado
+// após cada melhoria. Caminho vazio desliga a persistência.
+void setWisdomFile(const std::string& path, bool single = false);
+
+// Espera que as melhorias pendentes terminem (ferramentas/testes).
+void waitIdle();
+
+// Nº de planos vivos no registo.
+int size();
+
+} // namespace PlanCache
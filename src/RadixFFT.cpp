@@ -0,0 +1,113 @@
+#include "RadixFFT.hpp"
+#include <cmath>
+#include <utility>
+
+// Tabelas: permutação, twiddles por estágio e rotação do pós‑processamento
+template <typename T>
+void RadixFFT<T>::setup(int n) {
+    N = n;
+    M = n / 2;
+
+    int bits = 0;
+    while ((1 << bits) < M) ++bits;
+    bitrev.resize(M);
+    for (int i = 0; i < M; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b)
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        bitrev[i] = r;
+    }
+
+    // Estágio com 'len' pontos: twiddles j = 0..len/2−1 a partir do índice len/2 − 1
+    twiddle.assign(2 * (size_t)(M > 1 ? M - 1 : 1), T(0));
+    for (int len = 2; len <= M; len <<= 1) {
+        const int half = len / 2;
+        T* w = twiddle.data() + 2 * (half - 1);
+        for (int j = 0; j < half; ++j) {
+            const double a = -2.0 * M_PI * j / len;
+            w[2 * j]     = (T)std::cos(a);
+            w[2 * j + 1] = (T)std::sin(a);
+        }
+    }
+
+    post.resize(2 * (size_t)(M + 1));
+    for (int k = 0; k <= M; ++k) {
+        const double a = -2.0 * M_PI * k / N;
+        post[2 * k]     = (T)std::cos(a);
+        post[2 * k + 1] = (T)std::sin(a);
+    }
+
+    z.assign(2 * (size_t)M, T(0));
+}
+
+// FFT complexa radix‑2 in‑place (inverse: twiddles conjugados, sem normalização)
+template <typename T>
+void RadixFFT<T>::complexFFT(T* v, bool inverse) const {
+    for (int i = 0; i < M; ++i) {
+        const int r = bitrev[i];
+        if (i < r) {
+            std::swap(v[2 * i],     v[2 * r]);
+            std::swap(v[2 * i + 1], v[2 * r + 1]);
+        }
+    }
+
+    const T s = inverse ? T(-1) : T(1);
+    for (int len = 2; len <= M; len <<= 1) {
+        const int half = len / 2;
+        const T* w = twiddle.data() + 2 * (half - 1);
+        for (int i = 0; i < M; i += len) {
+            T* a = v + 2 * i;
+            T* b = a + 2 * half;
+            for (int j = 0; j < half; ++j) {
+                const T wr = w[2 * j], wi = s * w[2 * j + 1];
+                const T br = b[2 * j] * wr - b[2 * j + 1] * wi;
+                const T bi = b[2 * j] * wi + b[2 * j + 1] * wr;
+                const T ar = a[2 * j], ai = a[2 * j + 1];
+                a[2 * j]     = ar + br;  a[2 * j + 1] = ai + bi;
+                b[2 * j]     = ar - br;  b[2 * j + 1] = ai - bi;
+            }
+        }
+    }
+}
+
+// X[k] = Fe[k] + W^k·Fo[k], com Fe = (Z[k] + Z*[M−k])/2 e Fo = −i·(Z[k] − Z*[M−k])/2
+template <typename T>
+void RadixFFT<T>::forward(const T* x, T* X) {
+    T* v = z.data();
+    for (int i = 0; i < N; ++i) v[i] = x[i];    // pares (x[2n], x[2n+1]) = z[n]
+    complexFFT(v, false);
+
+    for (int k = 0; k <= M; ++k) {
+        const int a = (k == M) ? 0 : k;
+        const int b = (k == 0) ? 0 : M - k;
+        const T zr = v[2 * a], zi = v[2 * a + 1];
+        const T cr = v[2 * b], ci = -v[2 * b + 1];          // Z*[M−k]
+        const T er = T(0.5) * (zr + cr), ei = T(0.5) * (zi + ci);
+        const T or_ = T(0.5) * (zi - ci), oi = T(-0.5) * (zr - cr);
+        const T wr = post[2 * k], wi = post[2 * k + 1];
+        X[2 * k]     = er + wr * or_ - wi * oi;
+        X[2 * k + 1] = ei + wr * oi + wi * or_;
+    }
+}
+
+// Z[k] = Fe[k] + i·Fo[k], com Fe = X[k] + X*[M−k] e Fo = (X[k] − X*[M−k])·W^{−k}; IFFT de M pontos
+template <typename T>
+void RadixFFT<T>::inverse(const T* X, T* x) {
+    T* v = z.data();
+    for (int k = 0; k < M; ++k) {
+        const int b = M - k;
+        const T xr = X[2 * k], xi = (k == 0) ? T(0) : X[2 * k + 1];
+        const T cr = X[2 * b], ci = (b == M) ? T(0) : -X[2 * b + 1];    // X*[M−k]
+        const T er = xr + cr, ei = xi + ci;
+        const T dr = xr - cr, di = xi - ci;
+        const T wr = post[2 * k], wi = -post[2 * k + 1];                // W^{−k}
+        const T or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+        v[2 * k]     = er - oi;
+        v[2 * k + 1] = ei + or_;
+    }
+    complexFFT(v, true);
+    for (int i = 0; i < N; ++i) x[i] = v[i];
+}
+
+template class RadixFFT<double>;
+template class RadixFFT<float>;
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+
+/*
+ RadixFFT
+
+ FFT real in‑tree (sem dependências), usada pelo backend RADIX do
+ FFTBackend. Ao estilo do KissFFT/PFFFT para transformadas reais:
+
+    - N reais são vistos como M = N/2 complexos z[n] = x[2n] + i·x[2n+1];
+    - FFT complexa de M pontos, radix‑2 iterativa (DIT) com permutação por
+      tabela e twiddles contíguos por estágio;
+    - pós‑processamento X[k] = Fe[k] + e^{−2πik/N}·Fo[k], k = 0..M, que separa
+      as partes par/ímpar (e o inverso antes da IFFT complexa).
+
+ Mesmas convenções do FFTW r2c/c2r: sem normalização (inverse devolve N·x) e
+ parte imaginária dos bins 0 e N/2 ignorada no inverso. Espectro em pares
+ (re, im) intercalados, compatível com fftw_complex.
+
+ T = double ou float (instanciadas em RadixFFT.cpp). As tabelas são sempre
+ calculadas em double e só depois arredondadas para T.
+
+ Tabelas e rascunho são criados em setup(); forward/inverse não alocam.
+ Uma instância não é reentrante (o rascunho é partilhado).
+ */
+template <typename T>
+class RadixFFT {
+public:
+    // N potência de 2, N ≥ 4.
+    void setup(int n);
+
+    // x[N] -> X[N/2+1] (pares re/im)
+    void forward(const T* x, T* X);
+
+    // X[N/2+1] (pares re/im) -> x[N]·N. X não é alterado.
+    void inverse(const T* X, T* x);
+
+    // FFT complexa de M = N/2 pontos (pares re/im), in‑place; inverse sem normalização.
+    // Com setup(2·L) serve de FFT complexa de L pontos (two‑for‑one do FFTBackend).
+    void complexFFT(T* z, bool inverse) const;
+
+    int size() const { return N; }
+
+private:
+
+    int N = 0, M = 0;
+    std::vector<int> bitrev;        // [M] permutação de bits
+    std::vector<T> twiddle;         // [M−1] pares e^{−2πij/len}, estágio a estágio
+    std::vector<T> post;            // [M+1] pares e^{−2πik/N}
+    std::vector<T> z;               // [M] pares (rascunho)
+};
@@ -0,0 +1,457 @@
+#include "SpectralFX.hpp"
+
+namespace {
+
+/*
+ Variantes fundidas de Sharpen/Edge/Emboss (ver "Variantes compiladas" no
+ cabeçalho). Tap<E>: o efeito E num bin a partir de x[k−1], x[k], x[k+1] da
+ sua entrada, com raio R constexpr. fusedAt<E...>: a sequência inteira num
+ bin k, em registos: lê x[k−R..k+R] (R = soma dos raios) e aplica os
+ estágios um a um sobre janelas cada vez mais curtas. Só serve para bins
+ interiores (R ≤ k ≤ K−1−R); as bordas, onde a reflexão é sobre a imagem
+ intermédia, são feitas estágio a estágio em SpectralFX::stencil.
+*/
+struct StencilCoef {
+    float sharp, sC, edge, emboss3;     // sharpen a e 1 + 2a, edge, 3·emboss
+};
+
+template <Effect E> struct Tap;
+
+template <> struct Tap<Effect::SHARPEN> {   // (1+2a)·x[k] − a·(x[k−1] + x[k+1])
+    static constexpr int R = 1;
+    static float at(const StencilCoef& q, float wk, float xm, float x0, float xp) {
+        return x0 + wk * (q.sC * x0 - q.sharp * (xm + xp) - x0);
+    }
+};
+
+template <> struct Tap<Effect::EDGE> {      // Sobel(1,1) em 1×K = 0 -> ganho
+    static constexpr int R = 0;
+    static float at(const StencilCoef& q, float wk, float, float x0, float) {
+        return x0 * (1.f - wk * q.edge);
+    }
+};
+
+template <> struct Tap<Effect::EMBOSS> {    // −3·x[k−1] + x[k] + 3·x[k+1]
+    static constexpr int R = 1;
+    static float at(const StencilCoef& q, float wk, float xm, float x0, float xp) {
+        return x0 + q.emboss3 * wk * (xp - xm);
+    }
+};
+
+// Mesmas contas com o efeito escolhido em runtime (bordas)
+float tapAt(Effect e, const StencilCoef& q, float wk, float xm, float x0, float xp) {
+    switch (e) {
+        case Effect::SHARPEN: return Tap<Effect::SHARPEN>::at(q, wk, xm, x0, xp);
+        case Effect::EDGE:    return Tap<Effect::EDGE>::at(q, wk, xm, x0, xp);
+        default:              return Tap<Effect::EMBOSS>::at(q, wk, xm, x0, xp);
+    }
+}
+
+constexpr int tapRadius(Effect e) { return e == Effect::EDGE ? 0 : 1; }
+
+// Aplica E..Rest a v[N] (bins k−h..k+h, h = (N−1)/2); wk aponta para w[k]
+template <Effect E, Effect... Rest, size_t N>
+float applyStages(const StencilCoef& q, const std::array<float, N>& v, const float* wk) {
+    constexpr int R = Tap<E>::R, M = (int)N - 2 * R, h = (M - 1) / 2;
+    std::array<float, M> y;
+    for (int i = 0; i < M; ++i) y[i] = Tap<E>::at(q, wk[i - h], v[i], v[i + R], v[i + 2 * R]);
+    if constexpr (sizeof...(Rest) > 0) return applyStages<Rest...>(q, y, wk);
+    else                               return y[0];
+}
+
+// y[k·C + c] para R ≤ k0 ≤ k ≤ k1 ≤ K−1−R, a partir da cópia x (sem aliasing com y)
+template <Effect... Es>
+void runFused(const StencilCoef& q, const float* x, float* y, const float* w, int k0, int k1, int C) {
+    constexpr int R = (Tap<Es>::R + ...);
+    auto bin = [&](int k, int c) {
+        std::array<float, 2 * R + 1> v;
+        for (int i = 0; i <= 2 * R; ++i) v[i] = x[(k - R + i) * C + c];
+        return applyStages<Es...>(q, v, w + k);
+    };
+    if (C == 1)     // mono: vetoriza ao longo dos bins
+        for (int k = k0; k <= k1; ++k) y[k] = bin(k, 0);
+    else
+        for (int k = k0; k <= k1; ++k)
+            for (int c = 0; c < C; ++c) y[k * C + c] = bin(k, c);
+}
+
+// Tabela de variantes: código = Σ (efeito − SHARPEN + 1)·4^i sobre a sequência
+using StencilKernel = void (*)(const StencilCoef&, const float*, float*, const float*, int, int, int);
+constexpr int STENCIL_CODES = 64;
+
+constexpr int stencilDigit(Effect e) { return (int)e - (int)Effect::SHARPEN + 1; }
+
+template <Effect... Es> constexpr int stencilCode() {
+    int code = 0, m = 1;
+    ((code += stencilDigit(Es) * m, m *= 4), ...);
+    return code;
+}
+
+template <Effect E, Effect... Es> constexpr bool contains() { return ((E == Es) || ...); }
+
+template <Effect... Es>
+void addStencilVariants(std::array<StencilKernel, STENCIL_CODES>& t) {
+    if constexpr (sizeof...(Es) > 0) t[stencilCode<Es...>()] = &runFused<Es...>;
+    if constexpr (sizeof...(Es) < 3) {
+        if constexpr (!contains<Effect::SHARPEN, Es...>()) addStencilVariants<Es..., Effect::SHARPEN>(t);
+        if constexpr (!contains<Effect::EDGE, Es...>())    addStencilVariants<Es..., Effect::EDGE>(t);
+        if constexpr (!contains<Effect::EMBOSS, Es...>())  addStencilVariants<Es..., Effect::EMBOSS>(t);
+    }
+}
+
+const std::array<StencilKernel, STENCIL_CODES> kStencilVariants = [] {
+    std::array<StencilKernel, STENCIL_CODES> t {};
+    addStencilVariants<>(t);
+    return t;
+}();
+
+bool isStencil(Effect e) { return e == Effect::SHARPEN || e == Effect::EDGE || e == Effect::EMBOSS; }
+
+} // namespace
+
+const char* SpectralFX::name(Effect e) {
+    static const char* const names[] = { "Blur", "Sharpen", "Edge", "Emboss", "Gate", "Mirror", "Stretch" };
+    return (int)e < (int)Effect::NUM_EFFECTS ? names[(int)e] : "?";
+}
+
+bool SpectralFX::isPermutation(const FXOrder& order) {
+    unsigned seen = 0;
+    for (Effect e : order) {
+        if ((int)e >= (int)Effect::NUM_EFFECTS) return false;
+        seen |= 1u << (int)e;
+    }
+    return seen == (1u << (int)Effect::NUM_EFFECTS) - 1;
+}
+
+bool SpectralFX::active(Effect e, const FXParams& p) {
+    switch (e) {
+        case Effect::BLUR:    return p.blur > 0.f;
+        case Effect::SHARPEN: return p.sharpen > 0.f;
+        case Effect::EDGE:    return p.edge > 0.f;
+        case Effect::EMBOSS:  return p.emboss > 0.f;
+        case Effect::GATE:    return p.gate > 0.f;
+        case Effect::MIRROR:  return p.mirror > 0.f;
+        case Effect::STRETCH: return std::abs(p.stretch - 0.5f) > 1e-3f;
+        default:              return false;
+    }
+}
+
+// Reserva buffers de trabalho para K bins × maxChannels vozes
+void SpectralFX::setup(int bins, int maxChannels) {
+    K    = bins;
+    maxC = std::max(1, maxChannels);
+    C    = 1;
+    PAD  = std::min(64, K - 1);                             // ≥ 5σ para σ = 12 (cauda do IIR)
+    padded.assign((size_t)(K + 2 * PAD) * maxC, 0.f);
+    resampled.assign(((size_t)(1.5 * K) + 2) * maxC, 0.f); // Stretch até ×1.5
+    gauss.reserve(32);                                      // ksize ≤ 25 (σ < 3)
+    gaussSigma = -1.f;
+    lane.assign(8 * (size_t)maxC, 0.f);
+    unit.assign(K, 1.f);
+}
+
+// Cadeia completa sobre um frame de C vozes ([K][C])
+void SpectralFX::process(const float* magIn, float* magOut, int channels, const FXParams& p, const float* weight) {
+    C = std::clamp(channels, 1, maxC);
+    float* mag = magOut;
+    if (mag != magIn) std::copy(magIn, magIn + K * C, mag);
+
+    // Bins com peso > 0: [lo, hi] (máscara vazia -> nenhum efeito)
+    const float* w = weight ? weight : unit.data();
+    int lo = 0, hi = K - 1;
+    while (lo < K && w[lo] <= 0.f) ++lo;
+    while (hi >= lo && w[hi] <= 0.f) --hi;
+
+    // Efeitos ativos pela ordem pedida; seguidos, os de vizinhança (e Gate -> Mirror) fundem‑se
+    const FXOrder& order = isPermutation(p.order) ? p.order : DEFAULT_FX_ORDER;
+    Effect run[(int)Effect::NUM_EFFECTS];
+    int n = 0;
+    for (Effect e : order)
+        if (active(e, p)) run[n++] = e;
+
+    for (int i = 0; lo <= hi && i < n; ) {
+        const Effect e = run[i];
+        if (e == Effect::BLUR) {
+            blur(mag, p.blur * BLUR_MAX_SIGMA / binWidth, w, lo, hi);
+            ++i;
+        } else if (e == Effect::STRETCH) {
+            stretch(mag, 0.5f + p.stretch, w, lo, hi);
+            ++i;
+        } else if (generic) {
+            genericPass(e, mag, p, w);
+            ++i;
+        } else if (isStencil(e)) {
+            int j = i + 1;
+            while (j < n && isStencil(run[j])) ++j;
+            stencil(run + i, j - i, mag, p, w, lo, hi);
+            i = j;
+        } else if (e == Effect::GATE && i + 1 < n && run[i + 1] == Effect::MIRROR) {
+            gateMirror<true, true>(mag, p.gate, p.mirror, w);
+            i += 2;
+        } else {
+            if (e == Effect::GATE) gateMirror<true, false>(mag, p.gate, 0.f, w);
+            else                   gateMirror<false, true>(mag, 0.f, p.mirror, w);
+            ++i;
+        }
+    }
+
+    // Piso mínimo evita zeros que podem causar instabilidades de fase
+    for (int i = 0; i < K * C; ++i)
+        mag[i] = std::max(mag[i], 0.f) + MAG_EPS;
+}
+
+// Blur gaussiano (σ em bins). Kernel exato para σ pequeno, IIR para σ grande.
+void SpectralFX::blur(float* mag, float sigma, const float* w, int lo, int hi) {
+    // Cópia com margens refletidas: o filtro lê sempre 'padded', escreve em 'mag'.
+    float* x = padded.data() + PAD * C;
+    std::copy(mag, mag + K * C, x);
+    for (int i = 1; i <= PAD; ++i) {
+        std::copy_n(mag + reflect(-i) * C,        C, x - i * C);
+        std::copy_n(mag + reflect(K - 1 + i) * C, C, x + (K - 1 + i) * C);
+    }
+
+    if (sigma < BLUR_DIRECT_SIGMA) {
+        // Kernel exato do cv::getGaussianKernel (recalculado só quando σ muda).
+        if (sigma != gaussSigma) {
+            int ksize = (int)std::lrint(sigma * 8.0 + 1.0) | 1;
+            gauss.resize(ksize);
+            double sum = 0.0;
+            for (int i = 0; i < ksize; ++i) {
+                double t = i - (ksize - 1) * 0.5;
+                gauss[i] = (float)std::exp(-0.5 / ((double)sigma * sigma) * t * t);
+                sum += gauss[i];
+            }
+            for (float& g : gauss) g = (float)(g / sum);
+            gaussSigma = sigma;
+        }
+        const int r = (int)gauss.size() / 2;
+        float* acc = lane.data();
+        for (int k = lo; k <= hi; ++k) {
+            const float* src = x + (k - r) * C;
+            std::fill_n(acc, C, 0.f);
+            for (int j = 0; j < (int)gauss.size(); ++j) {
+                const float g = gauss[j];
+                const float* row = src + j * C;
+                for (int c = 0; c < C; ++c) acc[c] += g * row[c];
+            }
+            const float wk = w[k];
+            const float* xk = x + k * C;
+            float* dst = mag + k * C;
+            for (int c = 0; c < C; ++c) dst[c] = xk[c] + wk * (acc[c] - xk[c]);
+        }
+        return;
+    }
+
+    // Young & van Vliet (1995): IIR de 3ª ordem causal + anti‑causal.
+    const double s = sigma;
+    const double q = (s >= 2.5) ? 0.98711 * s - 0.96330 : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * s);
+    const double q2 = q * q, q3 = q2 * q;
+    const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+    const float c1 = (float)((2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / b0);
+    const float c2 = (float)(-(1.4281 * q2 + 1.26661 * q3) / b0);
+    const float c3 = (float)(0.422205 * q3 / b0);
+    const float B  = 1.f - (c1 + c2 + c3);
+
+    float* v = padded.data();
+    const int L = K + 2 * PAD;
+    float* w1 = lane.data();
+    float* w2 = w1 + maxC;
+    float* w3 = w2 + maxC;
+
+    // Estado estacionário na borda; vozes no laço interno
+    std::copy_n(v, C, w1); std::copy_n(v, C, w2); std::copy_n(v, C, w3);
+    for (int i = 0; i < L; ++i) {
+        float* row = v + i * C;
+        for (int c = 0; c < C; ++c) {
+            float y = B * row[c] + c1 * w1[c] + c2 * w2[c] + c3 * w3[c];
+            w3[c] = w2[c]; w2[c] = w1[c]; w1[c] = y;
+            row[c] = y;
+        }
+    }
+    const float* last = v + (L - 1) * C;
+    std::copy_n(last, C, w1); std::copy_n(last, C, w2); std::copy_n(last, C, w3);
+    for (int i = L - 1; i >= 0; --i) {
+        float* row = v + i * C;
+        for (int c = 0; c < C; ++c) {
+            float y = B * row[c] + c1 * w1[c] + c2 * w2[c] + c3 * w3[c];
+            w3[c] = w2[c]; w2[c] = w1[c]; w1[c] = y;
+            row[c] = y;
+        }
+    }
+    // 'mag' ainda tem a entrada; 'x' o resultado filtrado
+    for (int k = lo; k <= hi; ++k) {
+        const float wk = w[k];
+        const float* yk = x + k * C;
+        float* dst = mag + k * C;
+        for (int c = 0; c < C; ++c) dst[c] += wk * (yk[c] - dst[c]);
+    }
+}
+
+// Sequência de 1..3 efeitos de vizinhança numa passagem (variante da tabela)
+void SpectralFX::stencil(const Effect* run, int n, float* mag, const FXParams& p, const float* w, int lo, int hi) {
+    int code = 0, R = 0;
+    for (int i = 0, m = 1; i < n; ++i, m *= 4) {
+        code += stencilDigit(run[i]) * m;
+        R += tapRadius(run[i]);
+    }
+    if (K < 2 * R + 1) {                            // frames minúsculos: um passe por efeito
+        for (int i = 0; i < n; ++i) genericPass(run[i], mag, p, w);
+        return;
+    }
+    const float sharp = p.sharpen / (binWidth * binWidth), emboss = p.emboss / binWidth;   // ver setBinWidth()
+    const StencilCoef q = { sharp, 1.f + 2.f * sharp, p.edge, 3.f * emboss };
+
+    // Fora de [lo, hi] cada estágio devolve a entrada: só [lo−R, hi+R] é lido, só [lo, hi] muda
+    const int r0 = std::max(0, lo - R), r1 = std::min(K - 1, hi + R);
+    float* x = padded.data();
+    std::copy(mag + r0 * C, mag + (r1 + 1) * C, x + r0 * C);
+
+    const int k0 = std::max(lo, R), k1 = std::min(hi, K - 1 - R);
+    if (k0 <= k1) kStencilVariants[code](q, x, mag, w, k0, k1, C);
+
+    // Bordas: janela de 2R linhas a partir da ponta (a de trás espelhada), estágio a estágio,
+    // com a linha −1 = linha 1 da imagem intermédia; ficam válidas as R primeiras.
+    auto edge = [&](bool back) {
+        float* a = lane.data();
+        float* b = a + 4 * (size_t)maxC;
+        auto bin = [&](int r) { return back ? K - 1 - r : r; };
+        const int W = 2 * R;
+        for (int r = 0; r < W; ++r) std::copy_n(x + bin(r) * C, C, a + r * C);
+        for (int i = 0, valid = W; i < n; ++i) {
+            const int Rs = tapRadius(run[i]);
+            for (int r = 0; r < valid - Rs; ++r) {
+                const float* am = a + (r == 0 ? 1 : r - 1) * C;
+                const float* ap = a + (r + 1) * C;
+                const float wk = w[bin(r)];
+                for (int c = 0; c < C; ++c)
+                    b[r * C + c] = back ? tapAt(run[i], q, wk, ap[c], a[r * C + c], am[c])
+                                        : tapAt(run[i], q, wk, am[c], a[r * C + c], ap[c]);
+            }
+            valid -= Rs;
+            std::swap(a, b);
+        }
+        for (int r = 0; r < R; ++r) std::copy_n(a + r * C, C, mag + bin(r) * C);
+    };
+    if (R > 0 && lo < R)         edge(false);
+    if (R > 0 && hi > K - 1 - R) edge(true);
+}
+
+// Gate (limiar relativo ao máximo de cada voz) e/ou Mirror, por pares (k, K−1−k), in‑place.
+// Gate: x·(1 − w·gate) abaixo do limiar. Mirror: g + w·mirror·(g' − g), g' = bin espelhado.
+template <bool Gate, bool Mirror>
+void SpectralFX::gateMirror(float* mag, float gateAmt, float mirrorAmt, const float* w) {
+    float* th = lane.data();
+    if constexpr (Gate) {
+        std::copy_n(mag, C, th);
+        for (int k = 1; k < K; ++k) {
+            const float* row = mag + k * C;
+            for (int c = 0; c < C; ++c) th[c] = std::max(th[c], row[c]);
+        }
+        for (int c = 0; c < C; ++c) th[c] *= gateAmt;
+    }
+    int i = 0, j = K - 1;
+    for (; i < j; ++i, --j) {
+        float* ri = mag + i * C;
+        float* rj = mag + j * C;
+        const float gI = 1.f - w[i] * gateAmt, gJ = 1.f - w[j] * gateAmt;
+        const float mI = w[i] * mirrorAmt, mJ = w[j] * mirrorAmt;
+        for (int c = 0; c < C; ++c) {
+            float gi = ri[c], gj = rj[c];
+            if constexpr (Gate) {
+                gi = gi < th[c] ? gi * gI : gi;
+                gj = gj < th[c] ? gj * gJ : gj;
+            }
+            if constexpr (Mirror) {
+                const float mi = gi + mI * (gj - gi);
+                const float mj = gj + mJ * (gi - gj);
+                gi = mi; gj = mj;
+            }
+            ri[c] = gi;
+            rj[c] = gj;
+        }
+    }
+    if constexpr (Gate) {                           // bin central (K ímpar): sem par a espelhar
+        if (i == j) {
+            float* ri = mag + i * C;
+            const float gI = 1.f - w[i] * gateAmt;
+            for (int c = 0; c < C; ++c) ri[c] = ri[c] < th[c] ? ri[c] * gI : ri[c];
+        }
+    }
+}
+
+/*
+ Caminho genérico: um passe pelos K bins para um só efeito de vizinhança,
+ Gate ou Mirror, com o efeito decidido dentro do laço. Mesmas contas (e
+ reflexões) das variantes; lê uma cópia da entrada em 'padded'.
+*/
+void SpectralFX::genericPass(Effect e, float* mag, const FXParams& p, const float* w) {
+    if (K < 3) return;
+    float* x = padded.data() + C;
+    std::copy(mag, mag + K * C, x);
+    std::copy_n(mag + C, C, x - C);                         // x[−1] = x[1]
+    std::copy_n(mag + (K - 2) * C, C, x + K * C);           // x[K] = x[K−2]
+
+    float* th = lane.data();
+    std::fill_n(th, C, -1.f);
+    if (e == Effect::GATE) {
+        std::copy_n(x, C, th);
+        for (int k = 1; k < K; ++k)
+            for (int c = 0; c < C; ++c) th[c] = std::max(th[c], x[k * C + c]);
+        for (int c = 0; c < C; ++c) th[c] *= p.gate;
+    }
+    const float sharp = p.sharpen / (binWidth * binWidth), emboss = p.emboss / binWidth;   // ver setBinWidth()
+    const float sC = 1.f + 2.f * sharp;
+    for (int k = 0; k < K; ++k) {
+        const float* xm = x + (k - 1) * C;
+        const float* x0 = x + k * C;
+        const float* xp = x + (k + 1) * C;
+        const float* xr = x + (K - 1 - k) * C;
+        const float wk = w[k];
+        float* y = mag + k * C;
+        for (int c = 0; c < C; ++c) {
+            switch (e) {
+                case Effect::SHARPEN: y[c] = x0[c] + wk * (sC * x0[c] - sharp * (xm[c] + xp[c]) - x0[c]); break;
+                case Effect::EDGE:    y[c] = x0[c] * (1.f - wk * p.edge); break;
+                case Effect::EMBOSS:  y[c] = x0[c] + 3.f * emboss * wk * (xp[c] - xm[c]); break;
+                case Effect::GATE:    y[c] = x0[c] < th[c] ? x0[c] * (1.f - wk * p.gate) : x0[c]; break;
+                case Effect::MIRROR:  y[c] = x0[c] + wk * p.mirror * (xr[c] - x0[c]); break;
+                default:              break;
+            }
+        }
+    }
+}
+
+/*
+ Stretch: K -> W = round(K·f) -> K com interpolação linear, replicando o
+ cv::resize(INTER_LINEAR): sx = (dx + 0.5)·escala − 0.5, com clamp nas bordas.
+*/
+void SpectralFX::stretch(float* mag, float factor, const float* w, int lo, int hi) {
+    const int W = (int)std::lrint((double)K * (double)factor);
+    if (W == K || W < 1) return;                    // cv::resize copia se o tamanho não muda
+
+    // 1ª passagem escreve (w = nullptr); a 2ª mistura com o peso de cada bin
+    const int nc = C;
+    auto resample = [nc](const float* src, int srcN, float* dst, double scale, int d0, int d1, const float* w) {
+        for (int dx = d0; dx <= d1; ++dx) {
+            float fx = (float)((dx + 0.5) * scale - 0.5);
+            int sx = (int)std::floor(fx);
+            fx -= (float)sx;
+            if (sx < 0)         { sx = 0; fx = 0.f; }
+            if (sx >= srcN - 1) { sx = srcN - 1; fx = 0.f; }
+            const float* s0 = src + sx * nc;
+            const float* s1 = fx > 0.f ? s0 + nc : s0;
+            float* d = dst + dx * nc;
+            if (!w) {
+                if (fx > 0.f) for (int c = 0; c < nc; ++c) d[c] = s0[c] * (1.f - fx) + s1[c] * fx;
+                else          std::copy_n(s0, nc, d);
+            } else {
+                const float wd = w[dx];
+                for (int c = 0; c < nc; ++c) d[c] += wd * (s0[c] * (1.f - fx) + s1[c] * fx - d[c]);
+            }
+        }
+    };
+
+    float* tmp = resampled.data();
+    resample(mag, K, tmp, 1.0 / (double)factor, 0, W - 1, nullptr);
+    resample(tmp, W, mag, 1.0 / ((double)K / W), lo, hi, w);  // só os bins com peso mudam
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+/*
+ SpectralFX
+
+ Cadeia de efeitos 1D sobre a magnitude de um frame (K bins), sem OpenCV e
+ sem alocações no thread de áudio: todos os buffers de trabalho são criados
+ em setup() (um SpectralFX por canal).
+
+ Ordem configurável por canal (FXParams::order, uma permutação dos 7
+ efeitos); por omissão Blur -> Sharpen -> Edge -> Emboss -> Gate -> Mirror
+ -> Stretch, a do caminho OpenCV. Efeitos em repouso são saltados.
+ Máscara: um vetor de pesos w[k] ∈ [0, 1] por frame (ver Mask2D). Cada
+ efeito E mistura-se com a sua entrada x por um multiply‑add por bin,
+    y[k] = x[k] + w[k]·(E(x)[k] − x[k]),
+ logo w = 0 deixa o bin intacto e w = 1 aplica o efeito inteiro. Os laços
+ correm só entre o 1º e o último bin com peso > 0.
+
+ Equivalência com o caminho OpenCV original (cv::Mat 1×K, BORDER_REFLECT_101):
+    - Blur    : Gaussiana σ = 12·amt. Para σ < 3 usa o kernel exato do OpenCV
+                (ksize = round(8σ+1)|1, ≤ 25 taps). Para σ ≥ 3 usa o filtro
+                recursivo de Young–van Vliet (custo constante em σ).
+    - Sharpen : o kernel 3×3 numa imagem de 1 linha reduz-se a
+                (1+2a)·x[k] − a·(x[k−1] + x[k+1]).
+    - Edge    : Sobel(dx=1, dy=1) numa imagem de 1 linha é identicamente 0
+                (a derivada vertical anula-se), logo o efeito é o ganho (1−amt).
+    - Emboss  : kernel 3×3 somado por colunas = −3·x[k−1] + x[k] + 3·x[k+1].
+    - Stretch : duas reamostragens lineares (K -> round(K·f) -> K) com a mesma
+                convenção de centros de pixel do cv::resize(INTER_LINEAR).
+ Tolerância face ao caminho OpenCV: idêntico (a menos de arredondamento float)
+ em todos os efeitos exceto o Blur recursivo (σ ≥ 3), cujo erro máximo é
+ ≤ 1.5% do pico do frame (tipicamente < 0.5%). Ver 'spectrofx-bench --verify-fx'.
+
+ Variantes compiladas
+    - Sharpen, Edge e Emboss seguidos na ordem (ignorando os em repouso)
+      correm fundidos numa única passagem pelos K bins, instanciada por
+      template para cada sequência possível (15 variantes, tabela indexada
+      pela sequência). Os raios são constexpr (1 ou 0): cada bin interior
+      lê x[k−R..k+R] (R = soma dos raios) e compõe os estágios em
+      registos, sem imagens intermédias nem ramos por efeito; com C = 1 o
+      laço vetoriza ao longo dos bins. As R linhas de cada ponta, onde a
+      reflexão é sobre a imagem intermédia, fazem‑se estágio a estágio.
+    - Gate seguido de Mirror corre numa passagem (por pares k / K−1−k);
+      sozinhos, ou Mirror antes de Gate, cada um na sua variante.
+    - Blur e Stretch mantêm as suas passagens.
+    - setGeneric(true) troca as variantes por um passe por efeito com o
+      efeito escolhido por bin (mesmas contas), para comparação no
+      benchmark ('spectrofx-bench --verify-chain').
+
+ Polifonia: um frame pode conter C vozes com os mesmos parâmetros, em layout
+ "bin‑major" mag[k·C + c]. Todos os kernels percorrem os bins no laço externo
+ e as vozes no interno (vetorizável, um só passe para as C vozes). Com C = 1
+ o resultado é o mesmo de antes.
+ */
+
+// Efeitos da cadeia (elementos de FXParams::order)
+enum class Effect : uint8_t { BLUR = 0, SHARPEN, EDGE, EMBOSS, GATE, MIRROR, STRETCH, NUM_EFFECTS };
+using FXOrder = std::array<Effect, (size_t)Effect::NUM_EFFECTS>;
+
+constexpr FXOrder DEFAULT_FX_ORDER = { Effect::BLUR, Effect::SHARPEN, Effect::EDGE, Effect::EMBOSS,
+                                       Effect::GATE, Effect::MIRROR, Effect::STRETCH };
+
+// Ordem num só uint32_t (4 bits por posição): publicável num std::atomic entre threads
+constexpr uint32_t packFXOrder(const FXOrder& order) {
+    uint32_t bits = 0;
+    for (size_t i = 0; i < order.size(); ++i) bits |= (uint32_t)order[i] << (4 * i);
+    return bits;
+}
+
+constexpr FXOrder unpackFXOrder(uint32_t bits) {
+    FXOrder order {};
+    for (size_t i = 0; i < order.size(); ++i) order[i] = Effect((bits >> (4 * i)) & 0xF);
+    return order;
+}
+
+// Intensidades dos efeitos em [0..1]. Stretch em repouso = 0.5.
+struct FXParams {
+    float blur    = 0.f;
+    float sharpen = 0.f;
+    float edge    = 0.f;
+    float emboss  = 0.f;
+    float mirror  = 0.f;
+    float gate    = 0.f;
+    float stretch = 0.5f;
+    FXOrder order = DEFAULT_FX_ORDER;   // ordem da cadeia (permutação; outra coisa -> omissão)
+
+    // Todos em repouso: a cadeia só aplica o piso MAG_EPS (o STFT reconstrói a entrada)
+    bool atRest() const {
+        return blur <= 0.f && sharpen <= 0.f && edge <= 0.f && emboss <= 0.f
+            && mirror <= 0.f && gate <= 0.f && std::abs(stretch - 0.5f) <= 1e-3f;
+    }
+};
+
+class SpectralFX {
+public:
+    static constexpr float BLUR_MAX_SIGMA    = 12.f;    // σ com o knob no máximo (bins)
+    static constexpr float BLUR_DIRECT_SIGMA = 3.f;     // abaixo disto: kernel exato
+    static constexpr float MAG_EPS           = 1e-6f;   // piso mínimo da magnitude
+
+    // Reserva buffers de trabalho para K bins × até maxChannels vozes (fora do thread de áudio).
+    void setup(int bins, int maxChannels = 1);
+
+    /*
+    Largura de um bin face à resolução de referência (p.ex. 4 com N/4): os
+    efeitos de vizinhança mantêm o efeito em Hz. Blur: σ ÷ ratio. Sharpen é
+    uma 2ª diferença (∝ largura²): amt ÷ ratio². Emboss é uma 1ª diferença
+    (∝ largura): amt ÷ ratio.
+    */
+    void setBinWidth(float ratio) { binWidth = ratio; }
+
+    /*
+    Aplica a cadeia a um frame de C vozes (layout [K][C]).
+     - magIn[K·C]  : magnitude da análise.
+     - magOut[K·C] : magnitude processada (≥ MAG_EPS). Pode coincidir com magIn.
+     - channels    : nº de vozes C (1..maxChannels).
+     - weight[K]   : peso da máscara por bin, comum às vozes (nullptr = 1 em todos).
+    */
+    void process(const float* magIn, float* magOut, int channels, const FXParams& p, const float* weight);
+
+    // Frame mono (C = 1).
+    void process(const float* magIn, float* magOut, const FXParams& p, const float* weight) {
+        process(magIn, magOut, 1, p, weight);
+    }
+
+    // Caminho genérico (um passe por efeito, sem variantes): só para comparação
+    void setGeneric(bool on) { generic = on; }
+
+    static const char* name(Effect e);              // "Blur", "Sharpen", …
+    static bool isPermutation(const FXOrder& order); // cada efeito exatamente uma vez
+    static bool active(Effect e, const FXParams& p); // fora de repouso
+
+private:
+    void blur(float* mag, float sigma, const float* w, int lo, int hi);
+    void stencil(const Effect* run, int n, float* mag, const FXParams& p, const float* w, int lo, int hi);
+    template <bool Gate, bool Mirror>
+    void gateMirror(float* mag, float gateAmt, float mirrorAmt, const float* w);
+    void stretch(float* mag, float factor, const float* w, int lo, int hi);
+    void genericPass(Effect e, float* mag, const FXParams& p, const float* w);
+
+    // Índice com reflexão BORDER_REFLECT_101 (… 2 1 | 0 1 2 … K−1 | K−2 …).
+    inline int reflect(int i) const {
+        while (i < 0 || i >= K) {
+            if (i < 0)  i = -i;
+            if (i >= K) i = 2 * (K - 1) - i;
+        }
+        return i;
+    }
+
+    int K    = 0;   // nº de bins
+    int PAD  = 0;   // margem refletida do blur recursivo
+    int C    = 1;   // nº de vozes do frame atual
+    int maxC = 1;   // nº máximo de vozes (setup)
+    float binWidth = 1.f;   // bins de referência por bin (ver setBinWidth)
+    bool generic = false;   // setGeneric()
+
+    std::vector<float> padded;      // [(PAD + K + PAD)·C] (blur; cópia da entrada do stencil)
+    std::vector<float> resampled;   // [(≤ 1.5·K + 1)·C]   (stretch)
+    std::vector<float> gauss;       // kernel direto (≤ 25 taps)
+    float gaussSigma = -1.f;        // σ do kernel em cache
+    std::vector<float> lane;        // [8·maxC] estado por voz (IIR, gate; 2×4 linhas das bordas do stencil)
+    std::vector<float> unit;        // [K] pesos = 1 (sem máscara)
+};
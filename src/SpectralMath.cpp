@@ -0,0 +1,141 @@
+#include "SpectralMath.hpp"
+#include "SpectralMathKernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define SPECTRAL_MATH_X86 1
+#endif
+
+namespace SpectralMath {
+
+// Variantes AVX2/AVX‑512 (SpectralMath_avx2.cpp / _avx512.cpp, compiladas com as flags da ISA)
+#if defined(SPECTRAL_MATH_X86)
+extern const bool avx2Compiled, avx512Compiled;
+void cartToPolarAVX2  (const float*, const float*, float*, float*, int);
+void polarToCartAVX2  (const float*, const float*, float*, float*, int);
+void cartToPolarAVX512(const float*, const float*, float*, float*, int);
+void polarToCartAVX512(const float*, const float*, float*, float*, int);
+void tanhScaledAVX2  (const float*, float*, int, float, float);
+void tanhScaledAVX512(const float*, float*, int, float, float);
+#endif
+
+namespace {
+
+#if defined(SPECTRAL_MATH_X86)
+// Traits SSE2 (4 floats). Sem FMA: fmadd = mul + add.
+struct SseOps {
+    using T = __m128; using I = __m128i; using M = __m128;
+    static constexpr int W = 4;
+    static T load(const float* p)            { return _mm_loadu_ps(p); }
+    static void store(float* p, T v)         { _mm_storeu_ps(p, v); }
+    static T set1(float v)                   { return _mm_set1_ps(v); }
+    static T add(T a, T b)                   { return _mm_add_ps(a, b); }
+    static T sub(T a, T b)                   { return _mm_sub_ps(a, b); }
+    static T mul(T a, T b)                   { return _mm_mul_ps(a, b); }
+    static T fmadd(T a, T b, T c)            { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static T div(T a, T b)                   { return _mm_div_ps(a, b); }
+    static T sqrt(T a)                       { return _mm_sqrt_ps(a); }
+    static T min(T a, T b)                   { return _mm_min_ps(a, b); }
+    static T max(T a, T b)                   { return _mm_max_ps(a, b); }
+    static T abs(T a)                        { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+    static M gt(T a, T b)                    { return _mm_cmpgt_ps(a, b); }
+    static M eq(T a, T b)                    { return _mm_cmpeq_ps(a, b); }
+    static M signbit(T a)                    { return _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(a), 31)); }
+    static T select(M m, T a, T b)           { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static T neg_if(M m, T a)                { return _mm_xor_ps(a, _mm_and_ps(m, _mm_set1_ps(-0.f))); }
+    static I round_i(T a)                    { return _mm_cvtps_epi32(a); }
+    static T to_float(I a)                   { return _mm_cvtepi32_ps(a); }
+    static I add_i(I a, int b)               { return _mm_add_epi32(a, _mm_set1_epi32(b)); }
+    static M bit_set(I a, int bit)           { I b = _mm_set1_epi32(bit); return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(a, b), b)); }
+};
+#endif
+
+using Fn = void (*)(const float*, const float*, float*, float*, int);
+using TanhFn = void (*)(const float*, float*, int, float, float);
+
+void cartToPolarScalar(const float* a, const float* b, float* c, float* d, int n) { smk::cartToPolar<smk::ScalarOps>(a, b, c, d, n); }
+void polarToCartScalar(const float* a, const float* b, float* c, float* d, int n) { smk::polarToCart<smk::ScalarOps>(a, b, c, d, n); }
+void tanhScaledScalar(const float* a, float* b, int n, float pre, float post)      { smk::tanhScaled<smk::ScalarOps>(a, b, n, pre, post); }
+#if defined(SPECTRAL_MATH_X86)
+void cartToPolarSSE2(const float* a, const float* b, float* c, float* d, int n)   { smk::cartToPolar<SseOps>(a, b, c, d, n); }
+void polarToCartSSE2(const float* a, const float* b, float* c, float* d, int n)   { smk::polarToCart<SseOps>(a, b, c, d, n); }
+void tanhScaledSSE2(const float* a, float* b, int n, float pre, float post)        { smk::tanhScaled<SseOps>(a, b, n, pre, post); }
+#endif
+
+// Suporte da ISA: compilada neste binário e disponível neste CPU/SO.
+bool supported(Isa isa) {
+    switch (isa) {
+        case Isa::SCALAR: return true;
+#if defined(SPECTRAL_MATH_X86)
+        case Isa::SSE2:   return true;  // base x86‑64
+        case Isa::AVX2:   return avx2Compiled && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Isa::AVX512: return avx512Compiled && __builtin_cpu_supports("avx512f");
+#endif
+        default:          return false;
+    }
+}
+
+struct Dispatch {
+    Isa isa = Isa::SCALAR;
+    Fn toPolar = cartToPolarScalar;
+    Fn toCart  = polarToCartScalar;
+    TanhFn tanh = tanhScaledScalar;
+
+    void select(Isa i) {
+        isa = i;
+        switch (i) {
+#if defined(SPECTRAL_MATH_X86)
+            case Isa::SSE2:   toPolar = cartToPolarSSE2;   toCart = polarToCartSSE2;   tanh = tanhScaledSSE2;   break;
+            case Isa::AVX2:   toPolar = cartToPolarAVX2;   toCart = polarToCartAVX2;   tanh = tanhScaledAVX2;   break;
+            case Isa::AVX512: toPolar = cartToPolarAVX512; toCart = polarToCartAVX512; tanh = tanhScaledAVX512; break;
+#endif
+            default:          toPolar = cartToPolarScalar; toCart = polarToCartScalar; tanh = tanhScaledScalar; break;
+        }
+    }
+
+    Dispatch() { select(bestIsa()); }
+};
+
+Dispatch& dispatch() {
+    static Dispatch d;  // deteção 1× (thread-safe desde C++11)
+    return d;
+}
+
+} // namespace
+
+Isa bestIsa() {
+    for (int i = (int)Isa::NUM_ISAS - 1; i > 0; --i)
+        if (supported((Isa)i)) return (Isa)i;
+    return Isa::SCALAR;
+}
+
+Isa activeIsa() { return dispatch().isa; }
+
+bool setIsa(Isa isa) {
+    if (!supported(isa)) return false;
+    dispatch().select(isa);
+    return true;
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::SSE2:   return "sse2";
+        case Isa::AVX2:   return "avx2";
+        case Isa::AVX512: return "avx512";
+        default:          return "scalar";
+    }
+}
+
+void cartToPolar(const float* re, const float* im, float* mag, float* phase, int n) {
+    dispatch().toPolar(re, im, mag, phase, n);
+}
+
+void polarToCart(const float* mag, const float* phase, float* re, float* im, int n) {
+    dispatch().toCart(mag, phase, re, im, n);
+}
+
+void tanhScaled(const float* in, float* out, int n, float pre, float post) {
+    dispatch().tanh(in, out, n, pre, post);
+}
+
+} // namespace SpectralMath
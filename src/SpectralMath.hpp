@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+ SpectralMath
+
+ Conversões polar <-> cartesiano por bloco (magnitude/fase <-> re/im) e
+ tanh por bloco (soft‑limiter da saída do SpectroEngine), com kernels SIMD
+ escolhidos em runtime: AVX‑512, AVX2+FMA, SSE2 ou escalar.
+ Todas as variantes usam as mesmas aproximações polinomiais (ver
+ SpectralMathKernels.hpp), com erro máximo:
+    atan2   ≤ 3.0e−7 rad
+    sin/cos ≤ 1.2e−7 (absoluto, |φ| ≤ 8192; o PhaseEngine mantém φ em (−π, π])
+    mag     ≤ 1.2e−7 relativo (sqrt IEEE; só o arredondamento de re² + im²)
+    tanh    ≤ 5.0e−7 (absoluto; racional, usado pelo limiter da saída)
+ Verificável com 'spectrofx-bench --verify-math'.
+
+ A deteção de ISA corre uma vez (inicialização estática); as chamadas seguintes
+ são uma indireção por bloco.
+ */
+namespace SpectralMath {
+
+enum class Isa { SCALAR = 0, SSE2, AVX2, AVX512, NUM_ISAS };
+
+// mag[k] = √(re² + im²), phase[k] = atan2(im, re), k ∈ [0, n)
+void cartToPolar(const float* re, const float* im, float* mag, float* phase, int n);
+
+// re[k] = mag·cos(phase), im[k] = mag·sin(phase), k ∈ [0, n)
+void polarToCart(const float* mag, const float* phase, float* re, float* im, int n);
+
+// out[k] = post·tanh(pre·in[k]), k ∈ [0, n) (in == out permitido)
+void tanhScaled(const float* in, float* out, int n, float pre, float post);
+
+Isa  bestIsa();                 // melhor ISA suportada por este CPU/binário
+Isa  activeIsa();               // ISA em uso
+bool setIsa(Isa isa);           // força uma ISA (testes/benchmark); false se não suportada
+const char* isaName(Isa isa);   // "scalar", "sse2", "avx2", "avx512"
+
+} // namespace SpectralMath
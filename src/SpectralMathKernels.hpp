@@ -0,0 +1,196 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+/*
+ SpectralMathKernels (uso interno de SpectralMath*.cpp)
+
+ Kernels polar <-> cartesiano escritos uma só vez sobre um "traits" de
+ vetor V (largura W). Cada unidade de compilação (scalar/SSE2, AVX2, AVX‑512)
+ é compilada com as flags da sua ISA e instancia os kernels com o seu V.
+
+ Tudo neste header tem ligação interna (namespace anónimo): cada .cpp obtém
+ a sua própria cópia compilada para a sua ISA, sem violar a ODR.
+
+ Aproximações (float32, coeficientes Cephes):
+    atan2  : redução a t = min/max ∈ [0,1], depois a [−tan(π/8), tan(π/8)];
+             polinómio ímpar de grau 9. Erro ≤ 3.0e−7 rad (≈ 1.3 ulp em |φ| = π).
+    sin/cos: redução Cody–Waite por quadrantes (π/2 em 3 parcelas) para
+             r ∈ [−π/4, π/4]; polinómios de grau 7 (sin) e 8 (cos).
+             Erro absoluto ≤ 1.2e−7 para |x| ≤ 8192 (domínio do Cephes).
+    sqrt   : instrução nativa (exata, IEEE).
+    tanh   : racional x·P(x²)/Q(x²) de grau 13/6 (coeficientes do Eigen), com
+             |x| limitado a 7.9053 (onde já arredonda para ±1). Erro
+             ≤ 5e−7 absoluto (alguns ULP junto de ±1); sem exp() nem ramos.
+ */
+namespace {
+namespace smk {
+
+constexpr float PI       = 3.14159265358979323846f;
+constexpr float PI_2     = 1.57079632679489661923f;
+constexpr float PI_4     = 0.78539816339744830962f;
+constexpr float TAN_PI_8 = 0.41421356237309504880f;
+constexpr float TWO_OVER_PI = 0.63661977236758134308f;
+
+// π/2 em três parcelas (Cody–Waite): produtos j·P1 exatos para |j| < 2^17.
+constexpr float PIO2_1 = 1.5703125f;
+constexpr float PIO2_2 = 4.837512969970703125e-4f;
+constexpr float PIO2_3 = 7.54978995489188216e-8f;
+
+// Coeficientes Cephes (atanf, sinf, cosf).
+constexpr float AT0 =  8.05374449538e-2f;
+constexpr float AT1 = -1.38776856032e-1f;
+constexpr float AT2 =  1.99777106478e-1f;
+constexpr float AT3 = -3.33329491539e-1f;
+constexpr float S0  = -1.9515295891e-4f;
+constexpr float S1  =  8.3321608736e-3f;
+constexpr float S2  = -1.6666654611e-1f;
+constexpr float C0  =  2.443315711809948e-5f;
+constexpr float C1  = -1.388731625493765e-3f;
+constexpr float C2  =  4.166664568298827e-2f;
+
+// tanh racional (Eigen, generic_fast_tanh_float)
+constexpr float TH_CLAMP = 7.90531110763549805f;
+constexpr float TA1  =  4.89352455891786e-03f;
+constexpr float TA3  =  6.37261928875436e-04f;
+constexpr float TA5  =  1.48572235717979e-05f;
+constexpr float TA7  =  5.12229709037114e-08f;
+constexpr float TA9  = -8.60467152213735e-11f;
+constexpr float TA11 =  2.00018790482477e-13f;
+constexpr float TA13 = -2.76076847742355e-16f;
+constexpr float TB0  =  4.89352518554385e-03f;
+constexpr float TB2  =  2.26843463243900e-03f;
+constexpr float TB4  =  1.18534705686654e-04f;
+constexpr float TB6  =  1.19825839466702e-06f;
+
+// Traits escalar (largura 1): fallback e cauda dos kernels vetoriais.
+struct ScalarOps {
+    using T = float; using I = int32_t; using M = bool;
+    static constexpr int W = 1;
+    static T load(const float* p)            { return *p; }
+    static void store(float* p, T v)         { *p = v; }
+    static T set1(float v)                   { return v; }
+    static T add(T a, T b)                   { return a + b; }
+    static T sub(T a, T b)                   { return a - b; }
+    static T mul(T a, T b)                   { return a * b; }
+    static T fmadd(T a, T b, T c)            { return a * b + c; }
+    static T div(T a, T b)                   { return a / b; }
+    static T sqrt(T a)                       { return std::sqrt(a); }
+    static T min(T a, T b)                   { return a < b ? a : b; }
+    static T max(T a, T b)                   { return a > b ? a : b; }
+    static T abs(T a)                        { return std::fabs(a); }
+    static M gt(T a, T b)                    { return a > b; }
+    static M eq(T a, T b)                    { return a == b; }
+    static M signbit(T a)                    { return std::signbit(a); }
+    static T select(M m, T a, T b)           { return m ? a : b; }     // m ? a : b
+    static T neg_if(M m, T a)                { return m ? -a : a; }
+    static I round_i(T a)                    { return (I)std::lrint(a); }
+    static T to_float(I a)                   { return (T)a; }
+    static I add_i(I a, int b)               { return a + b; }
+    static M bit_set(I a, int bit)           { return (a & bit) != 0; }
+};
+
+// atan2(y, x) vetorial (ver erro no cabeçalho).
+template <class V>
+inline typename V::T atan2v(typename V::T y, typename V::T x) {
+    using T = typename V::T;
+    T ax = V::abs(x), ay = V::abs(y);
+    T mx = V::max(ax, ay), mn = V::min(ax, ay);
+    T t  = V::div(mn, V::select(V::eq(mx, V::set1(0.f)), V::set1(1.f), mx));   // 0/0 -> 0
+
+    // Redução a |t| ≤ tan(π/8): t' = (t−1)/(t+1), base π/4
+    auto big  = V::gt(t, V::set1(TAN_PI_8));
+    T tr      = V::select(big, V::div(V::sub(t, V::set1(1.f)), V::add(t, V::set1(1.f))), t);
+    T base    = V::select(big, V::set1(PI_4), V::set1(0.f));
+
+    T z = V::mul(tr, tr);
+    T p = V::fmadd(V::fmadd(V::fmadd(V::set1(AT0), z, V::set1(AT1)), z, V::set1(AT2)), z, V::set1(AT3));
+    T r = V::add(base, V::fmadd(V::mul(p, z), tr, tr));
+
+    r = V::select(V::gt(ay, ax), V::sub(V::set1(PI_2), r), r);                // octante
+    r = V::select(V::signbit(x), V::sub(V::set1(PI), r), r);                  // x < 0
+    return V::neg_if(V::signbit(y), r);                                       // y < 0
+}
+
+// sin(x) e cos(x) em simultâneo (redução por quadrantes).
+template <class V>
+inline void sincosv(typename V::T x, typename V::T& s, typename V::T& c) {
+    using T = typename V::T;
+    auto j  = V::round_i(V::mul(x, V::set1(TWO_OVER_PI)));
+    T jf    = V::to_float(j);
+    T r     = V::fmadd(jf, V::set1(-PIO2_1), x);
+    r       = V::fmadd(jf, V::set1(-PIO2_2), r);
+    r       = V::fmadd(jf, V::set1(-PIO2_3), r);
+
+    T z  = V::mul(r, r);
+    T ps = V::fmadd(V::mul(V::fmadd(V::fmadd(V::set1(S0), z, V::set1(S1)), z, V::set1(S2)), z), r, r);
+    T pc = V::fmadd(V::mul(V::fmadd(V::fmadd(V::set1(C0), z, V::set1(C1)), z, V::set1(C2)), z), z,
+                    V::fmadd(V::set1(-0.5f), z, V::set1(1.f)));
+
+    // Quadrante q = j mod 4: (sin, cos) = (s, c), (c, −s), (−s, −c), (−c, s)
+    auto odd  = V::bit_set(j, 1);
+    auto sgnS = V::bit_set(j, 2);
+    auto sgnC = V::bit_set(V::add_i(j, 1), 2);
+    s = V::neg_if(sgnS, V::select(odd, pc, ps));
+    c = V::neg_if(sgnC, V::select(odd, ps, pc));
+}
+
+// mag = √(re² + im²), phase = atan2(im, re)
+template <class V>
+inline void cartToPolar(const float* re, const float* im, float* mag, float* phase, int n) {
+    int i = 0;
+    for (; i + V::W <= n; i += V::W) {
+        auto r = V::load(re + i), m = V::load(im + i);
+        V::store(mag + i,   V::sqrt(V::fmadd(r, r, V::mul(m, m))));
+        V::store(phase + i, atan2v<V>(m, r));
+    }
+    for (; i < n; ++i) {
+        float r = re[i], m = im[i];
+        mag[i]   = std::sqrt(r * r + m * m);
+        phase[i] = atan2v<ScalarOps>(m, r);
+    }
+}
+
+// re = mag·cos(φ), im = mag·sin(φ)
+template <class V>
+inline void polarToCart(const float* mag, const float* phase, float* re, float* im, int n) {
+    int i = 0;
+    for (; i + V::W <= n; i += V::W) {
+        typename V::T s, c, a = V::load(mag + i);
+        sincosv<V>(V::load(phase + i), s, c);
+        V::store(re + i, V::mul(a, c));
+        V::store(im + i, V::mul(a, s));
+    }
+    for (; i < n; ++i) {
+        float s, c;
+        sincosv<ScalarOps>(phase[i], s, c);
+        re[i] = mag[i] * c;
+        im[i] = mag[i] * s;
+    }
+}
+
+// tanh(x) vetorial (ver erro no cabeçalho).
+template <class V>
+inline typename V::T tanhv(typename V::T x) {
+    using T = typename V::T;
+    x   = V::min(V::max(x, V::set1(-TH_CLAMP)), V::set1(TH_CLAMP));
+    T z = V::mul(x, x);
+    T p = V::fmadd(V::fmadd(V::fmadd(V::set1(TA13), z, V::set1(TA11)), z, V::set1(TA9)), z, V::set1(TA7));
+    p   = V::fmadd(V::fmadd(V::fmadd(p, z, V::set1(TA5)), z, V::set1(TA3)), z, V::set1(TA1));
+    T q = V::fmadd(V::fmadd(V::fmadd(V::set1(TB6), z, V::set1(TB4)), z, V::set1(TB2)), z, V::set1(TB0));
+    return V::div(V::mul(x, p), q);
+}
+
+// out = post·tanh(pre·in) (in == out permitido)
+template <class V>
+inline void tanhScaled(const float* in, float* out, int n, float pre, float post) {
+    int i = 0;
+    for (; i + V::W <= n; i += V::W)
+        V::store(out + i, V::mul(V::set1(post), tanhv<V>(V::mul(V::set1(pre), V::load(in + i)))));
+    for (; i < n; ++i)
+        out[i] = post * tanhv<ScalarOps>(pre * in[i]);
+}
+
+} // namespace smk
+} // namespace
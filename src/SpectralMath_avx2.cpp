@@ -0,0 +1,56 @@
+// Variante AVX2+FMA do SpectralMath (compilada com -mavx2 -mfma, ver Makefile).
+#include "SpectralMath.hpp"
+#include "SpectralMathKernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+
+namespace {
+
+// Traits AVX2 (8 floats).
+struct Avx2Ops {
+    using T = __m256; using I = __m256i; using M = __m256;
+    static constexpr int W = 8;
+    static T load(const float* p)            { return _mm256_loadu_ps(p); }
+    static void store(float* p, T v)         { _mm256_storeu_ps(p, v); }
+    static T set1(float v)                   { return _mm256_set1_ps(v); }
+    static T add(T a, T b)                   { return _mm256_add_ps(a, b); }
+    static T sub(T a, T b)                   { return _mm256_sub_ps(a, b); }
+    static T mul(T a, T b)                   { return _mm256_mul_ps(a, b); }
+    static T fmadd(T a, T b, T c)            { return _mm256_fmadd_ps(a, b, c); }
+    static T div(T a, T b)                   { return _mm256_div_ps(a, b); }
+    static T sqrt(T a)                       { return _mm256_sqrt_ps(a); }
+    static T min(T a, T b)                   { return _mm256_min_ps(a, b); }
+    static T max(T a, T b)                   { return _mm256_max_ps(a, b); }
+    static T abs(T a)                        { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+    static M gt(T a, T b)                    { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static M eq(T a, T b)                    { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static M signbit(T a)                    { return _mm256_castsi256_ps(_mm256_srai_epi32(_mm256_castps_si256(a), 31)); }
+    static T select(M m, T a, T b)           { return _mm256_blendv_ps(b, a, m); }
+    static T neg_if(M m, T a)                { return _mm256_xor_ps(a, _mm256_and_ps(m, _mm256_set1_ps(-0.f))); }
+    static I round_i(T a)                    { return _mm256_cvtps_epi32(a); }
+    static T to_float(I a)                   { return _mm256_cvtepi32_ps(a); }
+    static I add_i(I a, int b)               { return _mm256_add_epi32(a, _mm256_set1_epi32(b)); }
+    static M bit_set(I a, int bit)           { I b = _mm256_set1_epi32(bit); return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(a, b), b)); }
+};
+
+} // namespace
+
+namespace SpectralMath {
+extern const bool avx2Compiled = true;
+void cartToPolarAVX2(const float* a, const float* b, float* c, float* d, int n) { smk::cartToPolar<Avx2Ops>(a, b, c, d, n); }
+void polarToCartAVX2(const float* a, const float* b, float* c, float* d, int n) { smk::polarToCart<Avx2Ops>(a, b, c, d, n); }
+void tanhScaledAVX2(const float* a, float* b, int n, float pre, float post) { smk::tanhScaled<Avx2Ops>(a, b, n, pre, post); }
+}
+
+#else
+// Compilado sem -mavx2/-mfma: a variante fica indisponível (o dispatch não a escolhe).
+namespace SpectralMath {
+extern const bool avx2Compiled = false;
+void cartToPolarAVX2(const float* a, const float* b, float* c, float* d, int n) { smk::cartToPolar<smk::ScalarOps>(a, b, c, d, n); }
+void polarToCartAVX2(const float* a, const float* b, float* c, float* d, int n) { smk::polarToCart<smk::ScalarOps>(a, b, c, d, n); }
+void tanhScaledAVX2(const float* a, float* b, int n, float pre, float post) { smk::tanhScaled<smk::ScalarOps>(a, b, n, pre, post); }
+}
+#endif
+#endif
@@ -0,0 +1,66 @@
+// Variante AVX‑512F do SpectralMath (compilada com -mavx512f, ver Makefile).
+#include "SpectralMath.hpp"
+#include "SpectralMathKernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#if defined(__AVX512F__)
+// Os intrínsecos de conversão/set do avx512fintrin.h do GCC 12 partem de um
+// __Y por inicializar (_mm512_undefined_*): -Wmaybe-uninitialized falso
+// quando inlined nos kernels. Silenciado só nesta variante.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+
+namespace {
+
+// Traits AVX‑512F (16 floats, máscaras __mmask16).
+struct Avx512Ops {
+    using T = __m512; using I = __m512i; using M = __mmask16;
+    static constexpr int W = 16;
+    static T load(const float* p)            { return _mm512_loadu_ps(p); }
+    static void store(float* p, T v)         { _mm512_storeu_ps(p, v); }
+    static T set1(float v)                   { return _mm512_set1_ps(v); }
+    static T add(T a, T b)                   { return _mm512_add_ps(a, b); }
+    static T sub(T a, T b)                   { return _mm512_sub_ps(a, b); }
+    static T mul(T a, T b)                   { return _mm512_mul_ps(a, b); }
+    static T fmadd(T a, T b, T c)            { return _mm512_fmadd_ps(a, b, c); }
+    static T div(T a, T b)                   { return _mm512_div_ps(a, b); }
+    static T sqrt(T a)                       { return _mm512_sqrt_ps(a); }
+    static T min(T a, T b)                   { return _mm512_min_ps(a, b); }
+    static T max(T a, T b)                   { return _mm512_max_ps(a, b); }
+    static T abs(T a)                        { return _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff))); }
+    static M gt(T a, T b)                    { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static M eq(T a, T b)                    { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static M signbit(T a)                    { return _mm512_cmplt_epi32_mask(_mm512_castps_si512(a), _mm512_setzero_si512()); }
+    static T select(M m, T a, T b)           { return _mm512_mask_blend_ps(m, b, a); }
+    static T neg_if(M m, T a)                { I ai = _mm512_castps_si512(a); return _mm512_castsi512_ps(_mm512_mask_xor_epi32(ai, m, ai, _mm512_set1_epi32((int)0x80000000))); }
+    static I round_i(T a)                    { return _mm512_cvtps_epi32(a); }
+    static T to_float(I a)                   { return _mm512_cvtepi32_ps(a); }
+    static I add_i(I a, int b)               { return _mm512_add_epi32(a, _mm512_set1_epi32(b)); }
+    static M bit_set(I a, int bit)           { return _mm512_test_epi32_mask(a, _mm512_set1_epi32(bit)); }
+};
+
+} // namespace
+
+namespace SpectralMath {
+extern const bool avx512Compiled = true;
+void cartToPolarAVX512(const float* a, const float* b, float* c, float* d, int n) { smk::cartToPolar<Avx512Ops>(a, b, c, d, n); }
+void polarToCartAVX512(const float* a, const float* b, float* c, float* d, int n) { smk::polarToCart<Avx512Ops>(a, b, c, d, n); }
+void tanhScaledAVX512(const float* a, float* b, int n, float pre, float post) { smk::tanhScaled<Avx512Ops>(a, b, n, pre, post); }
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#else
+// Compilado sem -mavx512f: a variante fica indisponível (o dispatch não a escolhe).
+namespace SpectralMath {
+extern const bool avx512Compiled = false;
+void cartToPolarAVX512(const float* a, const float* b, float* c, float* d, int n) { smk::cartToPolar<smk::ScalarOps>(a, b, c, d, n); }
+void polarToCartAVX512(const float* a, const float* b, float* c, float* d, int n) { smk::polarToCart<smk::ScalarOps>(a, b, c, d, n); }
+void tanhScaledAVX512(const float* a, float* b, int n, float pre, float post) { smk::tanhScaled<smk::ScalarOps>(a, b, n, pre, post); }
+}
+#endif
+#endif
@@ -0,0 +1,84 @@
+#include "SpectralStream.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Slots alinhados a 64 B (stride múltiplo de 16 floats); fila vazia
+void SpectralStream::setup(int bins) {
+    K = bins;
+    stride = (K + 15) & ~15;
+    slots.assign((size_t)CAPACITY * stride, 0.f);
+    std::fill_n(times, CAPACITY, 0);
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    drops.store(0, std::memory_order_relaxed);
+}
+
+// Produtor: escreve o slot livre e só depois o publica (release)
+bool SpectralStream::push(uint64_t time, const float* mag, int magStride) {
+    const uint64_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= (uint64_t)CAPACITY) {
+        drops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const int slot = (int)(h & (CAPACITY - 1));
+    float* dst = &slots[(size_t)slot * stride];
+    for (int k = 0; k < K; ++k)
+        dst[k] = mag[(size_t)k * magStride];
+    times[slot] = time;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+int SpectralStream::available() const {
+    return (int)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed));
+}
+
+const float* SpectralStream::frame(int i, uint64_t* time) const {
+    const int slot = (int)((tail.load(std::memory_order_relaxed) + i) & (CAPACITY - 1));
+    if (time) *time = times[slot];
+    return &slots[(size_t)slot * stride];
+}
+
+// Consumidor: liberta os slots já lidos para o produtor (release)
+void SpectralStream::pop(int n) {
+    tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+// Linha r cobre os bins [edge[r], max(edge[r+1], edge[r]+1)): linhas mais
+// estreitas do que um bin (graves em escala log.) repetem o bin
+void SpectralDecimator::setup(int bins, int rows, bool logFreq, int hops) {
+    rows = std::max(rows, 1);
+    K = bins;
+    hopsPerColumn = std::max(hops, 1);
+    count = 0;
+    column.assign(rows, 0.f);
+    edge.resize(rows + 1);
+    for (int r = 0; r <= rows; ++r)
+        edge[r] = std::clamp((int)std::floor(binAt((float)r / rows, bins, logFreq)), 0, bins - 2);
+    edge[0] = 0;                            // DC na 1ª linha
+    edge[rows] = bins - 1;                  // Nyquist fica de fora, como no desenho original
+}
+
+void SpectralDecimator::accumulate(const float* mag) {
+    const int R = (int)column.size();
+    const bool first = count == 0;
+    for (int r = 0; r < R; ++r) {
+        const int end = std::max(edge[r + 1], edge[r] + 1);
+        float m = mag[edge[r]];
+        for (int k = edge[r] + 1; k < end; ++k) m = std::max(m, mag[k]);
+        column[r] = first ? m : std::max(column[r], m);
+    }
+}
+
+// Linear: t·(K−1). Logarítmica: (K−1)^t, do bin 1 (t = 0) a K−1 (t = 1).
+float SpectralDecimator::binAt(float t, int bins, bool logFreq) {
+    const float top = (float)(bins - 1);
+    if (!logFreq) return t * top;
+    return std::pow(top, t);
+}
+
+float SpectralDecimator::positionOf(float bin, int bins, bool logFreq) {
+    const float top = (float)(bins - 1);
+    if (!logFreq) return bin / top;
+    return bin <= 1.f ? 0.f : std::log(bin) / std::log(top);
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+/*
+ SpectralStream
+
+ Fila lock‑free de um só produtor (thread de áudio) e um só consumidor
+ (thread de UI) com frames espectrais de tamanho fixo: um por hop, com a
+ magnitude pós‑efeitos da 1ª voz de um lado e o instante do hop.
+
+ Convenções
+    - CAPACITY slots de K floats (cada slot alinhado a 64 B), alocados em
+      setup(); push() só copia os K valores e publica o índice de escrita.
+    - Fila cheia (a UI não está a desenhar): o frame novo é descartado e
+      contado em dropped(); o consumidor nunca vê um slot a meio da escrita.
+    - 'time' = instante (amostras do Core) da última amostra do frame.
+
+ Do lado da UI, SpectralDecimator agrega os frames à resolução do ecrã:
+ bins -> linhas (escala linear ou logarítmica, máximo dos bins de cada
+ linha) e hops -> colunas (máximo de 'hopsPerColumn' hops por coluna).
+ Só os frames que chegam a ser desenhados são lidos; o atraso acumulado
+ para além de maxColumns colunas é saltado sem cópia.
+ */
+class SpectralStream {
+public:
+    static constexpr int CAPACITY = 64;     // frames (potência de 2; ≈ 0.17 s com H = 128 a 48 kHz)
+
+    // Reserva os slots para K bins e esvazia a fila (fora do thread de áudio).
+    void setup(int bins);
+    int bins() const { return K; }
+
+    // Produtor: copia mag[k·stride] (k < K) para o próximo slot. false se a fila estiver cheia.
+    bool push(uint64_t time, const float* mag, int stride);
+
+    // Produtor: fila cheia (a UI não está a ler; push() descartaria o frame).
+    bool full() const {
+        return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire) >= (uint64_t)CAPACITY;
+    }
+
+    // Consumidor: nº de frames por ler, o mais antigo (i = 0) e descarte dos n mais antigos.
+    int available() const;
+    const float* frame(int i, uint64_t* time = nullptr) const;
+    void pop(int n);
+
+    // Frames descartados com a fila cheia desde setup().
+    uint64_t dropped() const { return drops.load(std::memory_order_relaxed); }
+
+private:
+    int K = 0;
+    int stride = 0;                         // floats por slot (K arredondado a 16)
+    std::vector<float> slots;               // [CAPACITY][stride]
+    uint64_t times[CAPACITY] = {};
+
+    alignas(64) std::atomic<uint64_t> head { 0 };   // frames escritos (produtor)
+    alignas(64) std::atomic<uint64_t> tail { 0 };   // frames lidos (consumidor)
+    std::atomic<uint64_t> drops { 0 };
+};
+
+// Agregação dos frames de um SpectralStream em colunas do espectrograma (UI).
+class SpectralDecimator {
+public:
+    /*
+    K bins -> 'rows' linhas (linha 0 = graves) e 'hopsPerColumn' hops por coluna.
+    Em escala logarítmica a linha 0 começa no DC e o eixo vai do bin 1 a K−1.
+    */
+    void setup(int bins, int rows, bool logFreq, int hopsPerColumn);
+    int rows() const { return (int)column.size(); }
+    int bins() const { return K; }          // K do setup (0 = por ajustar)
+
+    /*
+    Lê os frames disponíveis e entrega cada coluna completa a emit(const float* col),
+    com rows() valores. No máximo maxColumns colunas por chamada (as mais recentes).
+    Devolve o nº de colunas entregues.
+    */
+    template <typename Emit>
+    int drain(SpectralStream& s, int maxColumns, Emit&& emit) {
+        int n = s.available();
+        if (n > maxColumns * hopsPerColumn - count) {   // atraso maior do que o ecrã: salta os mais antigos
+            count = 0;
+            const int skip = n - maxColumns * hopsPerColumn;
+            if (skip > 0) { s.pop(skip); n -= skip; }
+        }
+        int emitted = 0;
+        for (int i = 0; i < n; ++i) {
+            accumulate(s.frame(i));
+            if (++count == hopsPerColumn) {
+                emit(column.data());
+                count = 0;
+                ++emitted;
+            }
+        }
+        s.pop(n);
+        return emitted;
+    }
+
+    // Eixo de frequência: posição t ∈ [0, 1] (0 = graves) <-> bin contínuo em [0, K−1].
+    static float binAt(float t, int bins, bool logFreq);
+    static float positionOf(float bin, int bins, bool logFreq);
+
+private:
+    void accumulate(const float* mag);      // máximo por linha, acumulado na coluna em curso
+
+    std::vector<int> edge;                  // [rows + 1] 1º bin de cada linha (ver setup)
+    std::vector<float> column;              // [rows] coluna em curso
+    int K = 0;
+    int hopsPerColumn = 1;
+    int count = 0;                          // hops já acumulados na coluna em curso
+};
@@ -0,0 +1,756 @@
+#include "SpectroEngine.hpp"
+#include <chrono>
+#include <vector>
+
+// N efetivo: mesma duração de janela (em segundos) a qualquer fs
+int StftConfig::effectiveSize() const {
+    int n = SpectroEngine::MIN_N;
+    while (n < fftSize && n < 8192) n <<= 1;            // potência de 2 em [256, 8192]
+    const double ratio = sampleRate > 0.f ? sampleRate / 48000.0 : 1.0;
+    const int octaves = (int)std::lround(std::log2(ratio));
+    n = octaves >= 0 ? n << std::min(octaves, 8) : n >> std::min(-octaves, 8);
+    return std::clamp(n, SpectroEngine::MIN_N, SpectroEngine::MAX_N);
+}
+
+// Core: janela, buffers alinhados, PhaseEngine/SpectralFX e planos FFTW para o N pedido
+SpectroEngine::Core::Core(const StftConfig& c, Core* parent) : cfg(c), coarse(parent) {
+    static std::atomic<uint64_t> serials { 0 };
+    serial = serials.fetch_add(1, std::memory_order_relaxed) + 1;
+    single = cfg.precision == StftPrecision::FLOAT;
+    paired = cfg.pairStereo;
+    N = parent ? parent->N / SPLIT_RATIO : cfg.effectiveSize();
+    const int ov = cfg.overlap >= 8 ? 8 : cfg.overlap >= 4 ? 4 : 2;
+    cfg.overlap = ov;
+    H  = N / ov;
+    K  = N / 2 + 1;
+    KP = (K + 7) & ~7;
+    LATENCY = parent ? parent->LATENCY : N + H;     // agudos alinhados com os graves
+    RING = 2 * N;
+    while (RING < LATENCY + 1) RING <<= 1;          // do frame mais antigo à última posição do OLA
+    stageStride = H / NUM_STAGES;
+    while ((1 << hopBits) < H) ++hopBits;
+    olaScale = 2.0 / ((double)N * ov);
+
+    // Multi‑resolução: FIR do crossover (sinc com janela de Hann, ganho DC = 1) e Core dos agudos
+    if (parent) {
+        XOVER = parent->XOVER;
+    } else if (cfg.splitBand && N / SPLIT_RATIO >= MIN_N) {
+        XOVER = std::max(1, (int)std::lround(SPLIT_XOVER_MS * 1e-3 * cfg.sampleRate));
+        const double fc = SPLIT_CROSSOVER_HZ / cfg.sampleRate;     // ciclos/amostra
+        xoverTaps.resize(XOVER + 1);
+        double sum = 0.0;
+        for (int i = 0; i <= XOVER; ++i) {
+            const double sinc = i ? std::sin(2 * M_PI * fc * i) / (M_PI * i) : 2 * fc;
+            xoverTaps[i] = sinc * 0.5 * (1 + std::cos(M_PI * i / (XOVER + 1)));
+            sum += i ? 2 * xoverTaps[i] : xoverTaps[i];
+        }
+        for (double& h : xoverTaps) h /= sum;
+        XRING = 1;
+        while (XRING < 2 * XOVER + 1) XRING <<= 1;
+        xoverHist.assign((size_t)2 * MAX_VOICES * 2 * XRING, 0.0);
+        fine = std::make_unique<Core>(cfg, this);
+    }
+    IDLE_AFTER = N + LATENCY + (XOVER ? 2 * XOVER + 1 : 0);
+
+    for (int g = 0; g < 2; ++g) {
+        Side& s = sides[g];
+        s.hopOffset = paired ? 0 : g * H / 2;   // R desfasado de H/2 (alinhado se emparelhado)
+
+        const size_t kc = (size_t)K * MAX_VOICES;
+        s.re     .assign(kc, 0.f);          // espectro real (análise e síntese)
+        s.im     .assign(kc, 0.f);          // espectro imag. (análise e síntese)
+        s.magIn  .assign(kc, 0.f);          // magnitude da análise
+        s.phaseIn.assign(kc, 0.f);          // fase da análise
+        s.magProc.assign(kc, 0.f);          // magnitude processada
+        s.weight .assign(K, 1.f);           // pesos da máscara (1 por hop)
+        if (!parent) s.ready.assign((size_t)2 * MAX_VOICES * H, 0.f);  // blocos de saída prontos
+
+        s.fx.setup(K, MAX_VOICES);          // efeitos: buffers de trabalho para todas as vozes
+        if (parent) s.fx.setBinWidth((float)SPLIT_RATIO);  // blur/sharpen/emboss em Hz iguais aos do Core principal
+        s.phase.setup(MAX_VOICES, K, H);    // PhaseEngine (avanço de fase por hop H)
+    }
+
+    // Buffers de tempo/espectro, janela e transformadas na precisão do pipeline
+    if (single) allocate<float>();
+    else        allocate<double>();
+
+    // Máscara 2D e frames espectrais expostos à UI (o fine usa a máscara do Core principal)
+    if (!parent) mask2d.setup(HIST, K);     // HIST colunas, K bins (=N/2+1)
+    for (SpectralStream& st : stream) st.setup(K);
+}
+
+template <typename T>
+void SpectroEngine::Core::allocate() {
+    using F = Fftw<T>;
+    for (Side& s : sides) {
+        // Buffers FFTW alinhados (todas as vozes contíguas); buffers circulares a zero
+        Pipe<T>& p = s.pipe<T>();
+        p.frames  = F::allocReal((size_t)MAX_VOICES * N);
+        p.spectra = F::allocComplex((size_t)MAX_VOICES * KP);
+        p.inRing .setup(MAX_VOICES, RING, N);
+        p.outRing.setup(MAX_VOICES, RING, N);
+    }
+
+    // Transformadas: backend pedido, ou o mais rápido para este N e precisão (micro‑benchmark em cache)
+    Stft<T>& st = stft<T>();
+    fftSelection = &FFTBackend::select<T>(N, KP);
+    fftKind = cfg.backend == FFTBackend::Kind::AUTO ? fftSelection->best : cfg.backend;
+    st.fft = FFTBackend::create<T>(fftKind, N, KP, paired);
+
+    // Janela √Hann periódica (análise + síntese): hann² soma overlap/2 com hop N/overlap,
+    // compensado em olaScale (COLA para 2×, 4× e 8×). Calculada em double.
+    st.hann  = F::allocReal(N);
+    st.delay = F::allocReal(N);
+    for (int i = 0; i < N; ++i) {
+        double h = 0.5 * (1 - std::cos(2 * M_PI * i / N));
+        st.hann[i]  = (T)std::sqrt(h);
+        st.delay[i] = (T)(h * N * olaScale);    // análise × síntese sem FFT: soma 1 no OLA
+    }
+}
+
+// Liberta buffers alinhados (o backend FFT larga os seus planos)
+SpectroEngine::Core::~Core() {
+    for (Side& s : sides) {
+        Fftw<double>::free(s.pd.frames);  Fftw<double>::free(s.pd.spectra);
+        Fftw<float>::free(s.pf.frames);   Fftw<float>::free(s.pf.spectra);
+    }
+    Fftw<double>::free(sd.hann);  Fftw<double>::free(sd.delay);
+    Fftw<float>::free(sf.hann);   Fftw<float>::free(sf.delay);
+}
+
+// Construtor: Core inicial construído já (fora do thread de áudio)
+SpectroEngine::SpectroEngine(const StftConfig& cfg) {
+    requested = cfg;
+    configure(cfg);
+}
+
+// Destrutor: termina o thread de fundo e liberta todos os Cores
+SpectroEngine::~SpectroEngine() {
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        stopWorker = true;
+    }
+    workerCv.notify_all();
+    if (worker.joinable()) worker.join();
+
+    delete pending.exchange(nullptr);
+    for (Core* c = retired.exchange(nullptr); c; ) {
+        Core* next = c->nextRetired;
+        delete c;
+        c = next;
+    }
+    delete active;
+}
+
+// Troca síncrona de Core (sem outros threads a usar o motor)
+void SpectroEngine::configure(const StftConfig& cfg) {
+    Core* next = new Core(cfg);
+    if (!active) {
+        active = next;
+        shown.store(next, std::memory_order_release);
+        reset();
+        return;
+    }
+    adopt(next);
+    for (Core* c = retired.exchange(nullptr); c; ) {
+        Core* n = c->nextRetired;
+        delete c;
+        c = n;
+    }
+}
+
+// Pedido assíncrono: o thread de fundo constrói o Core e deixa-o em 'pending'
+void SpectroEngine::requestConfig(const StftConfig& cfg) {
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        if (cfg == requested) return;
+        requested = cfg;
+        requestPending = true;
+        if (!worker.joinable())
+            worker = std::thread(&SpectroEngine::workerLoop, this);
+    }
+    workerCv.notify_one();
+}
+
+// Thread de áudio: instala 'next' (vozes e máscara herdadas) e reforma o Core atual
+void SpectroEngine::adopt(Core* next) {
+    Core* old = active;
+
+    // Limites da máscara reescalados para o novo nº de bins
+    next->mask2d.inherit(old->mask2d);
+
+    for (Core* k = next; k; k = k->fine.get())
+        for (int g = 0; g < 2; ++g)
+            k->sides[g].voices = voices[g]; // buffers novos já a zero
+
+    active = next;
+    shown.store(next, std::memory_order_release);
+
+    // Pilha lock‑free: o worker recolhe-a inteira com exchange()
+    old->nextRetired = retired.load(std::memory_order_relaxed);
+    while (!retired.compare_exchange_weak(old->nextRetired, old, std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+// Constrói os Cores pedidos e liberta os reformados depois do período de graça
+void SpectroEngine::workerLoop() {
+    using Clock = std::chrono::steady_clock;
+    struct Grave { Core* core; Clock::time_point since; };
+    std::vector<Grave> graves;
+    std::vector<Core*> expired;             // graça esgotada, a libertar fora do lock
+
+    std::unique_lock<std::mutex> lock(workerMutex);
+    for (;;) {
+        // Sem trabalho pendente dorme até ao próximo pedido; caso contrário verifica 4×/s
+        const bool idle = graves.empty() && !pending.load() && !retired.load();
+        auto ready = [&] { return stopWorker || requestPending; };
+        if (idle) workerCv.wait(lock, ready);
+        else      workerCv.wait_for(lock, std::chrono::milliseconds(250), ready);
+        if (stopWorker) break;
+
+        const auto now = Clock::now();
+        for (Core* c = retired.exchange(nullptr, std::memory_order_acquire); c; c = c->nextRetired)
+            graves.push_back({ c, now });
+        for (size_t i = 0; i < graves.size(); ) {
+            if (now - graves[i].since >= std::chrono::milliseconds(RETIRE_GRACE_MS)) {
+                expired.push_back(graves[i].core);
+                graves[i] = graves.back();
+                graves.pop_back();
+            } else {
+                ++i;
+            }
+        }
+
+        // Libertados sem o lock: ~Plan espera pelo 'planner' do PlanCache, que um
+        // upgrade FFTW_PATIENT pode ter durante segundos (requestConfig não espera)
+        if (!expired.empty()) {
+            lock.unlock();
+            for (Core* c : expired) delete c;
+            expired.clear();
+            lock.lock();
+        }
+
+        if (requestPending) {
+            const StftConfig cfg = requested;
+            requestPending = false;
+            lock.unlock();
+            Core* next = new Core(cfg);     // buffers e backend FFT (PlanCache: sem medições)
+            delete pending.exchange(next, std::memory_order_acq_rel);  // pedido anterior nunca adotado
+            lock.lock();
+        }
+    }
+
+    lock.unlock();
+    for (Grave& g : graves) delete g.core;  // destrutor: já ninguém lê estes Cores
+}
+
+// Limpa buffers, histórico de fase e DC‑block (dos dois Cores, em split)
+void SpectroEngine::reset() {
+    for (Core* c = active; c; c = c->fine.get()) {
+        for (Side& s : c->sides) {
+            clearVoices(*c, s, 0, MAX_VOICES);
+            s.job = HopJob();               // sem hop em curso
+            s.path = HopPath::STFT;
+            s.resume = false;
+            s.quiet = 0;
+            s.phase.reset();
+        }
+        c->clock = 0;
+    }
+    hops = fastHops = 0;
+}
+
+// Limpa buffers circulares, blocos de saída e DC‑block das vozes [from, to)
+void SpectroEngine::clearVoices(Core& c, Side& s, int from, int to) {
+    auto clear = [&](auto& p, int v) {
+        p.inRing.clear(v);
+        p.outRing.clear(v);
+    };
+    const int g = (int)(&s - c.sides);
+    for (int v = from; v < to; ++v) {
+        if (c.single) clear(s.pf, v);
+        else          clear(s.pd, v);
+        s.dc_x1[v] = s.dc_y1[v] = 0.0;
+        for (int slot = 0; slot < 2 && !s.ready.empty(); ++slot)
+            std::fill_n(&s.ready[((size_t)slot * MAX_VOICES + v) * c.H], c.H, 0.f);
+        if (c.XRING)
+            std::fill_n(&c.xoverHist[((size_t)g * MAX_VOICES + v) * 2 * c.XRING], 2 * c.XRING, 0.0);
+    }
+}
+
+// Termina o hop em curso do lado g (na precisão do Core); emparelhado, o de L (que inclui R)
+void SpectroEngine::finishHop(Core& c, int g) {
+    if (c.paired) g = 0;
+    HopJob& j = c.sides[g].job;
+    while (j.active) {
+        if (c.single) runStage<float>(c, g, j.stage);
+        else          runStage<double>(c, g, j.stage);
+    }
+}
+
+// Nomes dos estágios medidos por profileStages()
+const char* SpectroEngine::stageName(int stage) {
+    static const char* names[PROFILE_STAGES] = { "window", "fft", "analyze", "effects", "synth", "ifft", "ola", "output" };
+    return stage >= 0 && stage < PROFILE_STAGES ? names[stage] : "?";
+}
+
+void SpectroEngine::profileStages(int hops, double* ns) {
+    Core& c = *active;
+    finishHop(c, 0);
+    finishHop(c, 1);
+    if (c.single) profileHops<float>(c, hops, ns);
+    else          profileHops<double>(c, hops, ns);
+}
+
+// Hops do lado L, um estágio de cada vez com o relógio à volta; OUTPUT lê as
+// H amostras do bloco que o hop condicionou, uma a uma como processSide()
+template <typename T>
+void SpectroEngine::profileHops(Core& c, int hops, double* ns) {
+    using Clock = std::chrono::steady_clock;
+    std::fill_n(ns, PROFILE_STAGES, 0.0);
+    if (hops <= 0) return;
+    HopJob& j = c.sides[0].job;
+    const int last = c.paired ? 1 : 0;
+    volatile float sink = 0.f;
+    uint64_t frameEnd = c.clock + c.N;
+    for (int n = 0; n < hops; ++n, frameEnd += c.H) {
+        j.active   = true;
+        j.stage    = WINDOW;
+        j.frameEnd = frameEnd;
+        choosePaths(c, 0);
+        for (int st = WINDOW; st < NUM_STAGES; ++st) {
+            const auto t0 = Clock::now();
+            runStage<T>(c, 0, st);
+            ns[st] += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        }
+
+        // Saída: as H amostras do bloco que este hop condicionou
+        const auto t0 = Clock::now();
+        const uint64_t from = frameEnd + 1 + c.H;
+        for (int h = 0; h <= last; ++h) {
+            Side& s = c.sides[h];
+            const float* blk = readyBlock(c, s, from);
+            for (int i = 0; i < c.H; ++i)
+                for (int v = 0; v < s.voices; ++v) sink = blk[(size_t)v * c.H + i];
+        }
+        ns[PROFILE_STAGES - 1] += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    }
+    (void)sink;
+    for (int st = 0; st < PROFILE_STAGES; ++st) ns[st] /= hops;
+}
+
+// Nº de vozes por lado (o hop em curso termina ainda com o nº antigo)
+void SpectroEngine::setChannels(int left, int right) {
+    const int want[2] = { std::clamp(left, 1, MAX_VOICES), std::clamp(right, 1, MAX_VOICES) };
+    for (int g = 0; g < 2; ++g) {
+        voices[g] = want[g];
+        for (Core* c = active; c; c = c->fine.get()) {
+            Side& s = c->sides[g];
+            if (want[g] == s.voices) continue;
+            finishHop(*c, g);
+            clearVoices(*c, s, std::min(s.voices, want[g]), std::max(s.voices, want[g]));
+            s.voices = want[g];     // PhaseEngine limpa o histórico ao ver o novo C
+        }
+    }
+}
+
+// Processamento principal por amostra com overlap‑add
+void SpectroEngine::processFrame(const float* inL, const float* inR, float* outL, float* outR) {
+    // Core novo construído pelo thread de fundo: troca atómica (sem alocar nem bloquear)
+    if (pending.load(std::memory_order_relaxed))
+        if (Core* next = pending.exchange(nullptr, std::memory_order_acquire))
+            adopt(next);
+
+    Core& c = *active;
+    Core* f = c.fine.get();
+    const uint64_t t = c.clock++;
+    if (f) f->clock = c.clock;
+    for (int i = 0; i < 2; ++i) {
+        // Emparelhado: R primeiro, para que a amostra t de R já esteja no buffer quando o hop de L a lê
+        const int g = c.paired ? 1 - i : i;
+        const float* in = g ? inR : inL;
+        float* out = g ? outR : outL;
+        if (c.single) processSide<float>(c, g, t, in, out);
+        else          processSide<double>(c, g, t, in, out);
+
+        // Multi‑resolução: mesma entrada no Core dos agudos (o OLA dele junta‑se no bloco do principal)
+        if (f) {
+            if (c.single) processSide<float>(*f, g, t, in, nullptr);
+            else          processSide<double>(*f, g, t, in, nullptr);
+        }
+    }
+}
+
+// Crossover complementar (split): y <- fine(t − D) + h ∗ (y − fine), por voz
+void SpectroEngine::crossover(Core& c, int g, uint64_t t, double* y, const double* fine) {
+    const int D = c.XOVER, M = c.XRING - 1;
+    const double* h = c.xoverTaps.data();
+    const int pos = (int)(t & M);
+    for (int v = 0; v < c.sides[g].voices; ++v) {
+        double* diff = &c.xoverHist[((size_t)g * MAX_VOICES + v) * 2 * c.XRING];
+        double* high = diff + c.XRING;
+        diff[pos] = y[v] - fine[v];
+        high[pos] = fine[v];
+        const int mid = (int)((t - D) & M);
+        double low = h[0] * diff[mid];
+        for (int i = 1; i <= D; ++i)                // FIR simétrico: D + 1 multiplicações
+            low += h[i] * (diff[(mid + i) & M] + diff[(mid - i) & M]);
+        y[v] = high[mid] + low;
+    }
+}
+
+// 1 amostra de um lado: entrada, saída (do bloco pronto) e estágios do hop
+template <typename T>
+void SpectroEngine::processSide(Core& c, int g, uint64_t t, const float* in, float* out) {
+    Side& s = c.sides[g];
+    Pipe<T>& p = s.pipe<T>();
+    const int H = c.H;
+    const bool spread = (params.schedule == HopSchedule::SPREAD);
+
+    // Entrada: escreve amostra de cada voz no seu buffer circular (e espelho); conta o silêncio
+    float peak = 0.f;
+    for (int v = 0; v < s.voices; ++v) {
+        p.inRing.write(v, t, (T)in[v]);
+        peak = std::max(peak, std::fabs(in[v]));
+    }
+    s.quiet = peak < SILENCE ? std::min(s.quiet + 1, c.IDLE_AFTER) : 0;
+
+    // Saída: amostra t do bloco condicionado por um hop anterior; lida antes do hop
+    // desta amostra, que em IMMEDIATE escreve o outro bloco (o de t + H)
+    if (out) {
+        const float* blk = readyBlock(c, s, t) + ((t + H - s.hopOffset) & (H - 1));
+        for (int v = 0; v < s.voices; ++v) out[v] = blk[(size_t)v * H];
+    }
+
+    // Hop em curso: em SPREAD avança 1 estágio quando chega a sua vez;
+    // em IMMEDIATE (ex.: modo mudou a meio de um hop) termina-o já.
+    // Emparelhado, os hops de R são feitos pelo de L.
+    HopJob& j = s.job;
+    const bool drives = !c.paired || g == 0;
+    if (j.active) {
+        if (!spread)
+            while (j.active) runStage<T>(c, g, j.stage);
+        else if (t - j.frameEnd >= (uint64_t)j.stage * c.stageStride)
+            runStage<T>(c, g, j.stage);
+    }
+
+    // Frame completo (H amostras novas, desfasado por lado) -> novo hop
+    if (drives && ((t + 1 + (uint64_t)(H - s.hopOffset)) & (H - 1)) == 0) {
+        while (j.active) runStage<T>(c, g, j.stage);    // nunca acontece com stageStride·NUM_STAGES ≤ H
+        j.active   = true;
+        j.stage    = WINDOW;
+        j.frameEnd = t;
+        choosePaths(c, g);
+        if (spread) runStage<T>(c, g, j.stage);         // WINDOW já nesta amostra
+        else        while (j.active) runStage<T>(c, g, j.stage);
+    }
+}
+
+/*
+ Condiciona as H amostras de saída [from, from+H) do lado g, já completas
+ (nenhum hop futuro soma nelas), no bloco pronto que as contém: lidas e
+ zeradas do OLA (mais as do Core dos agudos, pelo crossover), headroom
+ −6 dB, limiter e DC‑block. Em silêncio, com o OLA esgotado, resta só a
+ cauda do DC‑block.
+*/
+template <typename T>
+void SpectroEngine::conditionBlock(Core& c, int g, uint64_t from) {
+    constexpr double FLUSH = 1e-12;             // |y| abaixo disto -> 0 (cauda sem denormais)
+    Side& s = c.sides[g];
+    const int H = c.H;
+    float* blk = readyBlock(c, s, from);
+
+    // DC‑block (HPF 1ª ordem): y[n] = x[n] − x[n−1] + R·y[n−1], corte ≈ (1−R)·fs/(2π)
+    const bool dc = params.dcBlockHz > 0.f;
+    const double R = dc ? std::max(0.0, 1.0 - 2 * M_PI * params.dcBlockHz / c.cfg.sampleRate) : 0.0;
+
+    if (params.fastPaths && s.quiet >= c.IDLE_AFTER) {
+        for (int v = 0; v < s.voices; ++v) {
+            float* out = blk + (size_t)v * H;
+            double x1 = s.dc_x1[v], y1 = s.dc_y1[v];
+            if (!dc || (x1 == 0.0 && y1 == 0.0)) {
+                std::fill_n(out, H, 0.f);
+                s.dc_x1[v] = s.dc_y1[v] = 0.0;
+                continue;
+            }
+            for (int i = 0; i < H; ++i) {
+                y1 = R * y1 - x1;
+                x1 = 0.0;
+                if (std::fabs(y1) < FLUSH) y1 = 0.0;
+                out[i] = (float)y1;
+            }
+            s.dc_x1[v] = 0.0;
+            s.dc_y1[v] = y1;
+        }
+        return;
+    }
+
+    // OLA -> bloco (lê e zera)
+    Pipe<T>& p = s.pipe<T>();
+    for (int v = 0; v < s.voices; ++v) p.outRing.take(v, from, H, blk + (size_t)v * H);
+
+    // Multi‑resolução: agudos do Core fine pelo crossover, instante a instante
+    if (Core* f = c.fine.get()) {
+        Pipe<T>& pf = f->sides[g].pipe<T>();
+        for (int i = 0; i < H; ++i) {
+            double y[MAX_VOICES], yf[MAX_VOICES];
+            for (int v = 0; v < s.voices; ++v) {
+                T& o = pf.outRing(v, from + i);
+                y[v] = blk[(size_t)v * H + i];
+                yf[v] = o;
+                o = 0;
+            }
+            crossover(c, g, from + i, y, yf);
+            for (int v = 0; v < s.voices; ++v) blk[(size_t)v * H + i] = (float)y[v];
+        }
+    }
+
+    // Headroom (−6 dB) e soft‑limiter tanh(drive·y)/tanh(drive), vetorial (ver SpectralMath)
+    const float drive = params.limiterDrive;
+    for (int v = 0; v < s.voices; ++v) {
+        float* out = blk + (size_t)v * H;
+        if (drive > 0.f) SpectralMath::tanhScaled(out, out, H, 0.5f * drive, 1.f / std::tanh(drive));
+        else             for (int i = 0; i < H; ++i) out[i] *= 0.5f;
+    }
+
+    // DC‑block com o estado em registos durante o bloco
+    for (int v = 0; v < s.voices; ++v) {
+        float* out = blk + (size_t)v * H;
+        if (!dc) { s.dc_x1[v] = s.dc_y1[v] = 0.0; continue; }
+        double x1 = s.dc_x1[v], y1 = s.dc_y1[v];
+        for (int i = 0; i < H; ++i) {
+            const double x = out[i];
+            y1 = x - x1 + R * y1;
+            if (std::fabs(y1) < FLUSH) y1 = 0.0;
+            x1 = x;
+            out[i] = (float)y1;
+        }
+        s.dc_x1[v] = x1;
+        s.dc_y1[v] = y1;
+    }
+}
+
+// Processa 1 amostra estéreo (1 voz por lado)
+void SpectroEngine::processSample(const float in[2], float out[2]) {
+    setChannels(1, 1);
+    processFrame(&in[0], &in[1], &out[0], &out[1]);
+}
+
+// Executa um estágio do hop em curso do lado g e avança para o seguinte
+// (emparelhado, o hop de L executa cada estágio para L e para R)
+template <typename T>
+void SpectroEngine::runStage(Core& c, int g, int stage) {
+    static_assert(OLA == (int)HotPathStats::OLA && NUM_STAGES == (int)HotPathStats::HOP, "HotPathStats: 1 kind por estágio");
+    SFX_PROFILE_SCOPE(hotPath, stage, g);
+    HopJob& j = c.sides[g].job;
+    const T* hann = c.stft<T>().hann;
+    const int N = c.N;
+    const int last = c.paired ? 1 : g;      // lados servidos por este hop: [g, last]
+    switch (stage) {
+        case WINDOW: {
+            if (g == 0 && !c.coarse)
+                c.mask2d.acquire();         // UI->DSP: troca de ponteiro, sem cópia
+            if (!j.analyze) break;
+
+            // Bloco de N amostras terminado em frameEnd (contíguo no buffer espelhado), com janela √Hann, por voz
+            const uint64_t start = j.frameEnd + 1 - N;
+            for (int h = g; h <= last; ++h) {
+                Side& s = c.sides[h];
+                Pipe<T>& p = s.pipe<T>();
+                for (int v = 0; v < s.voices; ++v) {
+                    const T* ring = p.inRing.at(v, start);
+                    T* frame = p.frames + (size_t)v * N;
+                    for (int i = 0; i < N; ++i)
+                        frame[i] = ring[i] * hann[i];
+                }
+            }
+            break;
+        }
+        case FFT:     if (j.analyze) executeBatched<T>(c, g, false); break;
+        case ANALYZE: if (j.analyze) for (int h = g; h <= last; ++h) analyzeFFT<T>(c, h); break;
+        case EFFECTS:
+            for (int h = g; h <= last; ++h) {
+                if (j.fast) publishBypassed(c, h, j.frameEnd);
+                else        applyEffects(c, h, j.frameEnd);
+            }
+            break;
+        case SYNTH:   if (!j.fast) for (int h = g; h <= last; ++h) synthesizeWithPhase<T>(c, h); break;
+        case IFFT:    if (!j.fast) executeBatched<T>(c, g, true); break;
+        case OLA: {
+            // Overlap‑add (IFFT 1/N e soma das janelas, ver olaScale) na posição de saída do frame.
+            // IDENTITY: o frame de entrada com a janela hann² (atraso de LATENCY); SILENT: nada.
+            const uint64_t base = j.frameEnd + 1 - N + c.LATENCY;
+            const uint64_t start = j.frameEnd + 1 - N;
+            const T scale = (T)c.olaScale;
+            const T* delay = c.stft<T>().delay;
+            for (int h = g; h <= last; ++h) {
+                Side& s = c.sides[h];
+                Pipe<T>& p = s.pipe<T>();
+                for (int v = 0; s.path != HopPath::SILENT && v < s.voices; ++v) {
+                    T* ring = p.outRing.at(v, base);        // N contíguas; o transbordo volta no fold()
+                    if (s.path == HopPath::IDENTITY) {
+                        const T* in = p.inRing.at(v, start);
+                        for (int i = 0; i < N; ++i)
+                            ring[i] += in[i] * delay[i];
+                    } else {
+                        const T* frame = p.frames + (size_t)v * N;
+                        for (int i = 0; i < N; ++i)
+                            ring[i] += frame[i] * hann[i] * scale;
+                    }
+                    p.outRing.fold(v, base, N);
+                }
+                hops += s.voices;
+                if (j.fast) fastHops += s.voices;
+
+                // As H amostras a seguir ao bloco em leitura ficaram completas
+                if (!c.coarse) conditionBlock<T>(c, h, j.frameEnd + 1 + c.H);
+            }
+            j.active = false;
+            break;
+        }
+        default: break;
+    }
+    j.stage = (uint8_t)(stage + 1);
+}
+
+// FFT (ou IFFT) das C vozes do lado g (o backend agrupa-as em lotes se puder).
+// Emparelhado: voz v de L com a voz v de R numa só FFT complexa; as vozes sem par à parte.
+template <typename T>
+void SpectroEngine::executeBatched(Core& c, int g, bool inverse) {
+    FFTBackend::RealFFT<T>& fft = *c.stft<T>().fft;
+    auto batch = [&](Side& s, int from) {
+        Pipe<T>& p = s.pipe<T>();
+        const int count = s.voices - from;
+        if (count <= 0) return;
+        T* frames = p.frames + (size_t)from * c.N;
+        typename Fftw<T>::Complex* spectra = p.spectra + (size_t)from * c.KP;
+        if (inverse) fft.inverse(spectra, frames, count);
+        else         fft.forward(frames, spectra, count);
+    };
+    if (!c.paired) {
+        batch(c.sides[g], 0);
+        return;
+    }
+
+    Side& l = c.sides[0];
+    Side& r = c.sides[1];
+    Pipe<T>& pl = l.pipe<T>();
+    Pipe<T>& pr = r.pipe<T>();
+    const int pairs = std::min(l.voices, r.voices);
+    if (inverse) fft.inversePairs(pl.spectra, pr.spectra, pl.frames, pr.frames, pairs);
+    else         fft.forwardPairs(pl.frames, pr.frames, pl.spectra, pr.spectra, pairs);
+    batch(l, pairs);
+    batch(r, pairs);
+}
+
+// Processa um bloco de amostras (buffers separados L/R)
+void SpectroEngine::process(const float* inL, const float* inR, float* outL, float* outR, int frames) {
+    for (int i = 0; i < frames; ++i) {
+        const float in[2] = { inL[i], inR[i] };
+        float out[2];
+        processSample(in, out);
+        outL[i] = out[0];
+        outR[i] = out[1];
+    }
+}
+
+// Extrai magnitude e fase do espectro FFT atual (todas as vozes do lado g)
+template <typename T>
+void SpectroEngine::analyzeFFT(Core& c, int g) {
+    Side& s = c.sides[g];
+    const int C = s.voices, K = c.K;
+
+    // Transpõe [voz][KP] complexo -> re/im [K][C] (re/im servem de rascunho; a síntese reescreve-os).
+    // Em float é só a transposição; em double arredonda para float.
+    float* re = s.re.data();
+    float* im = s.im.data();
+    for (int v = 0; v < C; ++v) {
+        const typename Fftw<T>::Complex* spec = s.pipe<T>().spectra + (size_t)v * c.KP;
+        for (int k = 0; k < K; ++k) {
+            re[k * C + v] = (float)spec[k][0];
+            im[k * C + v] = (float)spec[k][1];
+        }
+    }
+    // Magnitude e fase por bloco (SIMD, ver SpectralMath)
+    SpectralMath::cartToPolar(re, im, s.magIn.data(), s.phaseIn.data(), K * C);
+}
+
+// Efeitos sobre a magnitude do frame atual (todas as vozes do lado g)
+void SpectroEngine::applyEffects(Core& c, int g, uint64_t time) {
+    Side& s = c.sides[g];
+    const int C = s.voices;
+
+    // Pesos da máscara lidos uma vez por hop (limites + pintura da coluna atual);
+    // o Core dos agudos reamostra a máscara do Core principal para o seu K
+    if (c.coarse) c.coarse->mask2d.weightsNow(s.weight.data(), c.K);
+    else          c.mask2d.weightsNow(s.weight.data());
+
+    // Efeitos 1D sobre a magnitude, misturados pelos pesos (sem alocações; ver SpectralFX)
+    s.fx.process(s.magIn.data(), s.magProc.data(), C, s.fxParams, s.weight.data());
+
+    // 1ª voz publicada à UI (1 frame por hop; fila cheia -> descartado); o espectrograma é o do Core principal
+    if (!c.coarse) c.stream[g].push(time, s.magProc.data(), C);
+}
+
+// Atalho: frame para a UI sem efeitos (magnitude da análise, ou zeros em silêncio)
+void SpectroEngine::publishBypassed(Core& c, int g, uint64_t time) {
+    static const float zero = 0.f;
+    Side& s = c.sides[g];
+    if (c.coarse)
+        return;
+    if (s.path == HopPath::SILENT)
+        c.stream[g].push(time, &zero, 0);
+    else if (c.sides[c.paired ? 0 : g].job.analyze)
+        c.stream[g].push(time, s.magIn.data(), s.voices);
+}
+
+// Caminho de cada lado servido pelo hop que começa (ver Atalhos)
+void SpectroEngine::choosePaths(Core& c, int g) {
+    const int last = c.paired ? 1 : g;
+    HopJob& j = c.sides[g].job;
+    j.fast = params.fastPaths;
+    for (int h = g; h <= last; ++h) {
+        Side& s = c.sides[h];
+        s.fxParams  = params.ch[h];
+        s.phaseMode = params.phaseMode;
+        if (s.quiet >= c.N)
+            s.path = HopPath::SILENT;
+        else if (s.phaseMode == PhaseEngine::Mode::RAW && s.fxParams.atRest())
+            s.path = HopPath::IDENTITY;
+        else
+            s.path = HopPath::STFT;
+        j.fast = j.fast && s.path != HopPath::STFT;
+    }
+
+    // Análise num atalho só para o espectrograma: se algum lado IDENTITY tiver a fila com espaço
+    j.analyze = !j.fast;
+    for (int h = g; h <= last; ++h) {
+        Side& s = c.sides[h];
+        if (!j.fast) {
+            s.path = HopPath::STFT;
+        } else {
+            s.resume = true;
+            if (s.path == HopPath::IDENTITY && !c.coarse && !c.stream[h].full()) j.analyze = true;
+        }
+    }
+}
+
+// Síntese com PhaseEngine segundo o modo selecionado
+template <typename T>
+void SpectroEngine::synthesizeWithPhase(Core& c, int g) {
+    Side& s = c.sides[g];
+    const int C = s.voices, K = c.K;
+
+    // 1º hop depois de um atalho: fase da análise (continua o que estava a soar; PV parte daqui)
+    const PhaseEngine::Mode mode = s.resume ? PhaseEngine::Mode::RAW : s.phaseMode;
+    s.resume = false;
+    s.phase.processFrame(mode, C, s.magProc.data(), s.phaseIn.data(), s.re.data(), s.im.data());   // espectro complexo
+
+    // Transpõe re/im [K][C] -> [voz][KP] complexo para a IFFT deste hop
+    for (int v = 0; v < C; ++v) {
+        typename Fftw<T>::Complex* spec = s.pipe<T>().spectra + (size_t)v * c.KP;
+        for (int k = 0; k < K; ++k) {
+            spec[k][0] = s.re[(size_t)k * C + v];
+            spec[k][1] = s.im[(size_t)k * C + v];
+        }
+    }
+}
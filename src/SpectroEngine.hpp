@@ -0,0 +1,469 @@
+#pragma once
+#include <fftw3.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <type_traits>
+#include "PhaseEngine.hpp"
+#include "Mask2D.hpp"
+#include "SpectralStream.hpp"
+#include "SpectralFX.hpp"
+#include "SpectralMath.hpp"
+#include "FFTBackend.hpp"
+#include "FftwTraits.hpp"
+#include "MirrorRing.hpp"
+#include "HotPathStats.hpp"
+
+/*
+ SpectroEngine
+
+ Motor DSP do SpectroFX, independente do Rack. Contém todo o pipeline STFT
+ (janela √Hann, FFT, efeitos sobre a magnitude, PhaseEngine, IFFT,
+ overlap‑add) e o condicionamento de saída (headroom, soft‑limiter, DC‑block).
+
+ O SpectroFXModule limita-se a traduzir knobs/CV para 'SpectroParams' e a
+ entregar amostras; as ferramentas headless (tools/) usam o mesmo motor.
+
+ Convenções
+    - Lados: 0 = L, 1 = R. Cada lado tem 1..MAX_VOICES vozes (cabo
+      polifónico do Rack), todas com os parâmetros desse lado.
+    - Parâmetros já mapeados para [0..1] (knob + CV), ver SpectroParams.
+    - Latência = N + H amostras (igual nos dois modos de agendamento).
+
+ Tamanho da FFT e sobreposição em runtime (StftConfig)
+    - N de referência 256..8192 e sobreposição 2×/4×/8× (H = N/overlap).
+      O N efetivo acompanha a frequência de amostragem (×2 a 96 kHz, ×4 a
+      192 kHz): a resolução temporal e o nº de hops por segundo mantêm-se.
+    - Janela √Hann periódica; o OLA é escalado por 2/(N·overlap), pois
+      Σ hann²(n + mH) = overlap/2 para qualquer overlap ≥ 2.
+    - Tudo o que depende de N (planos, buffers, janela, Mask2D, PhaseEngine,
+      SpectralFX) vive num 'Core'. As transformadas vêm do FFTBackend
+      (FFTW com planos partilhados do PlanCache, ou a FFT in‑tree; em AUTO
+      a mais rápida para o N, medida uma vez por processo). configure() troca-o de forma síncrona;
+      requestConfig() constrói o novo Core num thread de fundo e entrega-o
+      ao thread de áudio por troca atómica no início de processFrame(): o
+      áudio nunca bloqueia, aloca nem liberta memória. Os Cores antigos são
+      libertados pelo mesmo thread de fundo após RETIRE_GRACE_MS (a UI pode
+      ainda estar a desenhar a partir deles).
+
+ Precisão do pipeline (StftPrecision)
+    - DOUBLE: buffers circulares, frames, janela e FFT em double (fftw_*).
+    - FLOAT : o mesmo em float (fftwf_*, ~2× mais rápido na FFT e metade da
+      memória). Os espectros ficam em float como re/im/magnitude/fase, logo
+      não há conversões de precisão entre os buffers circulares e a IFFT.
+    Todos os buffers do pipeline são alocados com fftw*_alloc (alinhados).
+    O condicionamento de saída é em float (limiter) e double (DC‑block).
+    O erro da versão float face à double fica muito abaixo do audível
+    ('spectrofx-bench --verify-precision').
+
+ Polifonia (structure‑of‑arrays)
+    - As vozes de um lado partilham o instante de hop: os seus frames são
+      transformados num só lote (com FFTW: fftw_plan_many_dft_r2c/c2r, lotes
+      de 16, 8, 4, 2 e 1 transformadas combinados para C vozes).
+    - Tempo/espectro em [voz][N] / [voz][KP]; magnitude e fase em [K][C]
+      (bin‑major), para que SpectralFX e PhaseEngine percorram as vozes no
+      laço interno.
+
+ Agendamento dos hops
+    - IMMEDIATE: todo o hop (janela, FFT, FX, fase, IFFT, OLA) corre na
+      amostra que completa o frame.
+    - SPREAD   : o hop é dividido em estágios (ver Stage), executados um a
+      um em amostras espaçadas de H/NUM_STAGES ao longo do hop seguinte.
+      O OLA de um hop só é lido a partir de H+1 amostras depois do frame,
+      logo o resultado é idêntico ao IMMEDIATE e sem latência adicional.
+    Em ambos os modos os hops do lado R estão desfasados de H/2 face ao L,
+    para que nunca calhem na mesma amostra.
+
+ Saída por blocos
+    - As H amostras de saída [f+H+1, f+2H] ficam completas quando acaba o
+      OLA do hop do frame f (o hop seguinte só soma a partir de f+2H+1).
+      Nesse estágio são condicionadas de uma vez (conditionBlock): lidas e
+      zeradas do OLA, crossover (split), headroom de −6 dB, soft‑limiter
+      tanh(drive·y)/tanh(drive) (tanh racional vetorial, SpectralMath) e
+      DC‑block de 1ª ordem com o estado em registos; |y| < 1e−12 vai a 0
+      (sem denormais na cauda). Ficam num de 2 blocos prontos por lado
+      ([2][MAX_VOICES][H], alternados), e por amostra resta uma leitura.
+    - O bloco lido numa amostra nunca é o que está a ser escrito: a amostra
+      é lida antes de o hop dessa amostra correr (IMMEDIATE) e em SPREAD o
+      OLA acaba antes do fim do hop.
+    - Limiter (SpectroParams::limiterDrive) e corte do DC‑block
+      (SpectroParams::dcBlockHz) são escolhidos pelo utilizador, ambos
+      desligáveis; valem a partir do bloco seguinte.
+
+ Atalhos (SpectroParams::fastPaths), decididos por lado no início de cada hop
+    - IDENTITY: modo RAW e efeitos em repouso. A cadeia STFT só reconstruiria
+      a entrada, logo o hop salta FFT, FX, fase e IFFT e o OLA soma o próprio
+      frame de entrada com a janela hann² (linha de atraso de LATENCY
+      amostras). A análise (FFT direta + magnitude) só corre se a UI estiver
+      a consumir frames (fila do espectrograma com espaço).
+    - SILENT  : as N amostras do frame em silêncio (|x| < SILENCE em todas as
+      vozes). O hop não contribuiria nada e é saltado; esgotada a cauda do
+      OLA (N + LATENCY amostras de silêncio) a saída é zero exato, sem
+      limiter (só o fim da cauda do DC‑block).
+    - Cada hop entra no OLA com a sua janela, logo mudar de caminho é um
+      crossfade de N amostras com a forma da janela: sem clicks. O 1º hop
+      STFT depois de um atalho usa a fase da análise (RAW), para que o
+      PV/PV‑Lock recomece da fase que estava a soar.
+    - Emparelhado, o hop só toma atalho se os dois lados o puderem tomar.
+    - O CV entra pelos valores efetivos dos parâmetros: um CV ligado que
+      mexa num efeito tira o lado do atalho no hop seguinte.
+
+ Estéreo emparelhado (StftConfig::pairStereo)
+    - Os hops de L e R ficam alinhados (sem o desfasamento de H/2) e o hop
+      de L conduz os dois lados: a voz v de L e a voz v de R são
+      transformadas juntas numa só FFT complexa de N pontos (two‑for‑one,
+      ver FFTBackend), na análise e na síntese. As vozes sem par (L e R com
+      nº de vozes diferente) usam as transformadas reais.
+    - Mesmo resultado do caminho por canal (dentro do erro de arredondamento)
+      com metade das transformadas por hop estéreo; em contrapartida o pico
+      de CPU de L e R calha na mesma amostra (usar com SPREAD).
+
+ Multi‑resolução (StftConfig::splitBand, N efetivo ≥ SPLIT_RATIO·MIN_N; só ferramentas)
+    - Um 2º Core ('fine', N/SPLIT_RATIO, mesma sobreposição, precisão e
+      emparelhamento) processa o mesmo sinal em paralelo. O seu OLA é escrito
+      com a latência do Core principal: as duas saídas chegam alinhadas.
+    - Crossover complementar à saída, com um FIR passa‑baixo de fase linear
+      h (2D+1 taps, corte SPLIT_CROSSOVER_HZ, D = SPLIT_XOVER_MS):
+          y(n) = fine(n − D) + (h ∗ (coarse − fine))(n)
+      graves do N longo, agudos do N curto. Reconstrução perfeita: com as
+      duas saídas iguais (efeitos em repouso) y é a entrada atrasada, para
+      qualquer h. Latência total = N + H + D.
+    - Nos agudos o espalhamento temporal de um transiente (pre‑echo do
+      PV/PV‑Lock, blur) fica limitado a N/SPLIT_RATIO amostras.
+    - Mapeamento por resolução (SpectralFX::setBinWidth no fine): blur com σ
+      em Hz (σ em bins ÷ SPLIT_RATIO), sharpen ÷ SPLIT_RATIO² e emboss ÷
+      SPLIT_RATIO (2ª e 1ª diferenças entre bins vizinhos); stretch e mirror
+      são escalas de frequência e gate é relativo ao pico do frame (iguais
+      nas duas). A máscara é uma só (K do
+      Core principal), reamostrada para o K curto (média dos bins cobertos).
+      Cada Core tem o seu PhaseEngine (avanço de fase com o seu H).
+    - Espectrograma, máscara, fftSize() e bins() são os do Core principal.
+    - Custo: os dois Cores transformam a banda inteira à fs, logo ≈ 2× o CPU
+      de um STFT único, e a latência dos agudos é a do Core principal. Por
+      isso o modo não está no menu do módulo: só em spectrofx-bench
+      (--split-band) e spectrofx-render (split-band = 1), para comparar.
+ */
+
+// Agendamento do trabalho de cada hop (ver acima).
+enum class HopSchedule : uint8_t { IMMEDIATE = 0, SPREAD = 1 };
+
+// Precisão das amostras no pipeline STFT (ver acima).
+enum class StftPrecision : uint8_t { DOUBLE = 0, FLOAT = 1 };
+
+// Tamanho da FFT / sobreposição (menu de contexto; ver acima).
+struct StftConfig {
+    int   fftSize    = 1024;        // N de referência a 48 kHz (potência de 2, 256..8192)
+    int   overlap    = 2;           // 2×, 4× ou 8× (H = N/overlap)
+    float sampleRate = 48000.f;     // fs atual (escala o N efetivo)
+    FFTBackend::Kind backend = FFTBackend::Kind::AUTO;  // implementação da FFT
+    StftPrecision precision  = StftPrecision::DOUBLE;   // double (fftw) ou float (fftwf)
+    bool pairStereo = false;        // L+R numa só FFT complexa (hops alinhados, ver acima)
+    bool splitBand  = false;        // agudos num 2º STFT com N/SPLIT_RATIO (ferramentas; ver Multi‑resolução)
+
+    // N efetivo: fftSize × 2^round(log2(fs/48k)), limitado a [MIN_N, MAX_N].
+    int effectiveSize() const;
+
+    bool operator==(const StftConfig& o) const {
+        return fftSize == o.fftSize && overlap == o.overlap && sampleRate == o.sampleRate
+            && backend == o.backend && precision == o.precision && pairStereo == o.pairStereo
+            && splitBand == o.splitBand;
+    }
+    bool operator!=(const StftConfig& o) const { return !(*this == o); }
+};
+
+// Parâmetros "planos" do motor (sem dependências do Rack).
+struct SpectroParams {
+    // Intensidades por canal em [0..1]. Stretch em repouso = 0.5.
+    using Channel = FXParams;
+
+    Channel ch[2];                                          // L / R (todas as vozes do lado)
+    PhaseEngine::Mode phaseMode = PhaseEngine::Mode::RAW;   // modo de fase
+    HopSchedule schedule = HopSchedule::IMMEDIATE;          // agendamento dos hops
+    bool fastPaths = true;                                  // atalhos IDENTITY/SILENT (ver acima)
+
+    // Condicionamento da saída (ver Saída por blocos). 38.2 Hz = R 0.995 a 48 kHz.
+    float limiterDrive = 1.2f;                              // tanh(drive·y)/tanh(drive); 0 = desligado (só headroom)
+    float dcBlockHz    = 38.2f;                             // corte do DC‑block (R = 1 − 2π·fc/fs); 0 = desligado
+};
+
+class SpectroEngine {
+public:
+    // Constantes STFT (N, H e K dependem da StftConfig ativa, ver fftSize()/hopSize()/bins())
+    static constexpr int DEFAULT_N  = 1024;     // N por omissão (a 48 kHz)
+    static constexpr int MIN_N      = 256;      // limites do N efetivo
+    static constexpr int MAX_N      = 32768;    // 8192 × 4 (192 kHz)
+    static constexpr int HIST       = 256;      // colunas da máscara 2D (tempo)
+    static constexpr int MAX_VOICES = 16;       // vozes por lado (polifonia do Rack)
+    static constexpr int RETIRE_GRACE_MS = 1000;    // tempo de vida de um Core substituído
+    static constexpr float SILENCE  = 1e-6f;    // |x| abaixo disto conta como silêncio (V)
+    static constexpr int   SPLIT_RATIO = 4;             // multi‑resolução: N dos agudos = N/4
+    static constexpr float SPLIT_CROSSOVER_HZ = 2000.f; // corte do crossover
+    static constexpr float SPLIT_XOVER_MS = 2.f;        // D: meio comprimento do FIR do crossover
+
+    explicit SpectroEngine(const StftConfig& cfg = StftConfig());   // constrói o Core inicial (síncrono)
+    ~SpectroEngine();               // termina o thread de fundo e liberta os Cores
+
+    SpectroEngine(const SpectroEngine&) = delete;
+    SpectroEngine& operator=(const SpectroEngine&) = delete;
+
+    /*
+    Troca de configuração STFT.
+     - configure()    : síncrono; só quando nenhum outro thread usa o motor
+                        (ferramentas, construtor).
+     - requestConfig(): assíncrono e sem bloqueio (UI, onSampleRateChange).
+                        O novo Core entra em vigor numa das próximas chamadas
+                        a processFrame(); pedidos iguais ao último são ignorados.
+    O estado de áudio (buffers, histórico de fase) recomeça do zero; parâmetros,
+    nº de vozes e limites da máscara (reescalados para o novo K) mantêm-se.
+    */
+    void configure(const StftConfig& cfg);
+    void requestConfig(const StftConfig& cfg);
+
+    // Configuração publicada (a usada pelo thread de áudio, ou prestes a sê-lo).
+    const StftConfig& config() const { return published()->cfg; }
+    int fftSize() const { return published()->N; }
+    int hopSize() const { return published()->H; }
+    int bins()    const { return published()->K; }
+    int latency() const { return published()->LATENCY + published()->XOVER; }  // N + H (+ D em split)
+
+    // Backend FFT em uso e tempos do micro‑benchmark para o N atual (menu de contexto).
+    FFTBackend::Kind fftBackend() const { return published()->fftKind; }
+    const FFTBackend::Selection& fftTimings() const { return *published()->fftSelection; }
+
+    // Parâmetros aplicados a partir do próximo hop (cada hop fixa-os no início, também em SPREAD).
+    void setParams(const SpectroParams& p) { params = p; }
+    const SpectroParams& getParams() const { return params; }
+
+    /*
+    Nº de vozes por lado (1..MAX_VOICES). Uma mudança termina o hop em curso
+    desse lado e limpa o estado das vozes que entram/saem.
+    */
+    void setChannels(int left, int right);
+    int channels(int side) const { return voices[side]; }
+
+    // Processa 1 amostra polifónica: inL/outL com channels(0) vozes, inR/outR com channels(1).
+    void processFrame(const float* inL, const float* inR, float* outL, float* outR);
+
+    // Processa 1 amostra estéreo (1 voz por lado): in[2] -> out[2] (saída processada).
+    void processSample(const float in[2], float out[2]);
+
+    // Processa um bloco de 'frames' amostras estéreo (buffers separados L/R).
+    void process(const float* inL, const float* inR, float* outL, float* outR, int frames);
+
+    // Limpa buffers, histórico de fase e DC‑block (mantém planos e parâmetros).
+    void reset();
+
+    // Nº de hops processados desde a construção/reset (1 por voz e por frame)
+    // e, desses, os que tomaram um atalho (IDENTITY ou SILENT).
+    uint64_t hopCount() const { return hops; }
+    uint64_t fastHopCount() const { return fastHops; }
+
+    /*
+    Micro‑benchmark por estágio (ferramentas; nunca com processFrame() a
+    correr): faz 'hops' hops seguidos do lado L do Core ativo sobre o que
+    está nos buffers, com os parâmetros atuais (caminho escolhido como num
+    hop normal), e devolve em ns[PROFILE_STAGES] o tempo médio por hop de
+    cada estágio, pela ordem de stageName(): os 7 do hop (o OLA inclui o
+    condicionamento do bloco de saída) e OUTPUT (leitura, amostra a amostra,
+    das H amostras do bloco que o hop produz). Emparelhado, o
+    hop de L serve também R. O Core dos agudos (split) não é medido. Deixa
+    o OLA e o histórico de fase por conta dos hops medidos (reset() a seguir
+    para voltar a processar do zero).
+    */
+    static constexpr int PROFILE_STAGES = 8;
+    static const char* stageName(int stage);
+    void profileStages(int hops, double* ns);
+
+#if SPECTROFX_PROFILE
+    // Instrumentação ao vivo (só com SPECTROFX_PROFILE, ver HotPathStats): estágios e
+    // hops medidos pelo motor; o módulo acrescenta o tempo de cada process().
+    HotPathStats& stats() { return hotPath; }
+#endif
+
+    /*
+    Acesso da UI ao Core publicado (válido durante pelo menos RETIRE_GRACE_MS
+    depois de uma troca; ler de novo a cada frame de desenho).
+     - spectra(side): frames por hop com a magnitude pós‑efeitos da 1ª voz do
+                      lado [bins()] (fila SPSC: um só consumidor, a UI).
+     - mask()       : máscara 2D (HIST × bins()).
+     - coreSerial() : nº de ordem do Core publicado, para detetar trocas (o
+                      endereço de um Core libertado pode ser reutilizado).
+    Um Core novo traz filas novas (vazias, com o novo K).
+    */
+    SpectralStream& spectra(int side) { return published()->stream[side]; }
+    Mask2D& mask() { return published()->mask2d; }
+    uint64_t coreSerial() const { return published()->serial; }
+
+private:
+    // Estágios de um hop, pela ordem de execução.
+    enum Stage : uint8_t { WINDOW = 0, FFT, ANALYZE, EFFECTS, SYNTH, IFFT, OLA, NUM_STAGES };
+
+    // Caminho de um lado num hop (ver Atalhos)
+    enum class HopPath : uint8_t { STFT = 0, IDENTITY, SILENT };
+
+    // Hop em curso de um lado
+    struct HopJob {
+        bool active = false;
+        bool fast = false;                      // atalho em todos os lados servidos (Side::path)
+        bool analyze = true;                    // WINDOW/FFT/ANALYZE correm (sempre, fora de atalho)
+        uint8_t stage = 0;                      // próximo estágio
+        uint64_t frameEnd = 0;                  // instante da última amostra do frame
+    };
+
+    // Buffers de tempo/espectro de um lado na precisão T (fftw*_alloc, alinhados)
+    template <typename T>
+    struct Pipe {
+        T* frames = nullptr;                            // [MAX_VOICES][N]  tempo (FFT in / IFFT out)
+        typename Fftw<T>::Complex* spectra = nullptr;   // [MAX_VOICES][KP] espectro complexo
+
+        // Buffers circulares espelhados indexados pelo instante absoluto (ver MirrorRing):
+        // inRing(v, t) = entrada em t; outRing(v, t) = saída OLA em t. Janelas de N contíguas.
+        MirrorRing<T> inRing;                           // [MAX_VOICES][RING + N]
+        MirrorRing<T> outRing;                          // [MAX_VOICES][RING + N]
+    };
+
+    // Estado de um lado (L ou R): todas as vozes em structure‑of‑arrays.
+    struct Side {
+        int voices    = 1;                      // vozes ativas (C)
+        int hopOffset = 0;                      // desfasamento do hop (amostras)
+        HopJob job;
+        HopPath path = HopPath::STFT;           // caminho deste lado no hop em curso
+        FXParams fxParams;                      // efeitos e modo de fase do hop em curso (fixados no início)
+        PhaseEngine::Mode phaseMode = PhaseEngine::Mode::RAW;
+        bool resume = false;                    // houve atalho: o próximo hop STFT usa fase RAW
+        int quiet = 0;                          // amostras seguidas em silêncio (satura em N + LATENCY)
+
+        // Só o da precisão do Core é alocado
+        Pipe<double> pd;
+        Pipe<float>  pf;
+        template <typename T> Pipe<T>& pipe() {
+            if constexpr (std::is_same<T, float>::value) return pf; else return pd;
+        }
+
+        // Fase / magnitude, bin‑major [K][C]
+        std::vector<float> re, im, magIn, phaseIn, magProc;
+        std::vector<float> weight;              // [K] pesos da máscara do hop em curso
+
+        // DC‑block (1ª ordem) por voz
+        double dc_x1[MAX_VOICES] = {}, dc_y1[MAX_VOICES] = {};
+
+        // Blocos de saída prontos [2][MAX_VOICES][H] (só no Core principal, ver Saída por blocos)
+        std::vector<float> ready;
+
+        SpectralFX fx;                          // cadeia de efeitos (buffers de trabalho)
+        PhaseEngine phase;                      // histórico de fase das vozes deste lado
+    };
+
+    // Transformadas e janela na precisão T
+    template <typename T>
+    struct Stft {
+        std::unique_ptr<FFTBackend::RealFFT<T>> fft;    // [voz][N] <-> [voz][KP]
+        T* hann = nullptr;                      // janela √Hann periódica [N] (análise+síntese)
+        T* delay = nullptr;                     // hann²·N·olaScale [N]: OLA de um hop IDENTITY
+    };
+
+    // Tudo o que depende de N/H: construído fora do thread de áudio.
+    struct Core {
+        // Planos FFTW, janela, buffers. Com 'parent': Core dos agudos do modo split
+        // (N = parent->N/SPLIT_RATIO, latência do parent).
+        explicit Core(const StftConfig& c, Core* parent = nullptr);
+        ~Core();
+
+        template <typename T> void allocate();  // buffers, janela e backend FFT na precisão T
+
+        StftConfig cfg;
+        bool single = false;                    // pipeline em float (StftPrecision::FLOAT)
+        bool paired = false;                    // estéreo emparelhado: o hop de L conduz L e R
+        uint64_t serial = 0;                    // nº de ordem do Core (único; ver coreSerial())
+        int N = 0, H = 0, K = 0;
+        int KP = 0;                             // stride do espectro por voz (múltiplo de 8 -> 64 B)
+        int RING = 0;                           // buffers circulares (2N, potência de 2; + N de espelho)
+        int LATENCY = 0;                        // N + H (fine: a do Core principal)
+        int XOVER = 0;                          // D do crossover (0 = sem split)
+        int IDLE_AFTER = 0;                     // silêncio após o qual a saída é 0: N + LATENCY (+ 2D + 1)
+        int stageStride = 0;                    // amostras entre estágios (SPREAD)
+        int hopBits = 0;                        // H = 2^hopBits
+        double olaScale = 0.0;                  // 2/(N·overlap): IFFT (1/N) + COLA da janela
+
+        Side sides[2];
+        uint64_t clock = 0;                     // nº de amostras processadas
+
+        // FFT/IFFT das vozes de um lado e janela (só a da precisão 'single')
+        Stft<double> sd;
+        Stft<float>  sf;
+        template <typename T> Stft<T>& stft() {
+            if constexpr (std::is_same<T, float>::value) return sf; else return sd;
+        }
+        FFTBackend::Kind fftKind = FFTBackend::Kind::FFTW;      // backend concreto em uso
+        const FFTBackend::Selection* fftSelection = nullptr;    // tempos medidos (cache global)
+
+        SpectralStream stream[2];               // frames por hop para a UI, ver spectra()
+        Mask2D mask2d;                          // HIST × K
+
+        // Multi‑resolução: Core dos agudos (no principal) / Core principal (no fine)
+        std::unique_ptr<Core> fine;
+        Core* coarse = nullptr;
+        std::vector<double> xoverTaps;          // h[D + i] = h[D − i], i = 0..D (passa‑baixo)
+        std::vector<double> xoverHist;          // [lado][voz][coarse − fine | fine][XRING]
+        int XRING = 0;                          // potência de 2 ≥ 2D + 1
+
+        Core* nextRetired = nullptr;            // pilha de Cores substituídos (lock‑free)
+    };
+
+    // Pipeline de um lado na precisão do Core (T = double ou float)
+    template <typename T>
+    void processSide(Core& c, int side, uint64_t t, const float* in, float* out);  // 1 amostra (out: do bloco pronto)
+    void crossover(Core& c, int side, uint64_t t, double* y, const double* fine);   // split: graves de y + agudos de fine
+    template <typename T>
+    void conditionBlock(Core& c, int side, uint64_t from);  // OLA [from, from+H) -> bloco pronto
+    float* readyBlock(Core& c, Side& s, uint64_t t) {       // bloco pronto que contém o instante t
+        const uint64_t rel = t + c.H - s.hopOffset;
+        return s.ready.data() + ((rel >> c.hopBits) & 1) * (size_t)MAX_VOICES * c.H;
+    }
+    template <typename T>
+    void runStage(Core& c, int side, int stage);    // executa 1 estágio do hop em curso
+    template <typename T>
+    void analyzeFFT(Core& c, int side);             // FFT -> extração mag/fase
+    void applyEffects(Core& c, int side, uint64_t time);   // FX sobre a magnitude (+ frame para a UI)
+    void publishBypassed(Core& c, int side, uint64_t time); // atalho: frame para a UI sem FX
+    void choosePaths(Core& c, int side);            // caminho de cada lado servido pelo hop que começa
+    template <typename T>
+    void synthesizeWithPhase(Core& c, int side);    // PhaseEngine -> espectro complexo
+    template <typename T>
+    void executeBatched(Core& c, int side, bool inverse);   // FFT/IFFT das C vozes
+    void finishHop(Core& c, int side);              // termina o hop em curso do lado (ou o de L, se emparelhado)
+    void clearVoices(Core& c, Side& s, int from, int to);   // limpa estado das vozes [from, to)
+    template <typename T>
+    void profileHops(Core& c, int hops, double* ns);        // ver profileStages()
+
+    Core* published() const { return shown.load(std::memory_order_acquire); }
+    void adopt(Core* next);         // thread de áudio: instala 'next' e reforma o Core atual
+    void workerLoop();              // thread de fundo: constrói Cores pedidos, liberta os antigos
+
+    SpectroParams params;
+    int voices[2] = { 1, 1 };
+    uint64_t hops = 0;
+    uint64_t fastHops = 0;
+#if SPECTROFX_PROFILE
+    HotPathStats hotPath;
+#endif
+
+    Core* active = nullptr;                     // Core do thread de áudio
+    std::atomic<Core*> shown   { nullptr };     // Core publicado à UI (= active após a troca)
+    std::atomic<Core*> pending { nullptr };     // Core novo à espera de ser adotado
+    std::atomic<Core*> retired { nullptr };     // Cores substituídos, a libertar pelo worker
+
+    // Thread de fundo (iniciado no 1º requestConfig)
+    std::thread worker;
+    std::mutex workerMutex;
+    std::condition_variable workerCv;
+    StftConfig requested;                       // último pedido (protegido por workerMutex)
+    bool requestPending = false;
+    bool stopWorker = false;
+};
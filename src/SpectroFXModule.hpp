@@ -1,32 +1,37 @@
 #pragma once
 #include "rack.hpp"
-#include <fftw3.h>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <algorithm>
 #include <cstring>
-#include "PhaseEngine.hpp"
-#include "Mask2D.hpp"
+#include "SpectroEngine.hpp"
 
 using namespace rack;
 
 /*
 SpectroFXModule (sem Griffin–Lim)
 
-Entradas:  L/R áudio
-Saídas  :  L/R áudio (bypass e processado)
+Entradas:  L/R áudio (polifónicas, até 16 vozes por lado)
+Saídas  :  L/R áudio (bypass e processado, com as vozes da entrada)
 
 Efeitos sobre a magnitude por bin (1D):
    BLUR, SHARPEN, EDGE, EMBOSS, MIRROR, GATE, STRETCH.
-Cada efeito tem knob L/R [0..1] e CV opcional (±10 V -> ±1.0).
+Cada efeito tem knob L/R [0..1] e CV opcional (±10 V -> ±1.0), comum a
+todas as vozes desse lado.
 
 Modos de fase (PhaseEngine):
-   RAW, PV, PV-Lock.
+   RAW, PV, PV-Lock, PGHI (fase reconstruída a partir da magnitude).
 
-STFT: janela √Hann, N=1024, H=N/2 (COLA garantido). Reconstrução por
-overlap‑add com IFFT escalada por 1/N. Latência ≈ N amostras.
+STFT: janela √Hann, N = 256..8192 (1024 por omissão) e sobreposição 2×/4×/8×
+escolhidos no menu de contexto; o N efetivo acompanha a frequência de
+amostragem (ver StftConfig). Reconstrução por overlap‑add normalizada para
+cada sobreposição. Latência = N + H amostras. Pipeline em double ou, por
+opção, em float (StftPrecision).
 
+O pipeline DSP vive em SpectroEngine (sem dependências do Rack); este
+módulo apenas lê knobs/CV e entrega amostras ao motor.
 A implementação está em SpectroFXModule.cpp. UI em SpectroFXWidget.hpp.
 */
 struct SpectroFXModule : Module {
@@ -66,49 +71,63 @@ struct SpectroFXModule : Module {
     // Luzes
     enum LightIds { NUM_LIGHTS };
 
-    // Constantes STFT 
-    static constexpr int N = 1024;              // Tamanho FFT
-    static constexpr int H = N / 2;             // hop (50% overlap, COLA com sqrt-Hann)
-    fftw_plan fftPlan[2]  = {nullptr, nullptr};
+    // Constantes STFT (ver SpectroEngine; N/H/K em runtime: engine.fftSize()/hopSize()/bins())
+    static constexpr int HIST = SpectroEngine::HIST;    // nº de colunas (tempo) da máscara 2D
 
-    // Magnitude pós‑efeitos (exposta ao espectrograma do Widget).
-    std::vector<std::vector<float>> processedMagnitude = std::vector<std::vector<float>>(2, std::vector<float>(N/2+1, 0.f));
+    // Motor DSP (STFT + FX + PhaseEngine), independente do Rack.
+    // Expõe mask() e spectra() ao Widget.
+    SpectroEngine engine;
 
-    // Máscara 2D (mesma largura do histórico do espectrograma).
-    static constexpr int HIST = 256; // nº de colunas (tempo)
-    Mask2D mask2d;  
+    // Agendamento dos hops (menu de contexto; guardado no patch)
+    HopSchedule hopSchedule = HopSchedule::IMMEDIATE;
+
+    // Condicionamento da saída (menu de contexto; guardados no patch, 0 = desligado)
+    float limiterDrive = 1.2f;      // soft‑limiter tanh(drive·y)/tanh(drive)
+    float dcBlockHz = 38.2f;        // corte do DC‑block
+
+    // Ordem da cadeia de efeitos por canal L/R (menu de contexto; guardada no patch).
+    // Escrita pela UI e lida pelo áudio em readParams(): empacotada (packFXOrder) num atómico.
+    std::atomic<uint32_t> fxOrder[2] = { packFXOrder(DEFAULT_FX_ORDER), packFXOrder(DEFAULT_FX_ORDER) };
+    FXOrder getFxOrder(int ch) const { return unpackFXOrder(fxOrder[ch].load(std::memory_order_relaxed)); }
+    void setFxOrder(int ch, const FXOrder& order) { fxOrder[ch].store(packFXOrder(order), std::memory_order_relaxed); }
+
+    // Tamanho da FFT (a 48 kHz) e sobreposição (menu de contexto; guardados no patch)
+    int fftSize = SpectroEngine::DEFAULT_N;
+    int overlap = 2;
+    float sampleRate = 48000.f;
+
+    // Backend FFT (menu de contexto; AUTO = o mais rápido medido para o N atual)
+    FFTBackend::Kind fftBackend = FFTBackend::Kind::AUTO;
+
+    // Precisão do pipeline STFT (menu de contexto; float: FFT mais barata, erro inaudível)
+    StftPrecision precision = StftPrecision::DOUBLE;
+
+    // L+R numa só FFT complexa por hop (menu de contexto; hops de L e R alinhados)
+    bool pairStereo = false;
+
+    // Espectrograma em escala logarítmica de frequência (menu de contexto; só UI)
+    bool logSpectrogram = false;
+
+#if SPECTROFX_PROFILE
+    // Instrumentação (build com PROFILE=1): janela de estatísticas (só UI, atualizada
+    // pelo Widget), sobreposição no espectrograma (guardada no patch) e estado do trace
+    HotPathStats::View statsView;
+    bool statsOverlay = false;
+    std::string tracePath;          // captura armada, a gravar aqui quando acabar
+    std::string traceStatus;        // última mensagem do trace (menu)
+#endif
+
+    // Pede ao motor a configuração atual (reconstrução em fundo, sem bloquear o áudio)
+    void applyStftConfig();
 
     SpectroFXModule();              // construtor
-    ~SpectroFXModule() override;    // destrutor
 
     void process(const ProcessArgs& args) override; // Chamada por áudio thread
-    void processChannel(int ch);                    // processa canal L(0)/R(1) 
-    void analyzeFFT(int ch);                        // FFT + extração mag/fase
-    void synthesizeWithPhase(int ch);               // IFFT + overlap-add
+    void onSampleRateChange(const SampleRateChangeEvent& e) override;  // N efetivo segue fs
+
+    json_t* dataToJson() override;              // guarda opções do menu
+    void dataFromJson(json_t* root) override;   // repõe opções do menu
 
 private:
-    // FFTW buffers/plans
-    double input[2][N] = {{0}};                     // time-domain in/out (ver .cpp)
-    fftw_complex output[2][N/2 + 1] = {};           // espectro complexo
-    fftw_plan ifftPlan[2] = {nullptr, nullptr};     // IFFT
-
-    // Buffers circulares + posições
-    double inputBuffer[2][N*2] = {{0}};             
-    double outputBuffer[2][N*2] = {{0}};            
-    int inputWritePos[2] = {0,0};                   
-    int outputWritePos[2] = {0,0};            
-    int outputReadPos[2]  = {0,0};      
-    int samplesSinceLastBlock[2] = {0,0};
-
-    // Janela √Hann (análise+síntese).
-    double hann[N];
-
-    // Fase / magnitude
-    std::vector<std::vector<float>> magIn, phaseIn, magProc, specRe, specIm;
-
-    // DC‑block (1ª ordem)
-    double dc_x1[2] = {0,0}, dc_y1[2] = {0,0};
-
-    // Motor de fase
-    PhaseEngine phaseEngine;
+    SpectroParams readParams();     // knobs + CV -> parâmetros do motor
 };
@@ -1,7 +1,9 @@
 #pragma once
 #include "rack.hpp"
 #include "SpectroFXModule.hpp"
+#include "SpectrogramImage.hpp"
 #include <cmath>
+#include <cstring>
 
 using namespace rack;
 using namespace rack::widget;
@@ -194,7 +196,7 @@ struct ModeLED : LightWidget {
     void drawLight(const DrawArgs& args) override {
         if (!mod) return;
         int m = (int)mod->params[SpectroFXModule::PHASE_MODE_PARAM].getValue();
-        NVGcolor c = (m==1) ? nvgRGB(60,190,255) : (m==2) ? nvgRGB(255,180,60) : nvgRGB(180,180,180);
+        NVGcolor c = (m==1) ? nvgRGB(60,190,255) : (m==2) ? nvgRGB(255,180,60) : (m==3) ? nvgRGB(120,230,120) : nvgRGB(180,180,180);
         nvgBeginPath(args.vg);
         nvgCircle(args.vg, box.size.x/2, box.size.y/2, box.size.x/2);
         nvgFillColor(args.vg, c);
@@ -208,7 +210,7 @@ struct ModeText : Widget {
     void draw(const DrawArgs& args) override {
         if (!mod) return;
         int m = (int)mod->params[SpectroFXModule::PHASE_MODE_PARAM].getValue();
-        const char* txt = (m==0) ? "RAW" : (m==1) ? "PV" : "PV-Lock";
+        const char* txt = (m==0) ? "RAW" : (m==1) ? "PV" : (m==2) ? "PV-Lock" : "PGHI";
         NVGcontext* vg = args.vg;
         nvgFontSize(vg, 8.f);
         nvgFillColor(vg, nvgRGB(0xc8,0xcf,0xd4));
@@ -217,87 +219,184 @@ struct ModeText : Widget {
     }
 };
 
-// Espectrograma
+// Espectrograma: imagem RGBA (HIST colunas × ROWS linhas) alimentada pela fila
+// de frames do canal L (SpectralStream) e desenhada como um só quad texturado,
+// com deslocamento circular em x. Cada coluna agrega os hops de 1/COLUMN_RATE s.
 struct SpectrogramDisplay : Widget {
-    SpectroFXModule* module;
-    std::vector<std::vector<float>> hist;
-    int pos = 0;
+    static constexpr float COLUMN_RATE = 60.f;  // colunas por segundo (≈ 4.3 s visíveis)
 
-    SpectrogramDisplay(SpectroFXModule* m) : module(m), hist(SpectroFXModule::HIST, std::vector<float>(SpectroFXModule::N/2 + 1, 0.f)) {
+    SpectroFXModule* module;
+    SpectralDecimator decimator;            // bins -> linhas, hops -> colunas
+    uint64_t source = 0;                    // Core (coreSerial) a que 'decimator' está ajustado
+    bool logFreq = false;                   // escala de 'decimator'
+    std::vector<uint8_t> pixels;            // RGBA [ROWS][HIST], ver SpectrogramImage
+    int image = 0;                          // textura NanoVG (0 = por criar)
+    int rows = 0;                           // linhas da textura (≈ altura em px)
+    int pos = 0;                            // próxima coluna a escrever (= mais antiga)
+
+    SpectrogramDisplay(SpectroFXModule* m) : module(m) {
         box.pos  = Vec(mm2pxf(67),  mm2pxf(17));
         box.size = Vec(mm2pxf(154), mm2pxf(81));
+        rows = std::max(1, (int)std::round(box.size.y));
     }
 
-    void draw(const DrawArgs& args) override {
-        if (!module || !module->fftPlan[0]) return;
-        const int N = SpectroFXModule::N;
-        const int K = N/2 + 1;
-        const int HISTORY_SIZE = SpectroFXModule::HIST;
-
-        // Alimenta histórico com a magnitude processada do canal L
-        for (int i = 0; i < K; ++i)
-            hist[pos][i] = module->processedMagnitude[0][i];
+    ~SpectrogramDisplay() {
+        if (image) nvgDeleteImage(APP->window->vg, image);
+    }
 
-        // Avança posição circularmente
-        pos = (pos + 1) % HISTORY_SIZE;
+    // Contexto GL recriado (ex.: ecrã inteiro): a textura antiga deixa de existir
+    void onContextDestroy(const ContextDestroyEvent& e) override {
+        if (image) nvgDeleteImage(e.vg, image);
+        image = 0;
+        Widget::onContextDestroy(e);
+    }
 
-        // Atualiza "head" da máscara 2D para coincidir com a coluna mais recente
-        if (module) { 
-            int latest = (pos + HISTORY_SIZE - 1) % HISTORY_SIZE; // direita
-            module->mask2d.head.store(latest, std::memory_order_relaxed);
+    void draw(const DrawArgs& args) override {
+        if (!module) return;
+        SpectroEngine& engine = module->engine;
+        const uint64_t serial = engine.coreSerial();
+        SpectralStream& stream = engine.spectra(0);
+        const int HISTORY_SIZE = SpectroFXModule::HIST;
+        if (stream.bins() < 2) return;
+
+        // Core novo (N/fs mudou) ou escala mudou: recomeça o histórico (magnitude 0).
+        // O K também se compara: serial e fila são lidos em separado e podem vir de Cores diferentes.
+        if (serial != source || stream.bins() != decimator.bins() || module->logSpectrogram != logFreq) {
+            source = serial;
+            logFreq = module->logSpectrogram;
+            const float hopRate = engine.config().sampleRate / engine.hopSize();
+            decimator.setup(stream.bins(), rows, logFreq, (int)std::lround(hopRate / COLUMN_RATE));
+            pos = 0;
+            const uint32_t c0 = SpectrogramImage::colormap().rgba[0];
+            pixels.resize((size_t)rows * HISTORY_SIZE * 4);
+            for (size_t i = 0; i < pixels.size(); i += 4) std::memcpy(&pixels[i], &c0, 4);
+            if (image) nvgUpdateImage(args.vg, image, pixels.data());
         }
 
-        // Render
-        for (int t = 0; t < HISTORY_SIZE; ++t) {
-            int idx = (pos + t) % HISTORY_SIZE;
-            float x  = (float)t / HISTORY_SIZE * box.size.x;
-            float bw = box.size.x / HISTORY_SIZE + 1.f;
-
-            for (int f = 0; f < K - 1; ++f) {
-                float mag  = hist[idx][f];
-                float norm = clamp(std::log(mag + 1e-6f) * 0.18f, 0.f, 1.f);
-                NVGcolor col = nvgHSLA(0.66f - norm * 0.66f, 1.0f, norm * 0.6f + 0.15f, 255);
-                float y  = box.size.y - ((float)f / (K - 1) * box.size.y);
-                float bh = box.size.y / (K - 1) + 1.f;
-
-                nvgBeginPath(args.vg);
-                nvgRect(args.vg, x, y, bw, bh);
-                nvgFillColor(args.vg, col);
-                nvgFill(args.vg);
-            }
-        }
+        // Colunas completas desde o último desenho (no máximo o ecrã inteiro)
+        const int columns = decimator.drain(stream, HISTORY_SIZE, [&](const float* col) {
+            SpectrogramImage::writeColumn(col, rows, pixels.data(), HISTORY_SIZE, pos);
+            pos = (pos + 1) % HISTORY_SIZE;     // avança posição circularmente
+        });
+
+        // Atualiza "head" da máscara com a coluna mais recente
+        int latest = (pos + HISTORY_SIZE - 1) % HISTORY_SIZE; // direita
+        engine.mask().head.store(latest, std::memory_order_relaxed);
+
+        if (!image)
+            image = nvgCreateImageRGBA(args.vg, HISTORY_SIZE, rows, NVG_IMAGE_REPEATX | NVG_IMAGE_NEAREST, pixels.data());
+        else if (columns > 0)
+            nvgUpdateImage(args.vg, image, pixels.data());
+        if (!image) return;
+
+        // Render: a coluna 'pos' (mais antiga) fica em x = 0, a mais recente à direita
+        const float W = box.size.x, H = box.size.y;
+        NVGpaint paint = nvgImagePattern(args.vg, -(float)pos / HISTORY_SIZE * W, 0.f, W, H, 0.f, image, 1.f);
+        nvgBeginPath(args.vg);
+        nvgRect(args.vg, 0.f, 0.f, W, H);
+        nvgFillPaint(args.vg, paint);
+        nvgFill(args.vg);
     }
 };
 
 // Máscara 2D Overlay (UI)
+//  - arrastar        : pinta pesos (pincel circular com feather) sobre o espectrograma
+//  - Alt + arrastar  : apaga
+//  - Shift + arrastar: seleciona a banda [lowBin, highBin] (retângulo)
+// As pinceladas editam o estado de edição da máscara e são publicadas 1× por frame.
+// Os pesos são desenhados como uma textura RGBA (HIST × linhas) com o mesmo
+// deslocamento circular do espectrograma (coluna do ring = coluna da imagem).
 struct MaskOverlay : Widget {
+    static constexpr float BRUSH_RADIUS = 12.f; // px
+
     SpectroFXModule* module = nullptr; 
     bool dragging = false;      // true durante drag
-    bool painting = true;       // (reservado) true pinta 1.0, Alt apaga 0.0
-    Vec a, b;                   // retângulo de seleção (UI)
+    bool selecting = false;     // Shift: retângulo de banda em vez de pincel
+    bool painting = true;       // true pinta 1.0, Alt apaga 0.0
+    bool pending = false;       // pinceladas por publicar (publish() em step())
+    Vec a, b;                   // retângulo de seleção / último ponto do pincel (UI)
+
+    std::vector<uint8_t> pixels;        // RGBA [rows][HIST]
+    int image = 0;                      // textura NanoVG (0 = por criar)
+    int rows = 0;                       // linhas da textura (≈ altura em px)
+    uint64_t shown = 0;                 // Core (coreSerial) da máscara desenhada em 'pixels'
+    int shownVersion = -1;              // versão publicada em 'pixels'
+    bool shownLog = false;              // escala de 'pixels'
 
     MaskOverlay(SpectroFXModule* m, Vec pos, Vec size) : module(m) {
         box.pos = pos; box.size = size;
+        rows = std::max(1, (int)std::round(box.size.y));
+    }
+
+    ~MaskOverlay() {
+        if (image) nvgDeleteImage(APP->window->vg, image);
     }
 
-    // Converte Y do ecrã -> bin [0..K-1] (eixo invertido: topo = alta frequência)
+    void onContextDestroy(const ContextDestroyEvent& e) override {
+        if (image) nvgDeleteImage(e.vg, image);
+        image = 0;
+        Widget::onContextDestroy(e);
+    }
+
+    // Converte Y do ecrã -> bin [0..K-1] (eixo invertido: topo = alta frequência; escala do espectrograma)
     inline int binFromY(float y) const {
         float t = clamp(y / box.size.y, 0.f, 1.f);
-        int K = SpectroFXModule::N/2 + 1;
-        int k = (int) std::round((1.f - t) * (K - 1));
+        int K = module->engine.bins();
+        int k = (int) std::round(SpectralDecimator::binAt(1.f - t, K, module->logSpectrogram));
         return std::clamp(k, 0, K-1);
     }
 
+    // Bin (contínuo) -> Y do ecrã
+    inline float yFromBin(float k) const {
+        int K = module->engine.bins();
+        return (1.f - SpectralDecimator::positionOf(k, K, module->logSpectrogram)) * box.size.y;
+    }
+
+    // Um toque do pincel centrado em p (px): colunas e bins a menos de BRUSH_RADIUS
+    void stamp(Vec p) {
+        Mask2D& m = module->engine.mask();
+        const float colW = box.size.x / m.HIST, R = BRUSH_RADIUS;
+        const int k0 = binFromY(p.y + R), k1 = binFromY(p.y - R);
+        const int d0 = std::max(0, (int)std::floor((p.x - R) / colW));
+        const int d1 = std::min(m.HIST - 1, (int)std::floor((p.x + R) / colW));
+        for (int d = d0; d <= d1; ++d) {
+            const float dx = (d + 0.5f) * colW - p.x;
+            m.paint(m.ringColFromDisplayCol(d), k0, k1, painting ? 1.f : 0.f, [&](int k) {
+                const float dy = yFromBin((float)k) - p.y;
+                const float t = 1.f - std::sqrt(dx * dx + dy * dy) / R;   // 1 no centro, 0 na borda
+                return t <= 0.f ? 0.f : t * t * (3.f - 2.f * t);           // smoothstep
+            });
+        }
+        pending = true;
+    }
+
+    // Pincelada de a até b: toques espaçados de 1/3 do raio (sem falhas entre eventos)
+    void stroke(Vec from, Vec to) {
+        const float len = to.minus(from).norm();
+        const int n = std::max(1, (int)std::ceil(len / (BRUSH_RADIUS / 3.f)));
+        for (int i = 1; i <= n; ++i) stamp(from.crossfade(to, (float)i / n));
+    }
+
     // Eventos do rato
     void onButton(const event::Button& e) override {
         if (!module || e.button != GLFW_MOUSE_BUTTON_LEFT) return;
         if (e.action == GLFW_PRESS) {
-            dragging = true; a = b = e.pos; e.consume(this);
+            dragging = true; a = b = e.pos;
+            selecting = (e.mods & RACK_MOD_MASK) == GLFW_MOD_SHIFT;
+            painting  = !(e.mods & GLFW_MOD_ALT);
+            if (!selecting) {
+                Mask2D& m = module->engine.mask();
+                if (!m.enabled()) m.edit().enabled = true;      // pintar ativa a máscara
+                stamp(e.pos);
+            }
+            e.consume(this);
         } else if (e.action == GLFW_RELEASE) {
             dragging = false;
-            int k0 = binFromY(a.y), k1 = binFromY(b.y);
-            if (k0 > k1) std::swap(k0, k1);
-            module->mask2d.setBounds(k0, k1);
+            if (selecting) {
+                int k0 = binFromY(a.y), k1 = binFromY(b.y);
+                if (k0 > k1) std::swap(k0, k1);
+                module->engine.mask().setBounds(k0, k1);
+            }
             e.consume(this);
         }
     }
@@ -305,32 +404,73 @@ struct MaskOverlay : Widget {
     // Evento drag
     void onDragMove(const event::DragMove& e) override {
         if (!dragging) return;
+        const Vec prev = b;
         b = b.plus(e.mouseDelta);
         b.x = rack::clamp(b.x, 0.f, box.size.x);
         b.y = rack::clamp(b.y, 0.f, box.size.y);
+        if (!selecting) stroke(prev, b);
         e.consume(this);
     }
-    
+
+    // Publica as pinceladas do frame (uma só troca com o áudio por frame)
+    void step() override {
+        if (module && pending) {
+            module->engine.mask().publish();
+            pending = false;
+        }
+        Widget::step();
+    }
+
+    // Reconstrói 'pixels' a partir do estado de edição (pesos fora da banda a 0)
+    void updatePixels(const Mask2D& m) {
+        const int HIST = m.HIST;
+        pixels.assign((size_t)rows * HIST * 4, 0);
+        const Mask2D::State& s = m.edit();
+        for (int r = 0; r < rows; ++r) {
+            const int k = binFromY((r + 0.5f) * box.size.y / rows);
+            if (k < s.lowBin || k > s.highBin) continue;
+            uint8_t* px = &pixels[(size_t)r * HIST * 4];
+            for (int c = 0; c < HIST; ++c, px += 4) {
+                const float w = clamp(s.column(c, m.stride)[k], 0.f, 1.f);
+                px[0] = 30; px[1] = 200; px[2] = 60;
+                px[3] = (uint8_t)std::lround(w * 72.f);
+            }
+        }
+    }
+
     // Desenho
     void draw(const DrawArgs& args) override {
-        const bool enabled = module && module->mask2d.enabled.load();
+        const bool enabled = module && module->engine.mask().enabled();
 
-        // Banda verde (ON)
+        // Pesos pintados + linhas de limites (ON)
         if (enabled) {
-            int K = SpectroFXModule::N/2 + 1;
-            int lo = module->mask2d.lowBin.load();
-            int hi = module->mask2d.highBin.load();
-
-            float yTop    = (1.f - (float)(hi+1) / K) * box.size.y;
-            float yBottom = (1.f - (float)lo      / K) * box.size.y;
-
-            nvgBeginPath(args.vg);
-            nvgRect(args.vg, 0.f, yTop, box.size.x, yBottom - yTop);
-            nvgFillColor(args.vg, nvgRGBA(30, 200, 60, 64));
-            nvgFill(args.vg);
+            const uint64_t serial = module->engine.coreSerial();
+            Mask2D& m = module->engine.mask();
+            const int HIST = m.HIST;
+            int lo = m.lowBin();
+            int hi = m.highBin();
+
+            // Textura dos pesos: refeita só quando a máscara (ou a escala) mudou
+            const bool stale = serial != shown || m.version() != shownVersion || module->logSpectrogram != shownLog;
+            if (stale) {
+                updatePixels(m);
+                shown = serial; shownVersion = m.version(); shownLog = module->logSpectrogram;
+                if (image) nvgUpdateImage(args.vg, image, pixels.data());
+            }
+            if (!image)
+                image = nvgCreateImageRGBA(args.vg, HIST, rows, NVG_IMAGE_REPEATX | NVG_IMAGE_NEAREST, pixels.data());
+            if (image) {
+                const float W = box.size.x, H = box.size.y;
+                const int oldest = (m.head.load(std::memory_order_relaxed) + 1) % HIST;
+                NVGpaint paint = nvgImagePattern(args.vg, -(float)oldest / HIST * W, 0.f, W, H, 0.f, image, 1.f);
+                nvgBeginPath(args.vg);
+                nvgRect(args.vg, 0.f, 0.f, W, H);
+                nvgFillPaint(args.vg, paint);
+                nvgFill(args.vg);
+            }
 
             // Linhas de bounds
-            auto yForBin = [&](int k){ return (1.f - (float)k / (SpectroFXModule::N/2)) * box.size.y; };
+            auto yForBin = [&](int k){ return yFromBin((float)k); };
             nvgBeginPath(args.vg);
             nvgMoveTo(args.vg, 0.f, yForBin(lo));
             nvgLineTo(args.vg, box.size.x, yForBin(lo));
@@ -346,8 +486,8 @@ struct MaskOverlay : Widget {
             nvgStroke(args.vg);
         }
 
-        // Retângulo de seleção (durante drag)
-        if (dragging) {
+        // Retângulo de seleção (Shift + drag)
+        if (dragging && selecting) {
             nvgBeginPath(args.vg);
             nvgRect(args.vg, std::min(a.x,b.x), std::min(a.y,b.y), std::fabs(b.x-a.x), std::fabs(b.y-a.y));
             nvgStrokeColor(args.vg, nvgRGBA(255,255,255,160));
@@ -357,6 +497,41 @@ struct MaskOverlay : Widget {
     }
 };
 
+#if SPECTROFX_PROFILE
+// Linha de estatísticas de um kind na última janela (µs)
+static inline std::string statsLine(const HotPathStats::View& v, int kind) {
+    const HotPathStats::View::Row& r = v.rows[kind];
+    return string::f("%-7s p50 %7.1f  p99 %7.1f  max %7.1f µs", HotPathStats::kindName(kind),
+                     r.p50 * 1e-3, r.p99 * 1e-3, r.max * 1e-3);
+}
+static inline std::string statsRates(const HotPathStats::View& v) {
+    const HotPathStats::View::Row& hop = v.rows[HotPathStats::HOP];
+    const HotPathStats::View::Row& smp = v.rows[HotPathStats::SAMPLE];
+    return string::f("%.0f hops/s, late hops %llu (%llu total), samples > 1/fs %llu", hop.rate,
+                     (unsigned long long)hop.misses, (unsigned long long)hop.missesTotal, (unsigned long long)smp.misses);
+}
+
+// Estatísticas sobre o canto superior esquerdo do espectrograma (menu de contexto)
+struct StatsOverlay : Widget {
+    SpectroFXModule* module = nullptr;
+    void draw(const DrawArgs& args) override {
+        if (!module || !module->statsOverlay || !module->statsView.valid) return;
+        const HotPathStats::View& v = module->statsView;
+        const std::string lines[] = { statsLine(v, HotPathStats::SAMPLE), statsLine(v, HotPathStats::HOP), statsRates(v) };
+        NVGcontext* vg = args.vg;
+        nvgBeginPath(vg);
+        nvgRect(vg, 0.f, 0.f, box.size.x, 4.f + 10.f * 3);
+        nvgFillColor(vg, nvgRGBA(0, 0, 0, 150));
+        nvgFill(vg);
+        nvgFontSize(vg, 8.f);
+        nvgFillColor(vg, nvgRGB(0xc8,0xcf,0xd4));
+        nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+        for (int i = 0; i < 3; ++i)
+            nvgText(vg, 3.f, 2.f + 10.f * i, lines[i].c_str(), nullptr);
+    }
+};
+#endif
+
 // Widget principal
 struct SpectroFXWidget : ModuleWidget {
     SpectroFXWidget(SpectroFXModule* module) {
@@ -446,13 +621,41 @@ struct SpectroFXWidget : ModuleWidget {
         auto specSize = Vec(mm2pxf(154), mm2pxf(81));
         auto* mask = new MaskOverlay(module, specRect, specSize);
         addChild(mask);
+
+#if SPECTROFX_PROFILE
+        // Estatísticas por cima (sem eventos de rato: a máscara continua a recebê-los)
+        auto* stats = new StatsOverlay();
+        stats->module = module;
+        stats->box.pos  = specRect;
+        stats->box.size = Vec(specSize.x, 34.f);
+        addChild(stats);
+#endif
+    }
+
+#if SPECTROFX_PROFILE
+    // Janela de estatísticas (1 s) e trace pedido no menu, gravado quando o áudio o completar
+    void step() override {
+        if (auto* m = dynamic_cast<SpectroFXModule*>(module)) {
+            HotPathStats& stats = m->engine.stats();
+            const double fs = m->engine.config().sampleRate;
+            m->statsView.budgetNs[HotPathStats::SAMPLE] = 1e9 / fs;                     // 1 amostra
+            m->statsView.budgetNs[HotPathStats::HOP] = 1e9 * m->engine.hopSize() / fs;  // período do hop
+            m->statsView.update(stats);
+            if (!m->tracePath.empty() && stats.captureDone()) {
+                std::string err;
+                m->traceStatus = stats.writeChromeTrace(m->tracePath, &err) ? "Trace: " + system::getFilename(m->tracePath) : err;
+                m->tracePath.clear();
+            }
+        }
+        ModuleWidget::step();
     }
+#endif
 
-    // Menu de contexto RAW / PV / PV-Lock + opções da máscara
+    // Menu de contexto RAW / PV / PV-Lock / PGHI + opções da máscara
     void appendContextMenu(Menu* menu) override {
         auto* mod = dynamic_cast<SpectroFXModule*>(module);
         menu->addChild(new MenuSeparator());
-        const char* lbl[] = {"RAW", "PV", "PV-Lock"};
+        const char* lbl[] = {"RAW", "PV", "PV-Lock", "PGHI"};
         struct MI : MenuItem { SpectroFXModule* m=nullptr; int v=0;
             void onAction(const event::Action&) override {
                 if (m) m->params[SpectroFXModule::PHASE_MODE_PARAM].setValue((float)v);
@@ -462,43 +665,229 @@ struct SpectroFXWidget : ModuleWidget {
                 MenuItem::step();
             }
         };
-        for (int i=0;i<3;++i) {
+        for (int i=0;i<4;++i) {
             auto* it = new MI; it->text = lbl[i]; it->m = mod; it->v = i; menu->addChild(it);
         }
 
         menu->addChild(new MenuSeparator());
 
+        // Agendamento dos hops: tudo numa amostra vs. repartido pelo hop
+        const char* schedLbl[] = {"Hop: immediate", "Hop: spread (flat CPU)"};
+        struct SchedItem : MenuItem { SpectroFXModule* m=nullptr; HopSchedule v=HopSchedule::IMMEDIATE;
+            void onAction(const event::Action&) override { if (m) m->hopSchedule = v; }
+            void step() override { rightText = (m && m->hopSchedule == v) ? "✔" : ""; MenuItem::step(); }
+        };
+        for (int i=0;i<2;++i) {
+            auto* it = new SchedItem; it->text = schedLbl[i]; it->m = mod; it->v = HopSchedule(i); menu->addChild(it);
+        }
+
+        menu->addChild(new MenuSeparator());
+
+        // Condicionamento da saída: soft‑limiter (drive) e corte do DC‑block; 0 = desligado
+        const char* limLbl[] = {"Limiter: off", "Limiter: soft", "Limiter: medium", "Limiter: hard"};
+        const float limDrive[] = {0.f, 1.2f, 2.f, 4.f};
+        struct LimItem : MenuItem { SpectroFXModule* m=nullptr; float v=1.2f;
+            void onAction(const event::Action&) override { if (m) m->limiterDrive = v; }
+            void step() override { rightText = (m && m->limiterDrive == v) ? "✔" : ""; MenuItem::step(); }
+        };
+        for (int i=0;i<4;++i) {
+            auto* it = new LimItem; it->text = limLbl[i]; it->m = mod; it->v = limDrive[i]; menu->addChild(it);
+        }
+        const char* dcLbl[] = {"DC block: off", "DC block: 5 Hz", "DC block: 10 Hz", "DC block: 20 Hz", "DC block: 38 Hz"};
+        const float dcHz[] = {0.f, 5.f, 10.f, 20.f, 38.2f};
+        struct DcItem : MenuItem { SpectroFXModule* m=nullptr; float v=38.2f;
+            void onAction(const event::Action&) override { if (m) m->dcBlockHz = v; }
+            void step() override { rightText = (m && m->dcBlockHz == v) ? "✔" : ""; MenuItem::step(); }
+        };
+        for (int i=0;i<5;++i) {
+            auto* it = new DcItem; it->text = dcLbl[i]; it->m = mod; it->v = dcHz[i]; menu->addChild(it);
+        }
+
+        menu->addChild(new MenuSeparator());
+
+        // Ordem da cadeia de efeitos por canal: clicar sobe o efeito uma posição (menu fica aberto)
+        struct OrderItem : MenuItem { SpectroFXModule* m=nullptr; int ch=0, pos=0;
+            void onAction(const event::Action& e) override {
+                if (m && pos > 0) {     // cópia local, publicada inteira (o áudio nunca vê meia troca)
+                    FXOrder order = m->getFxOrder(ch);
+                    std::swap(order[pos], order[pos - 1]);
+                    m->setFxOrder(ch, order);
+                }
+                e.unconsume();
+            }
+            void step() override {
+                if (m) text = string::f("%d. %s", pos + 1, SpectralFX::name(m->getFxOrder(ch)[pos]));
+                rightText = pos > 0 ? "▲" : "";
+                MenuItem::step();
+            }
+        };
+        struct ResetOrder : MenuItem { SpectroFXModule* m=nullptr; int ch=0;
+            void onAction(const event::Action& e) override { if (m) m->setFxOrder(ch, DEFAULT_FX_ORDER); e.unconsume(); }
+        };
+        struct OrderMenu : MenuItem { SpectroFXModule* m=nullptr; int ch=0;
+            Menu* createChildMenu() override {
+                Menu* sub = new Menu;
+                for (int i = 0; i < (int)Effect::NUM_EFFECTS; ++i) {
+                    auto* it = new OrderItem; it->m = m; it->ch = ch; it->pos = i; sub->addChild(it);
+                }
+                sub->addChild(new MenuSeparator());
+                auto* rs = new ResetOrder; rs->text = "Reset order"; rs->m = m; rs->ch = ch; sub->addChild(rs);
+                return sub;
+            }
+        };
+        const char* orderLbl[] = {"FX order L", "FX order R"};
+        for (int ch=0;ch<2;++ch) {
+            auto* it = new OrderMenu; it->text = orderLbl[ch]; it->rightText = RIGHT_ARROW; it->m = mod; it->ch = ch; menu->addChild(it);
+        }
+
+        menu->addChild(new MenuSeparator());
+
+        // Tamanho da FFT (a 48 kHz; escala com fs) e sobreposição: reconstrução em fundo
+        struct FftItem : MenuItem { SpectroFXModule* m=nullptr; int n=1024;
+            void onAction(const event::Action&) override { if (m) { m->fftSize = n; m->applyStftConfig(); } }
+            void step() override { rightText = (m && m->fftSize == n) ? "✔" : ""; MenuItem::step(); }
+        };
+        for (int n=256;n<=8192;n*=2) {
+            auto* it = new FftItem; it->text = string::f("FFT %d", n); it->m = mod; it->n = n; menu->addChild(it);
+        }
+        struct OverlapItem : MenuItem { SpectroFXModule* m=nullptr; int v=2;
+            void onAction(const event::Action&) override { if (m) { m->overlap = v; m->applyStftConfig(); } }
+            void step() override { rightText = (m && m->overlap == v) ? "✔" : ""; MenuItem::step(); }
+        };
+        for (int v=2;v<=8;v*=2) {
+            auto* it = new OverlapItem; it->text = string::f("Overlap %d×", v); it->m = mod; it->v = v; menu->addChild(it);
+        }
+
+        menu->addChild(new MenuSeparator());
+
+        // Backend FFT: auto (o mais rápido para o N atual) ou forçado; tempos do micro‑benchmark
+        struct BackendItem : MenuItem { SpectroFXModule* m=nullptr; FFTBackend::Kind v=FFTBackend::Kind::AUTO;
+            void onAction(const event::Action&) override { if (m) { m->fftBackend = v; m->applyStftConfig(); } }
+            void step() override { rightText = (m && m->fftBackend == v) ? "✔" : ""; MenuItem::step(); }
+        };
+        menu->addChild(createMenuLabel("FFT backend (forward+inverse, 1 voice)"));
+        for (int i=0;i<(int)FFTBackend::Kind::REFERENCE;++i) {
+            const FFTBackend::Kind k = FFTBackend::Kind(i);
+            auto* it = new BackendItem; it->m = mod; it->v = k;
+            if (!mod)
+                it->text = string::f("FFT: %s", FFTBackend::name(k));
+            else if (k == FFTBackend::Kind::AUTO)
+                it->text = string::f("FFT: auto (using %s)", FFTBackend::name(mod->engine.fftBackend()));
+            else
+                it->text = string::f("FFT: %s  %.1f µs%s", FFTBackend::name(k), mod->engine.fftTimings().nsPerPair[i] * 1e-3,
+                                     mod->engine.fftTimings().provisional && k != FFTBackend::Kind::RADIX ? " (unoptimized plan)" : "");
+            menu->addChild(it);
+        }
+
+        // Precisão do pipeline STFT: double (referência) ou float (FFT ~2× mais barata)
+        const char* precLbl[] = {"Precision: 64-bit", "Precision: 32-bit (faster)"};
+        struct PrecisionItem : MenuItem { SpectroFXModule* m=nullptr; StftPrecision v=StftPrecision::DOUBLE;
+            void onAction(const event::Action&) override { if (m) { m->precision = v; m->applyStftConfig(); } }
+            void step() override { rightText = (m && m->precision == v) ? "✔" : ""; MenuItem::step(); }
+        };
+        for (int i=0;i<2;++i) {
+            auto* it = new PrecisionItem; it->text = precLbl[i]; it->m = mod; it->v = StftPrecision(i); menu->addChild(it);
+        }
+
+        // Estéreo emparelhado: L e R numa só FFT complexa (two‑for‑one), hops alinhados
+        struct PairItem : MenuItem { SpectroFXModule* m=nullptr;
+            void onAction(const event::Action&) override { if (m) { m->pairStereo = !m->pairStereo; m->applyStftConfig(); } }
+            void step() override { rightText = (m && m->pairStereo) ? "ON" : "OFF"; MenuItem::step(); }
+        };
+        auto* pi = new PairItem; pi->text = "Stereo: L+R in one FFT"; pi->m = mod; menu->addChild(pi);
+
+        menu->addChild(new MenuSeparator());
+
+        // Eixo de frequência do espectrograma (e da máscara): linear ou logarítmico
+        struct LogFreqItem : MenuItem { SpectroFXModule* m=nullptr;
+            void onAction(const event::Action&) override { if (m) m->logSpectrogram = !m->logSpectrogram; }
+            void step() override { rightText = (m && m->logSpectrogram) ? "ON" : "OFF"; MenuItem::step(); }
+        };
+        auto* lf = new LogFreqItem; lf->text = "Spectrogram: log frequency"; lf->m = mod; menu->addChild(lf);
+
         // Opções da máscara 2D
         struct ToggleMask : MenuItem { SpectroFXModule* m=nullptr;
-            void onAction(const event::Action&) override { if (m) m->mask2d.enabled.store(!m->mask2d.enabled.load()); }
-            void step() override { rightText = (m && m->mask2d.enabled.load()) ? "ON" : "OFF"; MenuItem::step(); }
+            void onAction(const event::Action&) override { if (m) m->engine.mask().setEnabled(!m->engine.mask().enabled()); }
+            void step() override { rightText = (m && m->engine.mask().enabled()) ? "ON" : "OFF"; MenuItem::step(); }
         };
         auto* tm = new ToggleMask; tm->text = "Mask 2D"; tm->m = mod; menu->addChild(tm);
 
         struct Bounds : MenuItem { SpectroFXModule* m=nullptr; bool high=false;
             void onAction(const event::Action&) override {
                 if (!m) return;
-                int K = SpectroFXModule::N/2 + 1;
+                int K = m->engine.bins();
                 // Exemplo: 25%..75% da banda
                 int lo = K/4, hi = 3*K/4;
-                m->mask2d.setBounds(lo, hi);
+                m->engine.mask().setBounds(lo, hi);
             }
         };
         auto* b = new Bounds; b->text = "Set bounds 25%..75%"; b->m = mod; menu->addChild(b);
 
         struct ClearMask : MenuItem { SpectroFXModule* m=nullptr;
-            void onAction(const event::Action&) override { if (m) m->mask2d.enabled.store(false); }
+            void onAction(const event::Action&) override { if (m) m->engine.mask().setEnabled(false); }
         };
         auto* cl = new ClearMask; cl->text = "Clear mask (disable)"; cl->m = mod; menu->addChild(cl);
 
         struct FillMask : MenuItem { SpectroFXModule* m=nullptr;
             void onAction(const event::Action&) override {
                 if (!m) return;
-                int K = SpectroFXModule::N/2 + 1;
-                m->mask2d.setBounds(0, K-1);       // toda a banda
-                m->mask2d.enabled.store(true);
+                int K = m->engine.bins();
+                m->engine.mask().setBounds(0, K-1);       // toda a banda
+                m->engine.mask().setEnabled(true);
             }
         };
         auto* fl = new FillMask; fl->text = "Fill mask (full band)"; fl->m = mod; menu->addChild(fl);
+
+        // Pintura: repor todos os pesos a 1 (efeito em todo o lado) ou a 0 (pintar para aplicar)
+        struct PaintFill : MenuItem { SpectroFXModule* m=nullptr; float v=1.f;
+            void onAction(const event::Action&) override { if (m) m->engine.mask().clear(v); }
+        };
+        auto* pf = new PaintFill; pf->text = "Mask: reset painting (all on)"; pf->m = mod; pf->v = 1.f; menu->addChild(pf);
+        auto* pe = new PaintFill; pe->text = "Mask: erase painting (paint to apply)"; pe->m = mod; pe->v = 0.f; menu->addChild(pe);
+
+#if SPECTROFX_PROFILE
+        menu->addChild(new MenuSeparator());
+
+        // Instrumentação: estatísticas ao vivo (janela de 1 s), sobreposição e trace
+        struct StatLine : MenuLabel { SpectroFXModule* m=nullptr; int kind=-1;
+            void step() override {
+                if (m) text = !m->statsView.valid ? "(measuring...)" : kind < 0 ? statsRates(m->statsView) : statsLine(m->statsView, kind);
+                MenuLabel::step();
+            }
+        };
+        struct OverlayItem : MenuItem { SpectroFXModule* m=nullptr;
+            void onAction(const event::Action&) override { if (m) m->statsOverlay = !m->statsOverlay; }
+            void step() override { rightText = (m && m->statsOverlay) ? "ON" : "OFF"; MenuItem::step(); }
+        };
+        struct ResetStats : MenuItem { SpectroFXModule* m=nullptr;
+            void onAction(const event::Action&) override { if (m) { m->engine.stats().clear(); m->statsView.reset(); } }
+        };
+        struct TraceItem : MenuItem { SpectroFXModule* m=nullptr;
+            void onAction(const event::Action&) override {
+                if (!m || !m->tracePath.empty()) return;
+                const std::string dir = asset::user(pluginInstance->slug);
+                system::createDirectories(dir);
+                m->tracePath = system::join(dir, string::f("trace-%.0f.json", system::getUnixTime()));
+                m->engine.stats().armCapture(1 << 18);      // ≈ 4 s de process() a 48 kHz
+                m->traceStatus = "Trace: capturing...";
+            }
+            void step() override { rightText = m ? m->traceStatus : ""; MenuItem::step(); }
+        };
+        struct StatsMenu : MenuItem { SpectroFXModule* m=nullptr;
+            Menu* createChildMenu() override {
+                Menu* sub = new Menu;
+                const int kinds[] = { -1, HotPathStats::SAMPLE, HotPathStats::HOP, HotPathStats::WINDOW, HotPathStats::FFT,
+                                      HotPathStats::ANALYZE, HotPathStats::EFFECTS, HotPathStats::SYNTH, HotPathStats::IFFT,
+                                      HotPathStats::OLA };
+                for (int k : kinds) { auto* l = new StatLine; l->m = m; l->kind = k; sub->addChild(l); }
+                sub->addChild(new MenuSeparator());
+                auto* ov = new OverlayItem; ov->text = "Show on spectrogram"; ov->m = m; sub->addChild(ov);
+                auto* rs = new ResetStats; rs->text = "Reset statistics"; rs->m = m; sub->addChild(rs);
+                auto* tr = new TraceItem; tr->text = "Export trace (Chrome/Perfetto JSON)"; tr->m = m; sub->addChild(tr);
+                return sub;
+            }
+        };
+        auto* st = new StatsMenu; st->text = "Performance"; st->rightText = RIGHT_ARROW; st->m = mod; menu->addChild(st);
+#endif
     }
 };
@@ -0,0 +1,73 @@
+#include "SpectrogramImage.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace SpectrogramImage {
+
+namespace {
+
+// Componente HSL -> RGB (igual ao nvgHSLA do NanoVG)
+float hue(float h, float m1, float m2) {
+    if (h < 0.f) h += 1.f;
+    if (h > 1.f) h -= 1.f;
+    if (h < 1.f / 6.f) return m1 + (m2 - m1) * h * 6.f;
+    if (h < 3.f / 6.f) return m2;
+    if (h < 4.f / 6.f) return m1 + (m2 - m1) * (2.f / 3.f - h) * 6.f;
+    return m1;
+}
+
+uint8_t toByte(float c) {
+    return (uint8_t)std::lround(std::clamp(c, 0.f, 1.f) * 255.f);
+}
+
+// Cor de um norm ∈ [0, 1] (HSL com s = 1, alfa 255), empacotada R,G,B,A em memória
+uint32_t colorOf(float norm) {
+    const float h = 0.66f - norm * 0.66f;
+    const float l = norm * 0.6f + 0.15f;
+    const float m2 = l <= 0.5f ? l * 2.f : 1.f;         // s = 1
+    const float m1 = 2.f * l - m2;
+    const uint8_t px[4] = { toByte(hue(h + 1.f / 3.f, m1, m2)), toByte(hue(h, m1, m2)),
+                            toByte(hue(h - 1.f / 3.f, m1, m2)), 255 };
+    uint32_t c;
+    std::memcpy(&c, px, 4);
+    return c;
+}
+
+Colormap build() {
+    Colormap m;
+    for (int i = 0; i < LEVELS; ++i)
+        m.rgba[i] = colorOf((float)i / (LEVELS - 1));
+    // Nível i = round(norm · (LEVELS−1)): começa em norm = (i − ½)/(LEVELS−1)
+    for (int i = 1; i < LEVELS; ++i)
+        m.threshold[i - 1] = (float)(std::exp((i - 0.5) / ((LEVELS - 1) * 0.18)) - 1e-6);
+    return m;
+}
+
+} // namespace
+
+const Colormap& colormap() {
+    static const Colormap m = build();
+    return m;
+}
+
+int level(float mag) {
+    const Colormap& m = colormap();
+    return (int)(std::upper_bound(m.threshold, m.threshold + LEVELS - 1, mag) - m.threshold);
+}
+
+void writeColumn(const float* mag, int rows, uint8_t* image, int width, int column) {
+    const Colormap& m = colormap();
+    uint8_t* px = image + (size_t)column * 4;
+    for (int r = 0; r < rows; ++r, px += (size_t)width * 4) {
+        const uint32_t c = m.rgba[level(mag[rows - 1 - r])];
+        std::memcpy(px, &c, 4);
+    }
+}
+
+uint32_t referenceColor(float mag) {
+    const float norm = std::fmax(std::fmin(std::log(mag + 1e-6f) * 0.18f, 1.f), 0.f);
+    return colorOf(norm);
+}
+
+} // namespace SpectrogramImage
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+/*
+ SpectrogramImage
+
+ Geração das colunas do espectrograma como imagem RGBA (sem Rack/NanoVG),
+ para a UI desenhar um único quad texturado em vez de uma célula por bin.
+
+ Imagem: 'width' colunas (ring temporal) × 'rows' linhas, RGBA8 row‑major;
+ cada coluna vem de SpectralDecimator (valor 0 = graves, desenhado em baixo).
+
+ Mapa de cores: o mesmo da versão por células,
+    norm = clamp(ln(mag + 1e−6) · 0.18, 0, 1)
+    cor  = HSLA(0.66 − 0.66·norm, 1, 0.15 + 0.6·norm, 255)
+ quantizado em LEVELS níveis. Em vez de log + HSL por célula, cada bin faz
+ uma pesquisa binária nos limiares de magnitude entre níveis e lê a cor da
+ LUT. Diferença face à fórmula contínua ≤ 2 LSB por canal (quantização de
+ norm); verificável com 'spectrofx-bench --verify-colormap'.
+ */
+namespace SpectrogramImage {
+
+constexpr int LEVELS = 1024;
+
+struct Colormap {
+    uint32_t rgba[LEVELS];              // cor do nível i (bytes R,G,B,A por esta ordem em memória)
+    float    threshold[LEVELS - 1];     // magnitude mínima do nível i+1 (crescente)
+};
+
+// LUT partilhada (construída uma vez, thread‑safe)
+const Colormap& colormap();
+
+// Nível [0, LEVELS) de uma magnitude (NaN -> último nível, como o clamp original)
+int level(float mag);
+
+// Escreve a coluna 'column' de 'image' (width × rows píxeis RGBA) a partir de mag[0..rows−1]
+void writeColumn(const float* mag, int rows, uint8_t* image, int width, int column);
+
+// Cor da fórmula contínua (log + HSL, sem LUT), para verificação
+uint32_t referenceColor(float mag);
+
+} // namespace SpectrogramImage
@@ -1,5 +1,6 @@
 #include "plugin.hpp"
 #include "SpectroFXModule.hpp"
+#include "PlanCache.hpp"
 
 // Ponteiro global para a instância do plugin.
 Plugin* pluginInstance;
@@ -7,5 +8,13 @@ Plugin* pluginInstance;
 // Chamado pelo Rack ao carregar o plugin.
 void init(Plugin* p) {
     pluginInstance = p;
+
+    // Wisdom FFTW (double e float) na pasta de utilizador do plugin: a partir
+    // da 2ª sessão os planos finais (FFTW_PATIENT) são obtidos sem medições (ver PlanCache).
+    std::string dir = asset::user(p->slug);
+    system::createDirectories(dir);
+    PlanCache::setWisdomFile(system::join(dir, "fftw-wisdom.txt"));
+    PlanCache::setWisdomFile(system::join(dir, "fftwf-wisdom.txt"), true);
+
     p->addModel(modelSpectroFXModule); // Regista o módulo "SpectroFX"
 }
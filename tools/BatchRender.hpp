@@ -0,0 +1,489 @@
+#pragma once
+#include "SpectroEngine.hpp"
+#include "WavStream.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+ BatchRender
+
+ Render offline de uma lista de WAV pelo mesmo pipeline do módulo
+ (SpectroEngine: STFT, SpectralFX, máscara, PhaseEngine, condicionamento),
+ para spectrofx-render. Só usado pelas ferramentas.
+
+ Preset (BatchPreset, texto 'chave = valor', '#' comenta o resto da linha)
+    blur sharpen edge emboss mirror gate stretch = 0..1   os dois lados
+    blur.L = 0..1, blur.R = ...                           só um lado
+    order     = gate mirror ...   ordem da cadeia (order.L / order.R: só um
+                                  lado); os efeitos em falta seguem‑se pela
+                                  ordem de omissão
+    phase     = raw|pv|pvlock|pghi
+    fft       = 256..8192         overlap = 2|4|8
+    precision = double|float      backend = auto|fftw|fftw-threads|radix|dft
+    pair-stereo = 0|1             split-band = 0|1
+    limiter   = 0..8 (drive)      dc-block = 0..200 Hz      0 = desligado
+    mask.band   = loHz hiHz       bins fora da banda ficam sem efeito
+    mask.weight = Hz w Hz w ...   peso por frequência, linear entre pontos
+    A máscara é igual em todas as colunas (sem evolução no tempo). Os canais
+    pares usam os parâmetros de L e os ímpares os de R.
+
+ Trabalho
+    - Um grupo por canal (ou por par de canais com pair-stereo), cada um com
+      o seu SpectroEngine e o canal no lado c&1: a saída é a de um motor
+      estéreo com esses canais em L/R (o desfasamento dos hops só depende do
+      lado). Entrada ×VOLTS, saída ÷VOLTS; latência compensada (as primeiras
+      latency() amostras são descartadas e o fim é completado com zeros).
+    - Cada grupo processa blocos de 'chunk' amostras por ordem; cada bloco é
+      uma tarefa, e a seguinte (continuação) vai para a deque do thread que
+      a criou (LIFO, cache quente) de onde os outros a podem roubar (FIFO).
+    - Por ficheiro há 'window' blocos em voo: um grupo que chegue ao bloco
+      written + window estaciona e é reagendado quando o escritor avança. O
+      último grupo a acabar um bloco grava‑o (e os seguintes já completos),
+      por ordem, e devolve ao SO as páginas da entrada já lidas.
+    - Memória por ficheiro: window × chunk × canais amostras de saída mais
+      os motores. Os ficheiros abrem‑se quando um thread fica sem tarefas
+      (no máximo 2 por thread ao mesmo tempo).
+ */
+struct BatchPreset {
+    SpectroParams params;
+    StftConfig stft;                // sampleRate vem de cada ficheiro
+    float maskLoHz = 0.f, maskHiHz = 0.f;                   // hi ≤ lo: todo o espectro
+    std::vector<std::pair<float, float>> maskWeight;        // (Hz, peso), Hz crescente; vazio = 1
+
+    bool load(const std::string& path, std::string* err = nullptr) {
+        FILE* f = std::fopen(path.c_str(), "r");
+        if (!f) { if (err) *err = "cannot open preset"; return false; }
+        char line[1024];
+        int n = 0;
+        bool ok = true;
+        while (ok && std::fgets(line, sizeof(line), f)) {
+            ++n;
+            std::string s = line;
+            s = s.substr(0, s.find('#'));
+            const size_t eq = s.find('=');
+            if (trim(s).empty()) continue;
+            std::string e;
+            ok = eq != std::string::npos ? set(trim(s.substr(0, eq)), trim(s.substr(eq + 1)), &e)
+                                         : (e = "expected key = value", false);
+            if (!ok && err) *err = "line " + std::to_string(n) + ": " + e;
+        }
+        std::fclose(f);
+        return ok;
+    }
+
+    // Uma chave do preset (ver acima); false e 'err' se desconhecida ou inválida.
+    bool set(const std::string& key, const std::string& value, std::string* err = nullptr) {
+        auto fail = [&](const char* msg) { if (err) *err = key + ": " + msg; return false; };
+        std::vector<float> v;
+        const bool numeric = numbers(value, v);
+
+        static const char* const fx[] = { "blur", "sharpen", "edge", "emboss", "mirror", "gate", "stretch" };
+        for (int i = 0; i < 7; ++i) {
+            const std::string name = fx[i];
+            const int side = key == name ? -1 : key == name + ".L" ? 0 : key == name + ".R" ? 1 : -2;
+            if (side == -2) continue;
+            if (!numeric || v.size() != 1 || v[0] < 0.f || v[0] > 1.f) return fail("expected a value in 0..1");
+            for (int g = 0; g < 2; ++g)
+                if (side < 0 || side == g) amount(params.ch[g], i) = v[0];
+            return true;
+        }
+        if (key == "order" || key == "order.L" || key == "order.R") {
+            FXOrder order;
+            if (!parseOrder(value, order)) return fail("expected effect names (blur sharpen edge emboss gate mirror stretch)");
+            for (int g = 0; g < 2; ++g)
+                if (key == "order" || key.back() == "LR"[g]) params.ch[g].order = order;
+            return true;
+        }
+        if (key == "phase") {
+            static const char* const modes[] = { "raw", "pv", "pvlock", "pghi" };
+            for (int m = 0; m < 4; ++m)
+                if (value == modes[m]) { params.phaseMode = (PhaseEngine::Mode)m; return true; }
+            return fail("expected raw|pv|pvlock|pghi");
+        }
+        if (key == "precision") {
+            if (value == "double") stft.precision = StftPrecision::DOUBLE;
+            else if (value == "float") stft.precision = StftPrecision::FLOAT;
+            else return fail("expected double|float");
+            return true;
+        }
+        if (key == "backend") {
+            static const char* const kinds[] = { "auto", "fftw", "fftw-threads", "radix", "dft" };  // = FFTBackend::Kind
+            for (int b = 0; b < 5; ++b)
+                if (value == kinds[b]) { stft.backend = (FFTBackend::Kind)b; return true; }
+            return fail("expected auto|fftw|fftw-threads|radix|dft");
+        }
+        if (!numeric || v.empty()) return fail("expected a number");
+        if (key == "fft") {
+            const int n = (int)v[0];
+            if (v.size() != 1 || n < 256 || n > 8192 || (n & (n - 1))) return fail("expected a power of 2 in 256..8192");
+            stft.fftSize = n;
+        } else if (key == "overlap") {
+            const int o = (int)v[0];
+            if (v.size() != 1 || (o != 2 && o != 4 && o != 8)) return fail("expected 2, 4 or 8");
+            stft.overlap = o;
+        } else if (key == "limiter") {
+            if (v.size() != 1 || v[0] < 0.f || v[0] > 8.f) return fail("expected a drive in 0..8");
+            params.limiterDrive = v[0];
+        } else if (key == "dc-block") {
+            if (v.size() != 1 || v[0] < 0.f || v[0] > 200.f) return fail("expected a cutoff in 0..200 Hz");
+            params.dcBlockHz = v[0];
+        } else if (key == "pair-stereo" || key == "split-band") {
+            if (v.size() != 1) return fail("expected 0 or 1");
+            (key == "pair-stereo" ? stft.pairStereo : stft.splitBand) = v[0] != 0.f;
+        } else if (key == "mask.band") {
+            if (v.size() != 2 || v[0] < 0.f || v[1] <= v[0]) return fail("expected loHz hiHz");
+            maskLoHz = v[0];
+            maskHiHz = v[1];
+        } else if (key == "mask.weight") {
+            if (v.size() % 2) return fail("expected Hz weight pairs");
+            maskWeight.clear();
+            for (size_t i = 0; i < v.size(); i += 2) {
+                if (i && v[i] <= v[i - 2]) return fail("frequencies must increase");
+                maskWeight.emplace_back(v[i], std::clamp(v[i + 1], 0.f, 1.f));
+            }
+        } else {
+            return fail("unknown key");
+        }
+        return true;
+    }
+
+    bool hasMask() const { return maskHiHz > maskLoHz || !maskWeight.empty(); }
+
+    /*
+    Publica a máscara do preset no motor (fora do processamento): todas as
+    colunas com o perfil em Hz do N efetivo e os limites da banda.
+    */
+    void applyMask(SpectroEngine& e, float sampleRate) const {
+        if (!hasMask()) return;
+        Mask2D& m = e.mask();
+        const double hzPerBin = sampleRate / e.fftSize();
+        float* col = m.edit().weights;
+        for (int k = 0; k < m.K; ++k) col[k] = weightAt((float)(k * hzPerBin));
+        for (int h = 1; h < m.HIST; ++h) std::copy_n(col, m.K, m.edit().column(h, m.stride));
+        if (maskHiHz > maskLoHz) m.setBounds((int)std::ceil(maskLoHz / hzPerBin), (int)std::floor(maskHiHz / hzPerBin));
+        else m.publish();
+        m.acquire();                // o 1º hop (de qualquer lado) já a vê
+    }
+
+private:
+    static std::string trim(const std::string& s) {
+        const size_t a = s.find_first_not_of(" \t\r\n"), b = s.find_last_not_of(" \t\r\n");
+        return a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+    }
+
+    // Lista de números separados por espaços/vírgulas; false se houver outra coisa
+    static bool numbers(const std::string& s, std::vector<float>& out) {
+        const char* p = s.c_str();
+        while (*p) {
+            while (*p == ' ' || *p == '\t' || *p == ',') ++p;
+            if (!*p) break;
+            char* end = nullptr;
+            const float x = std::strtof(p, &end);
+            if (end == p) return false;
+            out.push_back(x);
+            p = end;
+        }
+        return true;
+    }
+
+    // Nomes separados por espaços/vírgulas/'>' (sem repetir); os restantes pela ordem de omissão
+    static bool parseOrder(const std::string& s, FXOrder& out) {
+        unsigned used = 0;
+        size_t n = 0;
+        for (size_t i = 0; i < s.size(); ) {
+            const size_t j = s.find_first_of(" \t,>", i);
+            const std::string word = s.substr(i, j == std::string::npos ? std::string::npos : j - i);
+            i = j == std::string::npos ? s.size() : j + 1;
+            if (word.empty()) continue;
+            int e = 0;
+            while (e < (int)Effect::NUM_EFFECTS && !sameName(word, SpectralFX::name((Effect)e))) ++e;
+            if (e == (int)Effect::NUM_EFFECTS || (used & (1u << e))) return false;
+            used |= 1u << e;
+            out[n++] = (Effect)e;
+        }
+        if (n == 0) return false;
+        for (Effect e : DEFAULT_FX_ORDER)
+            if (!(used & (1u << (int)e))) out[n++] = e;
+        return true;
+    }
+
+    static bool sameName(const std::string& a, const char* b) {
+        if (a.size() != std::strlen(b)) return false;
+        for (size_t i = 0; i < a.size(); ++i)
+            if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i])) return false;
+        return true;
+    }
+
+    static float& amount(FXParams& c, int i) {
+        float* const fields[] = { &c.blur, &c.sharpen, &c.edge, &c.emboss, &c.mirror, &c.gate, &c.stretch };
+        return *fields[i];
+    }
+
+    float weightAt(float hz) const {
+        if (maskWeight.empty()) return 1.f;
+        if (hz <= maskWeight.front().first) return maskWeight.front().second;
+        if (hz >= maskWeight.back().first) return maskWeight.back().second;
+        size_t i = 1;
+        while (maskWeight[i].first < hz) ++i;
+        const auto& a = maskWeight[i - 1];
+        const auto& b = maskWeight[i];
+        return a.second + (b.second - a.second) * (hz - a.first) / (b.first - a.first);
+    }
+};
+
+class BatchRenderer {
+public:
+    static constexpr float VOLTS = 5.f;     // WAV ±1 <-> ±5 V (amplitude nominal do Rack)
+
+    struct Options {
+        BatchPreset preset;
+        int threads = 0;            // 0 = hardware_concurrency
+        int chunk = 1 << 16;        // amostras por bloco (tarefa)
+        int window = 4;             // blocos em voo por ficheiro
+    };
+
+    struct FileResult {
+        std::string input, output, error;   // error vazio = ok
+        size_t frames = 0;
+        int channels = 0, sampleRate = 0;
+    };
+
+    explicit BatchRenderer(const Options& o) : opt(o) {
+        opt.chunk = std::max(opt.chunk, 64);
+        opt.window = std::max(opt.window, 1);
+        if (opt.threads <= 0) opt.threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Chamado (de um thread do pool) quando um ficheiro acaba, com ou sem erro.
+    std::function<void(const FileResult&)> onFile;
+
+    // Processa inputs[i] -> outputs[i]; devolve os resultados pela mesma ordem.
+    std::vector<FileResult> run(const std::vector<std::string>& inputs, const std::vector<std::string>& outputs) {
+        const size_t n = inputs.size();
+        results.assign(n, FileResult {});
+        for (size_t i = 0; i < n; ++i) { results[i].input = inputs[i]; results[i].output = outputs[i]; }
+        files.clear();
+        files.resize(n);
+        queues.reset(new Queue[opt.threads]);
+        nextFile.store(0);
+        openFiles.store(0);
+        filesDone.store(0);
+
+        std::vector<std::thread> pool;
+        for (int w = 1; w < opt.threads; ++w) pool.emplace_back([this, w] { worker(w); });
+        worker(0);
+        for (auto& t : pool) t.join();
+        files.clear();
+        return results;
+    }
+
+private:
+    struct Group {
+        std::unique_ptr<SpectroEngine> engine;
+        int first = 0, width = 1;           // canais [first, first + width)
+        size_t next = 0;                    // próximo bloco
+        std::atomic<bool> parked { false };
+        std::vector<float> x[2], y[2];      // por lado [chunk]
+    };
+
+    struct File {
+        size_t index = 0;
+        WavReader in;
+        WavWriter out;
+        int channels = 0;
+        std::atomic<int> latency { 0 };                 // do 1º motor criado (igual em todos)
+        size_t frames = 0, chunks = 0;
+        StftConfig stft;
+        std::unique_ptr<Group[]> groups;
+        int numGroups = 0;
+        std::vector<float> slots;                       // [window][chunk][channels]
+        std::unique_ptr<std::atomic<int>[]> pending;    // [window] grupos por acabar o bloco do slot
+        std::vector<char> complete;                     // [window] bloco pronto a gravar (sob 'flushing')
+        std::atomic<size_t> written { 0 };              // blocos já gravados
+        std::mutex flushing;
+    };
+
+    struct Task { File* file; int group; };
+    struct Queue {
+        std::mutex m;
+        std::deque<Task> q;
+    };
+
+    // ---- Pool -------------------------------------------------------------
+
+    void push(int w, Task t) {
+        std::lock_guard<std::mutex> lock(queues[w].m);
+        queues[w].q.push_back(t);
+    }
+
+    bool pop(int w, Task& t) {
+        std::lock_guard<std::mutex> lock(queues[w].m);
+        if (queues[w].q.empty()) return false;
+        t = queues[w].q.back();
+        queues[w].q.pop_back();
+        return true;
+    }
+
+    bool steal(int w, Task& t) {
+        for (int i = 1; i < opt.threads; ++i) {
+            Queue& v = queues[(w + i) % opt.threads];
+            std::lock_guard<std::mutex> lock(v.m);
+            if (v.q.empty()) continue;
+            t = v.q.front();
+            v.q.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void worker(int w) {
+        const size_t n = files.size();
+        int idle = 0;
+        while (filesDone.load(std::memory_order_acquire) < n) {
+            Task t;
+            if (pop(w, t) || steal(w, t)) { runChunk(w, *t.file, t.group); idle = 0; continue; }
+            if (openNext(w)) { idle = 0; continue; }
+            if (++idle < 64) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    // Abre o próximo ficheiro e põe as tarefas dos seus grupos na deque de w
+    bool openNext(int w) {
+        if (openFiles.fetch_add(1) >= 2 * opt.threads) { openFiles.fetch_sub(1); return false; }
+        const size_t i = nextFile.fetch_add(1);
+        if (i >= files.size()) { openFiles.fetch_sub(1); return false; }
+
+        files[i] = std::make_unique<File>();
+        File& f = *files[i];
+        FileResult& r = results[i];
+        f.index = i;
+        std::string err;
+        if (!f.in.open(r.input, &err)) { finish(f, err); return true; }
+        r.channels = f.channels = f.in.channels;
+        r.sampleRate = f.in.sampleRate;
+        r.frames = f.frames = f.in.frames();
+        if (!f.out.open(r.output, f.in.sampleRate, f.channels)) { finish(f, "cannot create output"); return true; }
+
+        f.stft = opt.preset.stft;
+        f.stft.sampleRate = (float)f.in.sampleRate;
+        const int width = f.stft.pairStereo ? 2 : 1;
+        f.numGroups = (f.channels + width - 1) / width;
+        f.groups.reset(new Group[f.numGroups]);
+        for (int g = 0; g < f.numGroups; ++g) {
+            f.groups[g].first = g * width;
+            f.groups[g].width = std::min(width, f.channels - g * width);
+        }
+        f.chunks = (f.frames + opt.chunk - 1) / opt.chunk;
+        f.slots.assign((size_t)opt.window * opt.chunk * f.channels, 0.f);
+        f.pending.reset(new std::atomic<int>[opt.window]);
+        for (int s = 0; s < opt.window; ++s) f.pending[s].store(f.numGroups);
+        f.complete.assign(opt.window, 0);
+        if (f.chunks == 0) { finish(f, ""); return true; }
+        for (int g = f.numGroups - 1; g >= 0; --g) push(w, Task { &f, g });
+        return true;
+    }
+
+    // ---- Render -------------------------------------------------------------
+
+    // n amostras de entrada a partir de t0 pelo motor do grupo; saída (÷VOLTS) em dst [n][channels] se não nula
+    void feed(File& f, Group& gr, size_t t0, int n, float* dst) {
+        for (int s = 0; s < gr.width; ++s) {
+            float* x = gr.x[(gr.first + s) & 1].data();
+            f.in.read(t0, n, gr.first + s, x);
+            for (int i = 0; i < n; ++i) x[i] *= VOLTS;
+        }
+        gr.engine->process(gr.x[0].data(), gr.x[1].data(), gr.y[0].data(), gr.y[1].data(), n);
+        if (!dst) return;
+        for (int s = 0; s < gr.width; ++s) {
+            const float* y = gr.y[(gr.first + s) & 1].data();
+            for (int i = 0; i < n; ++i) dst[(size_t)i * f.channels + gr.first + s] = y[i] / VOLTS;
+        }
+    }
+
+    void runChunk(int w, File& f, int g) {
+        Group& gr = f.groups[g];
+        const size_t k = gr.next;
+        const size_t W = (size_t)opt.window;
+        if (k >= f.written.load() + W) {
+            // Estaciona; se o escritor avançou entretanto, quem limpar o flag continua
+            gr.parked.store(true);
+            if (k >= f.written.load() + W || !gr.parked.exchange(false)) return;
+        }
+
+        const int B = opt.chunk;
+        if (!gr.engine) {
+            gr.engine = std::make_unique<SpectroEngine>(f.stft);
+            gr.engine->setParams(opt.preset.params);
+            opt.preset.applyMask(*gr.engine, f.stft.sampleRate);
+            for (auto& b : gr.x) b.assign(B, 0.f);
+            for (auto& b : gr.y) b.assign(B, 0.f);
+            const int L = gr.engine->latency();
+            f.latency.store(L);
+            for (int left = L; left > 0; left -= B)     // compensação da latência
+                feed(f, gr, (size_t)(L - left), std::min(left, B), nullptr);
+        }
+        const size_t o0 = k * B;
+        const int n = (int)std::min<size_t>(B, f.frames - o0);
+        feed(f, gr, o0 + f.latency.load(), n, &f.slots[(k % W) * B * f.channels]);
+        gr.next = k + 1;
+
+        // Daqui em diante o grupo não toca no motor (o ficheiro pode acabar já)
+        const bool more = k + 1 < f.chunks;
+        if (f.pending[k % W].fetch_sub(1) == 1) flush(w, f, k);
+        if (more) push(w, Task { &f, g });
+    }
+
+    // Bloco k completo: grava‑o com os seguintes já completos, por ordem
+    void flush(int w, File& f, size_t k) {
+        std::lock_guard<std::mutex> lock(f.flushing);
+        const size_t W = (size_t)opt.window, B = (size_t)opt.chunk;
+        f.complete[k % W] = 1;
+        size_t done = f.written.load();
+        while (done < f.chunks && f.complete[done % W]) {
+            const size_t s = done % W;
+            f.out.write(&f.slots[s * B * f.channels], std::min(B, f.frames - done * B) * f.channels);
+            f.complete[s] = 0;
+            f.pending[s].store(f.numGroups);
+            f.written.store(++done);
+            f.in.release(done * B + f.latency.load());
+        }
+        if (done == f.chunks) { finish(f, ""); return; }
+        for (int g = 0; g < f.numGroups; ++g)
+            if (f.groups[g].parked.load() && f.groups[g].parked.exchange(false)) push(w, Task { &f, g });
+    }
+
+    // Fecha o ficheiro (com erro se 'err' não vazio) e liberta motores e blocos
+    void finish(File& f, const std::string& err) {
+        FileResult& r = results[f.index];
+        r.error = err;
+        if (!f.out.close() && r.error.empty()) r.error = "write failed";
+        f.in.close();
+        for (int g = 0; g < f.numGroups; ++g) f.groups[g].engine.reset();
+        std::vector<float>().swap(f.slots);
+        if (onFile) onFile(r);
+        openFiles.fetch_sub(1);
+        filesDone.fetch_add(1, std::memory_order_release);
+    }
+
+    Options opt;
+    std::vector<FileResult> results;
+    std::vector<std::unique_ptr<File>> files;       // [inputs] (criado por quem o abre)
+    std::unique_ptr<Queue[]> queues;                // deque de tarefas de cada thread
+    std::atomic<size_t> nextFile { 0 };
+    std::atomic<int> openFiles { 0 };
+    std::atomic<size_t> filesDone { 0 };
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include "SpectralFX.hpp"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+/*
+ ReferenceFX
+
+ Réplica direta (não otimizada) do caminho OpenCV original de efeitos, para
+ validar a cadeia SpectralFX. Cada efeito trabalha sobre uma cópia completa
+ ("before") e mistura por bin com o peso da máscara (no original, 1 dentro
+ da banda e 0 fora), tal como o código com cv::Mat 1×K:
+
+    GaussianBlur(σ = 12·amt)  : kernel getGaussianKernel completo, REFLECT_101
+    filter2D (sharpen/emboss) : kernels 3×3 colapsados numa linha (1 só linha)
+    Sobel(1,1,3)              : identicamente 0 numa imagem 1×K
+    resize(INTER_LINEAR) ×2   : K -> round(K·f) -> K
+
+ Só usada pelas ferramentas (spectrofx-bench --verify-fx).
+ */
+namespace ReferenceFX {
+
+inline int reflect101(int i, int n) {
+    while (i < 0 || i >= n) {
+        if (i < 0)  i = -i;
+        if (i >= n) i = 2 * (n - 1) - i;
+    }
+    return i;
+}
+
+// Correlação 1D com kernel centrado e borda REFLECT_101.
+inline std::vector<float> correlate(const std::vector<float>& x, const std::vector<double>& kern) {
+    const int n = (int)x.size(), r = (int)kern.size() / 2;
+    std::vector<float> y(n);
+    for (int k = 0; k < n; ++k) {
+        double acc = 0.0;
+        for (int j = 0; j < (int)kern.size(); ++j) acc += kern[j] * x[reflect101(k + j - r, n)];
+        y[k] = (float)acc;
+    }
+    return y;
+}
+
+inline std::vector<float> resizeLinear(const std::vector<float>& src, int dstN, double scale) {
+    const int srcN = (int)src.size();
+    std::vector<float> dst(dstN);
+    for (int dx = 0; dx < dstN; ++dx) {
+        float fx = (float)((dx + 0.5) * scale - 0.5);
+        int sx = (int)std::floor(fx);
+        fx -= (float)sx;
+        if (sx < 0)         { sx = 0; fx = 0.f; }
+        if (sx >= srcN - 1) { sx = srcN - 1; fx = 0.f; }
+        dst[dx] = src[sx] * (1.f - fx) + (fx > 0.f ? src[sx + 1] * fx : 0.f);
+    }
+    return dst;
+}
+
+// Cadeia completa (mesma ordem e misturas do processChannel() original), com pesos w[K].
+inline std::vector<float> process(std::vector<float> mag, const FXParams& p, const std::vector<float>& weight) {
+    const int K = (int)mag.size();
+    auto inBand = [&](int k) { return weight[k]; };
+    auto blend = [&](const std::vector<float>& a, const std::vector<float>& b) {
+        for (int k = 0; k < K; ++k) { float w = inBand(k); mag[k] = a[k] * (1.f - w) + b[k] * w; }
+    };
+
+    if (p.blur > 0.f) {
+        double sigma = p.blur * 12.0;
+        int ksize = (int)std::lrint(sigma * 8.0 + 1.0) | 1;
+        std::vector<double> g(ksize);
+        double sum = 0.0;
+        for (int i = 0; i < ksize; ++i) { double t = i - (ksize - 1) * 0.5; g[i] = std::exp(-0.5 / (sigma * sigma) * t * t); sum += g[i]; }
+        for (double& v : g) v /= sum;
+        std::vector<float> before = mag;
+        blend(before, correlate(before, g));
+    }
+    if (p.sharpen > 0.f) {
+        std::vector<float> before = mag;
+        blend(before, correlate(before, { -p.sharpen, 1.0 + 2.0 * p.sharpen, -p.sharpen }));
+    }
+    if (p.edge > 0.f) {
+        std::vector<float> before = mag, b(K);
+        for (int k = 0; k < K; ++k) b[k] = (1.f - p.edge) * before[k] + p.edge * 0.f;   // Sobel(1,1) = 0
+        blend(before, b);
+    }
+    if (p.emboss > 0.f) {
+        std::vector<float> before = mag, e = correlate(before, { -3.0, 1.0, 3.0 }), b(K);
+        for (int k = 0; k < K; ++k) b[k] = (1.f - p.emboss) * before[k] + p.emboss * e[k];
+        blend(before, b);
+    }
+    if (p.gate > 0.f) {
+        float th = p.gate * *std::max_element(mag.begin(), mag.end());
+        for (int k = 0; k < K; ++k)
+            if (mag[k] < th) mag[k] *= (1.f - p.gate * inBand(k));
+    }
+    if (p.mirror > 0.f) {
+        std::vector<float> before = mag, m = mag, b(K);
+        for (int i = 0; i < K / 2; ++i) std::swap(m[i], m[K - 1 - i]);
+        for (int k = 0; k < K; ++k) b[k] = (1.f - p.mirror) * before[k] + p.mirror * m[k];
+        blend(before, b);
+    }
+    if (std::abs(p.stretch - 0.5f) > 1e-3f) {
+        std::vector<float> before = mag;
+        double f = (double)(0.5f + p.stretch);     // o original usava float
+        int W = (int)std::lrint(K * f);
+        if (W != K) {
+            std::vector<float> s = resizeLinear(before, W, 1.0 / f);
+            blend(before, resizeLinear(s, K, 1.0 / ((double)K / W)));
+        }
+    }
+    for (float& v : mag) v = std::max(v, 0.f) + 1e-6f;
+    return mag;
+}
+
+// Banda [lo, hi] (máscara binária do original).
+inline std::vector<float> bandWeights(int K, int lo, int hi) {
+    std::vector<float> w(K);
+    for (int k = 0; k < K; ++k) w[k] = (k >= lo && k <= hi) ? 1.f : 0.f;
+    return w;
+}
+
+} // namespace ReferenceFX
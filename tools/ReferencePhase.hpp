@@ -0,0 +1,96 @@
+#pragma once
+#include "PhaseEngine.hpp"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+/*
+ ReferencePhase
+
+ Réplica do PhaseEngine anterior à versão por tabelas, para comparar saída e
+ custo (spectrofx-bench --verify-phase): avanço esperado 2π·k·H/N calculado
+ por bin em cada frame, princarg com fmod e "locking" que integra, bin a bin
+ a partir do vizinho da esquerda, a diferença principal das fases PV. Este
+ último não prende nada: por indução φ_lock[k] ≡ φ_PV[k] (mod 2π), ou seja,
+ PV_LOCK dava o mesmo que PV.
+
+ Layout [K][C] como no PhaseEngine. Só usada pelas ferramentas.
+ */
+struct ReferencePhase {
+    using Mode = PhaseEngine::Mode;
+
+    void setup(int channels, int bins, int hop) {
+        C = channels; K = bins; H = hop;
+        prevA.assign((size_t)K * C, 0.f);
+        prevS.assign((size_t)K * C, 0.f);
+        phaseOut.assign((size_t)K * C, 0.f);
+        phaseBase.assign((size_t)K * C, 0.f);
+        thresh.assign(C, 0.f);
+    }
+
+    void processFrame(Mode mode, const float* magProc, const float* phaseIn, float* outRe, float* outIm) {
+        const int KC = K * C;
+        if (mode == Mode::RAW) {
+            SpectralMath::polarToCart(magProc, phaseIn, outRe, outIm, KC);
+            std::copy(phaseIn, phaseIn + KC, prevA.begin());
+            std::copy(phaseIn, phaseIn + KC, prevS.begin());
+            return;
+        }
+
+        float* phi = (mode == Mode::PV) ? phaseOut.data() : phaseBase.data();
+        for (int k = 0; k < K; ++k) {
+            const float dphi_exp = 2.f * (float)M_PI * k * (float)H / (float)(2*(K-1));
+            const int row = k * C;
+            for (int c = 0; c < C; ++c) {
+                float phi_a = phaseIn[row + c];
+                float dphi  = princarg((phi_a - prevA[row + c]) - dphi_exp);
+                float omega = (dphi_exp + dphi) / (float)H;
+                float phi_s = wrap(prevS[row + c] + omega * (float)H);
+                prevA[row + c] = phi_a;
+                prevS[row + c] = phi_s;
+                phi[row + c] = phi_s;
+            }
+        }
+        if (mode == Mode::PV) {
+            SpectralMath::polarToCart(magProc, phaseOut.data(), outRe, outIm, KC);
+            return;
+        }
+
+        const float* phi_s = phaseBase.data();
+        float* phi_lock    = phaseOut.data();
+        std::fill(thresh.begin(), thresh.end(), 0.f);
+        for (int k = 0; k < K; ++k)
+            for (int c = 0; c < C; ++c) thresh[c] = std::max(thresh[c], magProc[k * C + c]);
+        for (int c = 0; c < C; ++c) thresh[c] *= 0.001f;
+
+        std::copy_n(phi_s, C, phi_lock);
+        for (int k = 1; k < K; ++k) {
+            const int row = k * C;
+            const bool interior = (k < K - 1);
+            for (int c = 0; c < C; ++c) {
+                const float m = magProc[row + c];
+                const bool isPeak = interior && m > thresh[c] &&
+                                    m >  magProc[row - C + c] &&
+                                    m >= magProc[row + C + c];
+                phi_lock[row + c] = isPeak
+                    ? phi_s[row + c]
+                    : phi_lock[row - C + c] + princarg(phi_s[row + c] - phi_s[row - C + c]);
+            }
+        }
+        SpectralMath::polarToCart(magProc, phi_lock, outRe, outIm, KC);
+    }
+
+private:
+    int C = 1, K = 0, H = 0;
+    std::vector<float> prevA, prevS, phaseOut, phaseBase, thresh;
+
+    static float wrap(float x) {
+        const float twoPi = 2.f * (float)M_PI;
+        return x - twoPi * std::nearbyint(x * (1.f / twoPi));
+    }
+    static float princarg(float x) {
+        x = std::fmod(x + (float)M_PI, 2.f * (float)M_PI);
+        if (x < 0.f) x += 2.f * (float)M_PI;
+        return x - (float)M_PI;
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/*
+ WavFile
+
+ Leitura/escrita mínima de ficheiros WAV (RIFF) para as ferramentas headless.
+
+ Leitura : PCM inteiro 16/24/32 bits e IEEE float 32 bits, 1..N canais.
+ Escrita : IEEE float 32 bits, intercalado.
+
+ As amostras ficam em 'data' intercalado [frame * channels + ch], em [-1..1].
+ */
+struct WavFile {
+    int sampleRate = 48000;
+    int channels   = 2;
+    std::vector<float> data;    // intercalado
+
+    size_t frames() const { return channels > 0 ? data.size() / (size_t)channels : 0; }
+
+    // Lê um WAV; devolve false (e 'err') em caso de formato não suportado.
+    bool load(const std::string& path, std::string* err = nullptr) {
+        auto fail = [&](const char* msg) { if (err) *err = msg; return false; };
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) return fail("cannot open file");
+
+        char riff[12];
+        if (std::fread(riff, 1, 12, f) != 12 || std::memcmp(riff, "RIFF", 4) || std::memcmp(riff + 8, "WAVE", 4)) {
+            std::fclose(f);
+            return fail("not a RIFF/WAVE file");
+        }
+
+        int format = 0, bits = 0;
+        bool haveFmt = false;
+        char id[4]; uint32_t size = 0;
+        while (std::fread(id, 1, 4, f) == 4 && std::fread(&size, 4, 1, f) == 1) {
+            if (!std::memcmp(id, "fmt ", 4)) {
+                uint8_t fmt[40] = {0};
+                size_t n = std::min<size_t>(size, sizeof(fmt));
+                if (std::fread(fmt, 1, n, f) != n) break;
+                if (size > n) std::fseek(f, (long)(size - n), SEEK_CUR);
+                format     = fmt[0] | (fmt[1] << 8);
+                channels   = fmt[2] | (fmt[3] << 8);
+                sampleRate = (int)(fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | ((uint32_t)fmt[7] << 24));
+                bits       = fmt[14] | (fmt[15] << 8);
+                if (format == 0xFFFE && size >= 26) format = fmt[24] | (fmt[25] << 8);  // WAVE_FORMAT_EXTENSIBLE
+                haveFmt = true;
+            }
+            else if (!std::memcmp(id, "data", 4)) {
+                if (!haveFmt || channels <= 0) { std::fclose(f); return fail("missing fmt chunk"); }
+                if (!((format == 1 && (bits == 16 || bits == 24 || bits == 32)) || (format == 3 && bits == 32))) {
+                    std::fclose(f);
+                    return fail("unsupported sample format (PCM 16/24/32 or float32)");
+                }
+                std::vector<uint8_t> raw(size);
+                size_t got = std::fread(raw.data(), 1, size, f);
+                std::fclose(f);
+                decode(raw.data(), got, format, bits);
+                return true;
+            }
+            else {
+                std::fseek(f, (long)(size + (size & 1)), SEEK_CUR);  // chunks alinhados a 2 bytes
+            }
+        }
+        std::fclose(f);
+        return fail("missing data chunk");
+    }
+
+    // Grava em IEEE float 32 bits.
+    bool save(const std::string& path) const {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return false;
+        const uint32_t dataBytes = (uint32_t)(data.size() * sizeof(float));
+        const uint16_t fmtTag = 3, ch = (uint16_t)channels, bits = 32, align = (uint16_t)(channels * 4);
+        const uint32_t sr = (uint32_t)sampleRate, byteRate = sr * align, fmtSize = 16, riffSize = 36 + dataBytes;
+        std::fwrite("RIFF", 1, 4, f); std::fwrite(&riffSize, 4, 1, f); std::fwrite("WAVE", 1, 4, f);
+        std::fwrite("fmt ", 1, 4, f); std::fwrite(&fmtSize, 4, 1, f);
+        std::fwrite(&fmtTag, 2, 1, f); std::fwrite(&ch, 2, 1, f); std::fwrite(&sr, 4, 1, f);
+        std::fwrite(&byteRate, 4, 1, f); std::fwrite(&align, 2, 1, f); std::fwrite(&bits, 2, 1, f);
+        std::fwrite("data", 1, 4, f); std::fwrite(&dataBytes, 4, 1, f);
+        std::fwrite(data.data(), sizeof(float), data.size(), f);
+        return std::fclose(f) == 0;
+    }
+
+    // 1 amostra PCM 16/24/32 ou float32 (format 1/3) em [-1..1] (também usado por WavReader)
+    static inline float decodeSample(const uint8_t* p, int format, int bits) {
+        if (format == 3) {
+            float v; std::memcpy(&v, p, 4); return v;
+        } else if (bits == 16) {
+            return (float)(int16_t)(p[0] | (p[1] << 8)) / 32768.f;
+        } else if (bits == 24) {
+            int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+            return (float)v / 8388608.f;
+        } else {
+            int32_t v; std::memcpy(&v, p, 4); return (float)((double)v / 2147483648.0);
+        }
+    }
+
+private:
+    void decode(const uint8_t* p, size_t bytes, int format, int bits) {
+        const size_t bps = (size_t)bits / 8;
+        const size_t n = bytes / bps;
+        data.resize(n - n % (size_t)channels);
+        for (size_t i = 0; i < data.size(); ++i, p += bps)
+            data[i] = decodeSample(p, format, bits);
+    }
+};
@@ -0,0 +1,236 @@
+#pragma once
+#include "WavFile.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ WavReader / WavWriter
+
+ E/S de WAV em streaming para ficheiros maiores do que a memória
+ (spectrofx-render). Mesmos formatos que WavFile, mais RF64 (> 4 GiB).
+
+ WavReader : o ficheiro é mapeado em memória (mmap / CreateFileMapping) e
+             as amostras são descodificadas a pedido (read()), canal a
+             canal; release() devolve ao SO as páginas já consumidas.
+ WavWriter : IEEE float 32 bits intercalado, escrito por blocos num FILE com
+             buffer próprio. O cabeçalho reserva um chunk JUNK do tamanho de
+             um ds64; close() acerta os tamanhos e, se os dados passarem de
+             4 GiB, converte o ficheiro em RF64.
+ */
+class WavReader {
+public:
+    int sampleRate = 0;
+    int channels = 0;
+
+    WavReader() = default;
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+    ~WavReader() { close(); }
+
+    bool open(const std::string& path, std::string* err = nullptr) {
+        auto fail = [&](const char* msg) { if (err) *err = msg; close(); return false; };
+        close();
+        if (!map(path)) return fail("cannot map file");
+        if (size < 12 || (std::memcmp(base, "RIFF", 4) && std::memcmp(base, "RF64", 4)) || std::memcmp(base + 8, "WAVE", 4))
+            return fail("not a RIFF/WAVE file");
+
+        uint64_t dataSize64 = 0;
+        bool haveFmt = false;
+        for (size_t pos = 12; pos + 8 <= size; ) {
+            const uint8_t* id = base + pos;
+            const uint64_t chunk = le32(base + pos + 4);
+            const uint8_t* body = base + pos + 8;
+            const size_t avail = size - pos - 8;
+            if (!std::memcmp(id, "ds64", 4) && avail >= 16) {
+                dataSize64 = le64(body + 8);
+            } else if (!std::memcmp(id, "fmt ", 4) && avail >= 16) {
+                format     = body[0] | (body[1] << 8);
+                channels   = body[2] | (body[3] << 8);
+                sampleRate = (int)le32(body + 4);
+                bits       = body[14] | (body[15] << 8);
+                if (format == 0xFFFE && chunk >= 26 && avail >= 26) format = body[24] | (body[25] << 8);
+                haveFmt = true;
+            } else if (!std::memcmp(id, "data", 4)) {
+                if (!haveFmt || channels <= 0) return fail("missing fmt chunk");
+                if (!((format == 1 && (bits == 16 || bits == 24 || bits == 32)) || (format == 3 && bits == 32)))
+                    return fail("unsupported sample format (PCM 16/24/32 or float32)");
+                const uint64_t bytes = chunk == 0xFFFFFFFFu && dataSize64 ? dataSize64 : chunk;
+                samples = base + pos + 8;
+                frameBytes = (size_t)channels * (bits / 8);
+                frameCount = (size_t)std::min<uint64_t>(bytes, avail) / frameBytes;
+                return true;
+            }
+            pos += 8 + chunk + (chunk & 1);                 // chunks alinhados a 2 bytes
+        }
+        return fail("missing data chunk");
+    }
+
+    size_t frames() const { return frameCount; }
+
+    // out[i] = canal 'ch' da amostra frame0 + i, i < n (0 depois do fim)
+    void read(size_t frame0, size_t n, int ch, float* out) const {
+        const size_t bps = (size_t)bits / 8;
+        size_t i = 0;
+        for (; i < n && frame0 + i < frameCount; ++i)
+            out[i] = WavFile::decodeSample(samples + (frame0 + i) * frameBytes + ch * bps, format, bits);
+        std::fill(out + i, out + n, 0.f);
+    }
+
+    // As amostras antes de 'frame' já não vão ser lidas: páginas devolvidas ao SO
+    void release(size_t frame) {
+#ifndef _WIN32
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        const size_t end = (size_t)(samples - base) + std::min(frame, frameCount) * frameBytes;
+        const size_t from = released, to = end / page * page;
+        if (to > from) {
+            madvise(const_cast<uint8_t*>(base) + from, to - from, MADV_DONTNEED);
+            released = to;
+        }
+#else
+        (void)frame;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (base) UnmapViewOfFile(base);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (base) munmap(const_cast<uint8_t*>(base), size);
+#endif
+        base = samples = nullptr;
+        size = frameCount = released = 0;
+    }
+
+private:
+    static uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+    static uint64_t le64(const uint8_t* p) { return le32(p) | ((uint64_t)le32(p + 4) << 32); }
+
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER len;
+        if (!GetFileSizeEx(file, &len) || len.QuadPart == 0) return false;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return false;
+        base = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        size = (size_t)len.QuadPart;
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+        base = (const uint8_t*)p;
+        size = (size_t)st.st_size;
+#endif
+        return base != nullptr;
+    }
+
+    const uint8_t* base = nullptr;          // ficheiro mapeado [size]
+    const uint8_t* samples = nullptr;       // início do chunk data
+    size_t size = 0, frameCount = 0, frameBytes = 0;
+    size_t released = 0;                    // bytes iniciais já devolvidos (release)
+    int format = 0, bits = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+#endif
+};
+
+class WavWriter {
+public:
+    static constexpr size_t BUFFER = 1 << 20;  // bytes do buffer do FILE
+
+    WavWriter() = default;
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+    ~WavWriter() { close(); }
+
+    bool open(const std::string& path, int rate, int ch) {
+        close();
+        f = std::fopen(path.c_str(), "wb");
+        if (!f) return false;
+        buffer.resize(BUFFER);
+        std::setvbuf(f, buffer.data(), _IOFBF, BUFFER);
+        sampleRate = rate;
+        channels = ch;
+        dataBytes = 0;
+        ok = true;
+        writeHeader(false);
+        return ok;
+    }
+
+    // n amostras intercaladas (n múltiplo de channels)
+    void write(const float* interleaved, size_t n) {
+        if (!f) return;
+        ok = ok && std::fwrite(interleaved, sizeof(float), n, f) == n;
+        dataBytes += n * sizeof(float);
+    }
+
+    // Acerta o cabeçalho (RF64 acima de 4 GiB) e fecha. false se alguma escrita falhou.
+    bool close() {
+        if (!f) return ok;
+        if (dataBytes & 1) { std::fputc(0, f); }
+        ok = ok && std::fseek(f, 0, SEEK_SET) == 0;
+        writeHeader(dataBytes + 36 + 36 > 0xFFFFFFFFull);
+        ok = std::fclose(f) == 0 && ok;
+        f = nullptr;
+        return ok;
+    }
+
+private:
+    void put32(uint32_t v) { ok = ok && std::fwrite(&v, 4, 1, f) == 1; }
+    void put64(uint64_t v) { ok = ok && std::fwrite(&v, 8, 1, f) == 1; }
+    void put16(uint16_t v) { ok = ok && std::fwrite(&v, 2, 1, f) == 1; }
+    void tag(const char* id) { ok = ok && std::fwrite(id, 1, 4, f) == 4; }
+
+    // RIFF|RF64, JUNK|ds64 (28 bytes), fmt (float32), data
+    void writeHeader(bool rf64) {
+        const uint64_t riffSize = 4 + (8 + 28) + (8 + 16) + 8 + dataBytes + (dataBytes & 1);
+        tag(rf64 ? "RF64" : "RIFF");
+        put32(rf64 ? 0xFFFFFFFFu : (uint32_t)riffSize);
+        tag("WAVE");
+        tag(rf64 ? "ds64" : "JUNK");
+        put32(28);
+        put64(rf64 ? riffSize : 0);
+        put64(rf64 ? dataBytes : 0);
+        put64(rf64 ? dataBytes / (sizeof(float) * channels) : 0);
+        put32(0);                                   // sem tabela de chunks
+        tag("fmt ");
+        put32(16);
+        put16(3);
+        put16((uint16_t)channels);
+        put32((uint32_t)sampleRate);
+        put32((uint32_t)(sampleRate * channels * 4));
+        put16((uint16_t)(channels * 4));
+        put16(32);
+        tag("data");
+        put32(rf64 ? 0xFFFFFFFFu : (uint32_t)dataBytes);
+    }
+
+    FILE* f = nullptr;
+    std::vector<char> buffer;
+    int sampleRate = 0, channels = 0;
+    uint64_t dataBytes = 0;
+    bool ok = false;
+};
@@ -0,0 +1,2422 @@
+/*
+ spectrofx-bench
+
+ Benchmark headless do SpectroEngine (sem Rack). Processa um WAV ou um sinal
+ sintético através do pipeline completo e reporta, por efeito, modo de fase e
+ agendamento dos hops (immediate/spread):
+
+    - RTF        : tempo de processamento / duração do áudio (menor = melhor)
+    - ns/hop     : custo médio amortizado por hop (cada voz de L e de R conta como um hop)
+    - worst      : pior tempo de uma única amostra (inclui o hop dessa amostra)
+    - p99.9      : percentil 99.9 do tempo por amostra
+    - block      : pior soma de --block amostras consecutivas (prazo de um
+                   bloco de áudio do Rack)
+
+ Com --voices V cada lado recebe V vozes (cabo polifónico): a voz v é o sinal
+ de entrada com ganho (1 − v/32), e o WAV de saída leva apenas a 1ª voz.
+
+ Uso:
+    spectrofx-bench [--wav FILE | --signal noise|sine|sweep|impulse]
+                    [--seconds S] [--rate SR]
+                    [--effect none|blur|sharpen|edge|emboss|mirror|gate|stretch|all]
+                    [--phase raw|pv|pvlock|pghi|all] [--amount A] [--out FILE]
+                    [--schedule immediate|spread|all] [--block B] [--voices V]
+                    [--fft 256..8192] [--overlap 2|4|8] [--wisdom FILE]
+                    [--fft-backend auto|fftw|fftw-threads|radix|dft]
+                    [--precision double|float] [--pair-stereo] [--split-band]
+                    [--limiter DRIVE] [--dc-block HZ]
+    spectrofx-bench --instantiate COUNT [--fft N] [--overlap O] [--wisdom FILE]
+    spectrofx-bench --kernels [--report FILE] [--baseline FILE] [--threshold PCT]
+                    [--overlap O] [--fft-backend B] [--precision P]
+    spectrofx-bench --load M|auto [--threads T] [--scenario static|lfo|random|mask|worst|all]
+                    [--rate SR] [--seconds S] [--block B] [--voices V] [--max-miss PCT]
+                    [--wav FILE | --signal ...] [--schedule immediate|spread] [STFT options]
+    spectrofx-bench --verify-fx
+    spectrofx-bench --verify-chain
+    spectrofx-bench --verify-math
+    spectrofx-bench --verify-fft
+    spectrofx-bench --verify-precision
+    spectrofx-bench --verify-pair
+    spectrofx-bench --verify-colormap
+    spectrofx-bench --verify-stream
+    spectrofx-bench --verify-mask
+    spectrofx-bench --verify-fastpath
+    spectrofx-bench --verify-output
+    spectrofx-bench --verify-split
+    spectrofx-bench --verify-phase
+    spectrofx-bench --verify-pghi
+    spectrofx-bench --verify-stats
+    spectrofx-bench --verify-render
+
+ --instantiate mede o custo de criar COUNT motores seguidos (como ao abrir
+ um patch com COUNT módulos): o 1º obtém os planos do PlanCache, os restantes
+ partilham-nos. Com --wisdom FILE a wisdom é lida/gravada nesse ficheiro
+ (a dos planos float em FILE.float), como na pasta de utilizador do plugin;
+ numa 2ª execução os planos finais (FFTW_PATIENT) vêm logo da wisdom.
+
+ --kernels mede cada estágio do hop em separado (janela, FFT, análise, cada
+ efeito em vários valores, cada modo de fase, IFFT, OLA e saída) para vários
+ N e nº de vozes; com --report grava um TSV e com --baseline compara com um
+ TSV anterior, saindo com código 1 se algum kernel piorar mais de
+ --threshold %. 'make bench-kernels' faz as duas coisas com a base gravada
+ por 'make bench-baseline' (ver a função kernels()).
+
+ --load corre M instâncias (ou procura o máximo sustentável, com auto) em T
+ threads com o prazo de bloco do Rack, por cenário de knobs/CV/máscara e a
+ 48, 96 e 192 kHz (ou só --rate): taxa de falhas, p99 e pior bloco (em
+ prazos) e utilização por thread (ver loadTest()).
+
+ --verify-fx compara a cadeia SpectralFX com a réplica do caminho OpenCV
+ original (tools/ReferenceFX.hpp): erro máximo relativo ao pico do frame e
+ custo/jitter por frame de ambas. Sai com código 1 se a tolerância falhar.
+
+ --verify-chain compara as variantes compiladas da cadeia com ordem
+ configurável (stencils Sharpen/Edge/Emboss fundidos numa passagem,
+ Gate+Mirror) com o caminho genérico de um passe por efeito, em 400 ordens
+ aleatórias com 1 e 4 vozes e com/sem máscara, e mede o custo por frame de
+ várias sequências nos dois caminhos. Sai com código 1 se a diferença passar
+ de 1e−6 do pico ou se alguma das 15 sequências de stencils não for coberta.
+
+ --verify-fft compara cada backend FFT (FFTW, FFTW com 2 threads, radix
+ in‑tree), em double e em float, com a DFT de referência e mostra os tempos
+ do micro‑benchmark que decide o modo AUTO. As colunas "pair" verificam o
+ two‑for‑one (2 sinais reais numa FFT complexa). Sai com código 1 se algum
+ erro exceder 1e−12 (double) ou 1e−5 (float).
+
+ --verify-precision processa o mesmo sinal com o pipeline em double e em
+ float (--precision) para vários efeitos, modos de fase e tamanhos de FFT, e
+ reporta a diferença entre as saídas (RMS relativo e pico, em dB) e o RTF de
+ cada um. Sai com código 1 se a diferença RMS passar de −80 dB.
+
+ --verify-pair compara o estéreo emparelhado (--pair-stereo: L+R numa só FFT
+ complexa) com o caminho por canal, por backend e nº de vozes: diferença
+ entre as saídas de L e de R (dB, relativa ao RMS) e custo por hop de cada
+ um. Sai com código 1 se a diferença passar de −120 dB (double) ou −100 dB
+ (float).
+
+ --verify-colormap compara a coluna do espectrograma gerada pela LUT
+ (SpectrogramImage) com a fórmula log + HSL do desenho por células e mede o
+ custo de ambas por coluna. Sai com código 1 se a diferença passar de 2 LSB.
+
+ --verify-stream lê a fila de frames espectrais (SpectralStream) de outro
+ thread enquanto o motor processa e compara cada frame com o da execução
+ num só thread com o mesmo instante. Sai com código 1 se algum frame vier
+ alterado, fora de ordem, ou se faltar algum que não conste dos descartados.
+
+ --verify-mask põe a UI a publicar estados da Mask2D sem parar enquanto o
+ áudio os adquire (estado completo e por ordem, custo do acquire) e mede o
+ pior tempo por amostra do motor com e sem a UI a escrever na máscara. Sai
+ com código 1 se algum estado adquirido vier misturado ou fora de ordem.
+
+ --verify-fastpath compara os atalhos do motor (identidade com efeitos em
+ repouso e RAW, silêncio) com o pipeline STFT completo num sinal com troços
+ de silêncio e efeitos a ligar/desligar, e mede o custo por amostra de cada
+ um. Sai com código 1 se as saídas divergirem, incluindo nas transições, ou
+ se a saída não for zero exato depois de a cauda do silêncio se esgotar.
+
+ --verify-output compara o condicionamento da saída por blocos (headroom,
+ soft‑limiter tanh vetorial e DC‑block, cada um em vários valores e
+ desligado) com a cadeia amostra a amostra em double, em immediate/spread e
+ separado/emparelhado. Sai com código 1 se a diferença passar de 2e−6 V ou se
+ a saída não for zero exato no fim de um troço de silêncio.
+
+ --verify-split compara o modo multi‑resolução (--split-band: agudos num
+ STFT com N/4, crossover complementar) com o STFT único: reconstrução com
+ os efeitos em repouso (face ao caminho único atrasado de D), pre‑echo de
+ impulsos com blur/PV/PV‑Lock e custo por amostra. Sai com código 1 se a
+ reconstrução divergir ou se o pre‑echo não baixar com o split.
+
+ --verify-phase compara o PhaseEngine com a réplica da versão anterior
+ (tools/ReferencePhase.hpp) em frames STFT de sinusoides com ruído: saída de
+ RAW/PV, coerência vertical do PV_LOCK à volta dos picos (φ[p±1] − φ[p] tem
+ de ser o da análise) e custo por frame de cada modo, antes e depois. Sai com
+ código 1 se RAW/PV divergirem ou se o PV_LOCK não prender a fase.
+
+ --verify-pghi reconstrói um sinal com efeitos (STFT offline, √Hann, 2× e
+ 4×) em cada modo de fase e mede a consistência espectral da saída: distância
+ entre |STFT(saída)| e a magnitude pedida (dB, menor = melhor). Mede também o
+ custo por frame do PGHI para K = 513 face ao período do hop. Sai com código
+ 1 se, em média nos efeitos, o PGHI ficar pior que o PV_LOCK ou se não couber
+ no orçamento.
+
+ --verify-stats verifica a instrumentação ao vivo (HotPathStats): baldes e
+ percentis dos histogramas e custo de uma medição; num build com
+ 'make PROFILE=1' também os hops e amostras medidos no motor e o trace
+ JSON. Sai com código 1 se algum valor não bater certo.
+
+ --verify-render compara o render offline em lote (spectrofx-render, ver
+ BatchRender.hpp) com 1 e 4 threads e blocos pequenos com um motor estéreo
+ a correr o mesmo preset amostra a amostra, em WAV PCM 16 bits de 3 canais e
+ float estéreo a 96 kHz, e reporta o débito. Sai com código 1 se alguma
+ amostra diferir.
+
+ --verify-math mede, para cada ISA suportada (scalar/sse2/avx2/avx512), o erro
+ de SpectralMath::cartToPolar/polarToCart/tanhScaled face a libm em double e
+ o custo por bloco de K valores, face ao sqrt/atan2/cos/sin/tanh escalares. Sai com código 1 se
+ algum erro exceder os limites documentados em SpectralMath.hpp.
+
+ As amostras do WAV ([-1..1]) são escaladas para ±5 V, como no Rack.
+ */
+#include "SpectroEngine.hpp"
+#include "WavFile.hpp"
+#include "ReferenceFX.hpp"
+#include "ReferencePhase.hpp"
+#include "SpectralMath.hpp"
+#include "PlanCache.hpp"
+#include "FFTBackend.hpp"
+#include "SpectrogramImage.hpp"
+#include "BatchRender.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr float kVolts = 5.f;   // amplitude nominal de áudio no Rack (±5 V)
+
+const char* const kEffects[] = { "none", "blur", "sharpen", "edge", "emboss", "mirror", "gate", "stretch" };
+const char* const kPhases[]  = { "raw", "pv", "pvlock", "pghi" };
+const char* const kSchedules[] = { "immediate", "spread" };
+const char* const kBackends[] = { "auto", "fftw", "fftw-threads", "radix", "dft" };    // = FFTBackend::Kind
+const char* const kPrecisions[] = { "double", "float" };                                // = StftPrecision
+
+struct Options {
+    std::string wav, signal = "noise", effect = "all", phase = "all", schedule = "all", out;
+    double seconds = 10.0;
+    int rate = 48000;
+    int block = 64;                 // tamanho de bloco de áudio do Rack
+    int voices = 1;                 // vozes por lado (1..16)
+    int fft = SpectroEngine::DEFAULT_N;     // N de referência (a 48 kHz, escala com --rate)
+    int overlap = 2;                // 2, 4 ou 8
+    int instantiate = 0;            // > 0: mede a criação de N motores
+    std::string wisdom;             // ficheiro de wisdom FFTW (PlanCache)
+    std::string backend = "auto";   // backend FFT (FFTBackend)
+    std::string precision = "double";   // pipeline STFT em double ou float
+    bool pairStereo = false;        // L+R numa só FFT complexa
+    bool splitBand = false;         // agudos num 2º STFT com N/4
+    float limiter = 1.2f;           // drive do soft‑limiter da saída (0 = desligado)
+    float dcBlock = 38.2f;          // corte do DC‑block da saída em Hz (0 = desligado)
+    bool kernels = false;           // micro‑benchmark por estágio
+    std::string report, baseline;   // --kernels: relatório TSV / base a comparar
+    double threshold = 25.0;        // --kernels: regressão tolerada (%)
+    int load = -1;                  // --load: nº de instâncias (0 = procurar o máximo)
+    int threads = 0;                // --load: threads do "motor" (0 = hardware_concurrency)
+    std::string scenario = "lfo";   // --load: cenário
+    double maxMiss = 0.1;           // --load: falhas de prazo toleradas (%)
+    bool rateSet = false, secondsSet = false;
+    float amount = 1.f;
+};
+
+struct Result {
+    double rtf = 0.0, nsPerHop = 0.0, worstNs = 0.0, p999Ns = 0.0, worstBlockNs = 0.0;
+    uint64_t hops = 0;
+};
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: spectrofx-bench [--wav FILE | --signal noise|sine|sweep|impulse]\n"
+        "                       [--seconds S] [--rate SR]\n"
+        "                       [--effect none|blur|sharpen|edge|emboss|mirror|gate|stretch|all]\n"
+        "                       [--phase raw|pv|pvlock|pghi|all] [--amount A] [--out FILE]\n"
+        "                       [--schedule immediate|spread|all] [--block B] [--voices V]\n"
+        "                       [--fft 256..8192] [--overlap 2|4|8] [--wisdom FILE]\n"
+        "                       [--fft-backend auto|fftw|fftw-threads|radix|dft]\n"
+        "                       [--precision double|float] [--pair-stereo] [--split-band]\n"
+        "                       [--limiter DRIVE] [--dc-block HZ]\n"
+        "       spectrofx-bench --instantiate COUNT [--fft N] [--overlap O] [--wisdom FILE]\n"
+        "       spectrofx-bench --kernels [--report FILE] [--baseline FILE] [--threshold PCT]\n"
+        "                       [--overlap O] [--fft-backend B] [--precision P]\n"
+        "       spectrofx-bench --load M|auto [--threads T] [--scenario static|lfo|random|mask|worst|all]\n"
+        "                       [--rate SR] [--seconds S] [--block B] [--voices V] [--max-miss PCT]\n"
+        "                       [--wav FILE | --signal ...] [--schedule immediate|spread] [STFT options]\n"
+        "       spectrofx-bench --verify-fx\n"
+        "       spectrofx-bench --verify-chain\n"
+        "       spectrofx-bench --verify-math\n"
+        "       spectrofx-bench --verify-fft\n"
+        "       spectrofx-bench --verify-precision\n"
+        "       spectrofx-bench --verify-pair\n"
+        "       spectrofx-bench --verify-colormap\n"
+        "       spectrofx-bench --verify-stream\n"
+        "       spectrofx-bench --verify-mask\n"
+        "       spectrofx-bench --verify-fastpath\n"
+        "       spectrofx-bench --verify-output\n"
+        "       spectrofx-bench --verify-split\n"
+        "       spectrofx-bench --verify-phase\n"
+        "       spectrofx-bench --verify-pghi\n"
+        "       spectrofx-bench --verify-stats\n"
+        "       spectrofx-bench --verify-render\n");
+}
+
+// Sinal sintético estéreo (L/R decorrelacionados no caso do ruído).
+WavFile makeSignal(const std::string& name, double seconds, int rate) {
+    WavFile w;
+    w.sampleRate = rate;
+    w.channels = 2;
+    const size_t frames = (size_t)(seconds * rate);
+    w.data.assign(frames * 2, 0.f);
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> uni(-1.f, 1.f);
+    double ph = 0.0;
+    for (size_t i = 0; i < frames; ++i) {
+        float l = 0.f, r = 0.f;
+        if (name == "noise") {
+            l = 0.5f * uni(rng); r = 0.5f * uni(rng);
+        } else if (name == "sine") {
+            l = r = 0.5f * (float)std::sin(2.0 * M_PI * 440.0 * (double)i / rate);
+        } else if (name == "sweep") {
+            // Varrimento exponencial 20 Hz -> 20 kHz ao longo da duração
+            double t = (double)i / rate, f = 20.0 * std::pow(1000.0, t / seconds);
+            ph += 2.0 * M_PI * f / rate;
+            l = r = 0.5f * (float)std::sin(ph);
+        } else if (name == "impulse") {
+            l = r = (i % (size_t)rate == 0) ? 1.f : 0.f;
+        }
+        w.data[2*i] = l; w.data[2*i+1] = r;
+    }
+    return w;
+}
+
+SpectroParams makeParams(int effect, int phase, int schedule, float amount) {
+    SpectroParams p;
+    for (auto& c : p.ch) {
+        switch (effect) {
+            case 1: c.blur    = amount; break;
+            case 2: c.sharpen = amount; break;
+            case 3: c.edge    = amount; break;
+            case 4: c.emboss  = amount; break;
+            case 5: c.mirror  = amount; break;
+            case 6: c.gate    = amount; break;
+            case 7: c.stretch = amount; break;   // 0.5 = repouso
+            default: break;
+        }
+    }
+    p.phaseMode = PhaseEngine::Mode((uint8_t)phase);
+    p.schedule  = HopSchedule((uint8_t)schedule);
+    return p;
+}
+
+// Processa o sinal completo amostra a amostra, cronometrando cada chamada.
+Result run(const WavFile& in, const StftConfig& stft, const SpectroParams& params, int block, int voices, WavFile* out) {
+    auto engine = std::make_unique<SpectroEngine>(stft);   // estado grande: fora da stack
+    engine->setParams(params);
+    engine->setChannels(voices, voices);
+
+    const size_t frames = in.frames();
+    const int chIn = in.channels;
+    if (out) { out->sampleRate = in.sampleRate; out->channels = 2; out->data.assign(frames * 2, 0.f); }
+
+    Result r;
+    double totalNs = 0.0, blockNs = 0.0;
+    std::vector<float> perSample(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        const float* s = &in.data[i * chIn];
+        float xl[SpectroEngine::MAX_VOICES], xr[SpectroEngine::MAX_VOICES];
+        float yl[SpectroEngine::MAX_VOICES], yr[SpectroEngine::MAX_VOICES];
+        for (int v = 0; v < voices; ++v) {
+            const float gain = kVolts * (1.f - v / 32.f);
+            xl[v] = gain * s[0];
+            xr[v] = gain * s[chIn > 1 ? 1 : 0];
+        }
+
+        auto t0 = Clock::now();
+        engine->processFrame(xl, xr, yl, yr);
+        auto t1 = Clock::now();
+
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        totalNs += ns;
+        perSample[i] = (float)ns;
+        if (ns > r.worstNs) r.worstNs = ns;
+        blockNs += ns;
+        if ((i + 1) % (size_t)block == 0) { r.worstBlockNs = std::max(r.worstBlockNs, blockNs); blockNs = 0.0; }
+        if (out) { out->data[2*i] = yl[0] / kVolts; out->data[2*i+1] = yr[0] / kVolts; }
+    }
+
+    if (frames) {
+        auto nth = perSample.begin() + (ptrdiff_t)((frames - 1) * 999 / 1000);
+        std::nth_element(perSample.begin(), nth, perSample.end());
+        r.p999Ns = *nth;
+    }
+    r.hops = engine->hopCount();
+    r.rtf = totalNs * 1e-9 / ((double)frames / in.sampleRate);
+    r.nsPerHop = r.hops ? totalNs / (double)r.hops : 0.0;
+    return r;
+}
+
+// Estatísticas simples de tempo por chamada (média, desvio padrão, máximo).
+struct Timing {
+    double sum = 0.0, sum2 = 0.0, max = 0.0;
+    int n = 0;
+    void add(double ns) { sum += ns; sum2 += ns * ns; max = std::max(max, ns); ++n; }
+    double mean() const { return n ? sum / n : 0.0; }
+    double stddev() const { double m = mean(); return n ? std::sqrt(std::max(0.0, sum2 / n - m * m)) : 0.0; }
+};
+
+/*
+ Compara SpectralFX com ReferenceFX em espectros sintéticos (ruído com picos
+ e envolvente 1/f), para cada efeito a várias intensidades, várias bandas
+ (pesos 0/1) e duas máscaras pintadas (pesos fracionários, com feather).
+*/
+int verifyFX() {
+    constexpr int K = SpectroEngine::DEFAULT_N / 2 + 1;
+    constexpr double kTolerance = 0.015;    // 1.5% do pico (ver SpectralFX.hpp)
+
+    std::mt19937 rng(42);
+    std::normal_distribution<float> nd(0.f, 1.f);
+    std::vector<std::vector<float>> frames;
+    for (int f = 0; f < 16; ++f) {
+        std::vector<float> m(K);
+        for (int k = 0; k < K; ++k)
+            m[k] = std::abs(nd(rng)) * ((k % (17 + f)) == 0 ? 40.f : 1.f) + 50.f / (1.f + 0.1f * k);
+        frames.push_back(m);
+    }
+
+    // Bandas (lo, hi) e máscaras pintadas (lo = −1: rampa suave; lo = −2: 2 regiões com feather)
+    const int bands[][2] = { {0, K - 1}, {100, 300}, {0, 40}, {400, K - 1}, {-1, 0}, {-2, 0} };
+    auto weightsFor = [&](const int* b) {
+        if (b[0] >= 0) return ReferenceFX::bandWeights(K, b[0], b[1]);
+        std::vector<float> w(K, 0.f);
+        for (int k = 0; k < K; ++k) {
+            if (b[0] == -1) w[k] = (float)k / (K - 1);
+            else for (float c : { 120.f, 380.f })
+                w[k] = std::max(w[k], std::clamp(1.f - std::abs(k - c) / 60.f, 0.f, 1.f));
+        }
+        return w;
+    };
+    const float amounts[]  = { 0.05f, 0.2f, 0.5f, 1.f };
+    const float stretchs[] = { 0.f, 0.3f, 0.7f, 1.f };     // 0.5 = repouso
+
+    SpectralFX fx;
+    fx.setup(K);
+    std::vector<float> out(K);
+    Timing tFast, tRef;
+    double worst = 0.0;
+    bool ok = true;
+
+    std::printf("%-8s %6s %-9s %12s\n", "effect", "amount", "band", "maxerr/peak");
+    for (int e = 1; e < 8; ++e) {
+        for (int ai = 0; ai < 4; ++ai) {
+            const float a = (e == 7) ? stretchs[ai] : amounts[ai];
+            FXParams p;
+            switch (e) {
+                case 1: p.blur = a; break;      case 2: p.sharpen = a; break;
+                case 3: p.edge = a; break;      case 4: p.emboss = a; break;
+                case 5: p.mirror = a; break;    case 6: p.gate = a; break;
+                case 7: p.stretch = a; break;
+            }
+            for (auto& b : bands) {
+                const std::vector<float> w = weightsFor(b);
+                double err = 0.0;
+                for (auto& m : frames) {
+                    auto t0 = Clock::now();
+                    std::vector<float> ref = ReferenceFX::process(m, p, w);
+                    auto t1 = Clock::now();
+                    fx.process(m.data(), out.data(), p, w.data());
+                    auto t2 = Clock::now();
+                    tRef.add((double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+                    tFast.add((double)std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count());
+
+                    float peak = *std::max_element(ref.begin(), ref.end());
+                    for (int k = 0; k < K; ++k)
+                        err = std::max(err, (double)std::abs(out[k] - ref[k]) / std::max(peak, 1e-6f));
+                }
+                worst = std::max(worst, err);
+                if (err > kTolerance) ok = false;
+                char band[16];
+                if (b[0] >= 0) std::snprintf(band, sizeof band, "%4d-%-4d", b[0], b[1]);
+                else           std::snprintf(band, sizeof band, "%s", b[0] == -1 ? "ramp" : "feather");
+                std::printf("%-8s %6.2f %-9s %12.6f%s\n", kEffects[e], a, band, err, err > kTolerance ? "  FAIL" : "");
+            }
+        }
+    }
+
+    // Polifonia: C vozes em [K][C] têm de dar exatamente o mesmo que C frames mono.
+    constexpr int C = 4;
+    SpectralFX fxPoly;
+    fxPoly.setup(K, C);
+    std::vector<float> poly(K * C), polyOut(K * C);
+    double polyErr = 0.0;
+    for (int e = 1; e < 8; ++e) {
+        FXParams p;
+        switch (e) {
+            case 1: p.blur = 0.1f; break;   case 2: p.sharpen = 0.5f; break;
+            case 3: p.edge = 0.5f; break;   case 4: p.emboss = 0.5f; break;
+            case 5: p.mirror = 0.5f; break; case 6: p.gate = 0.5f; break;
+            case 7: p.stretch = 0.8f; break;
+        }
+        for (float blurAmt : { 0.f, 0.6f }) {   // + blur recursivo combinado
+            if (blurAmt > 0.f) p.blur = blurAmt;
+            for (int k = 0; k < K; ++k)
+                for (int c = 0; c < C; ++c) poly[k * C + c] = frames[c][k];
+            const std::vector<float> w = weightsFor(bands[5]);
+            fxPoly.process(poly.data(), polyOut.data(), C, p, w.data());
+            for (int c = 0; c < C; ++c) {
+                fx.process(frames[c].data(), out.data(), p, w.data());
+                for (int k = 0; k < K; ++k)
+                    polyErr = std::max(polyErr, (double)std::abs(polyOut[k * C + c] - out[k]));
+            }
+        }
+    }
+    if (polyErr > 0.0) ok = false;
+    std::printf("# poly (C=%d, [K][C]) vs mono maxerr = %g%s\n", C, polyErr, polyErr > 0.0 ? "  FAIL" : "");
+
+    std::printf("# worst maxerr/peak = %.6f (tolerance %.3f)\n", worst, kTolerance);
+    std::printf("# per frame: SpectralFX mean %.0f ns, sd %.0f ns, max %.0f ns | reference mean %.0f ns, sd %.0f ns, max %.0f ns\n",
+                tFast.mean(), tFast.stddev(), tFast.max, tRef.mean(), tRef.stddev(), tRef.max);
+    return ok ? 0 : 1;
+}
+
+/*
+ Ordem da cadeia (FXParams::order): as variantes compiladas de SpectralFX
+ (Sharpen/Edge/Emboss fundidos, Gate+Mirror) face ao caminho genérico
+ (setGeneric: um passe por efeito, efeito escolhido por bin), em ordens
+ aleatórias com parte dos efeitos em repouso, com e sem máscara e com 1 e 4
+ vozes; depois o custo por frame de várias sequências nos dois caminhos.
+*/
+int verifyChain() {
+    constexpr int K = SpectroEngine::DEFAULT_N / 2 + 1, MAXC = 16, kOrders = 400;
+    constexpr double kBound = 1e-6;         // relativo ao pico (mesmas contas, outra ordem de soma)
+    constexpr int NE = (int)Effect::NUM_EFFECTS;
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> nd(0.f, 1.f);
+    std::uniform_real_distribution<float> ud(0.f, 1.f);
+    std::vector<float> frame(K * MAXC), fused(K * MAXC), generic(K * MAXC), mask(K);
+    for (int k = 0; k < K; ++k) {
+        for (int c = 0; c < MAXC; ++c)
+            frame[k * MAXC + c] = std::abs(nd(rng)) * ((k % (17 + c)) == 0 ? 40.f : 1.f) + 50.f / (1.f + 0.1f * k);
+        mask[k] = std::clamp(1.f - std::abs(k - 250.f) / 120.f, 0.f, 1.f);
+    }
+    auto setAmount = [](FXParams& p, Effect e, float a) {
+        switch (e) {
+            case Effect::BLUR:    p.blur = a; break;     case Effect::SHARPEN: p.sharpen = a; break;
+            case Effect::EDGE:    p.edge = a; break;     case Effect::EMBOSS:  p.emboss = a; break;
+            case Effect::GATE:    p.gate = a; break;     case Effect::MIRROR:  p.mirror = a; break;
+            case Effect::STRETCH: p.stretch = a; break;  default: break;
+        }
+    };
+    auto isStencil = [](Effect e) { return e == Effect::SHARPEN || e == Effect::EDGE || e == Effect::EMBOSS; };
+
+    SpectralFX fxFused, fxGeneric;
+    fxFused.setup(K, MAXC);
+    fxGeneric.setup(K, MAXC);
+    fxGeneric.setGeneric(true);
+
+    // Correção: ordens aleatórias; conta as sequências de stencils cobertas (15 possíveis)
+    std::vector<bool> seen(64, false);
+    double worst = 0.0;
+    for (int t = 0; t < kOrders; ++t) {
+        FXParams p;
+        std::shuffle(p.order.begin(), p.order.end(), rng);
+        for (int e = 0; e < NE; ++e)
+            if (ud(rng) < 0.6f) setAmount(p, (Effect)e, e == (int)Effect::STRETCH ? ud(rng) : 0.05f + 0.95f * ud(rng));
+        for (int i = 0, code = 0; i <= NE; ++i) {
+            const Effect e = i < NE ? p.order[i] : Effect::NUM_EFFECTS;
+            if (i < NE && !SpectralFX::active(e, p)) continue;
+            if (i < NE && isStencil(e)) { code = code * 4 + (int)e - (int)Effect::SHARPEN + 1; continue; }
+            if (code) seen[code] = true;
+            code = 0;
+        }
+        const int C = (t & 1) ? 4 : 1;
+        const float* w = (t & 2) ? mask.data() : nullptr;
+        fxFused.process(frame.data(), fused.data(), C, p, w);
+        fxGeneric.process(frame.data(), generic.data(), C, p, w);
+        float peak = 0.f;
+        for (int i = 0; i < K * C; ++i) peak = std::max(peak, generic[i]);
+        for (int i = 0; i < K * C; ++i)
+            worst = std::max(worst, (double)std::abs(fused[i] - generic[i]) / std::max(peak, 1e-6f));
+    }
+    const int covered = (int)std::count(seen.begin(), seen.end(), true);
+    const bool ok = worst <= kBound && covered == 15;
+    std::printf("# %d random orders (C = 1/4, with/without mask): fused vs generic maxerr/peak = %g (bound %g)%s\n",
+                kOrders, worst, kBound, worst > kBound ? "  FAIL" : "");
+    std::printf("# stencil sequences covered: %d/15%s\n", covered, covered < 15 ? "  FAIL" : "");
+
+    // Custo por frame (K bins × C vozes), média de muitas chamadas
+    struct Chain { const char* name; std::vector<Effect> effects; };
+    const Chain chains[] = {
+        { "sharpen",             { Effect::SHARPEN } },
+        { "sharpen>edge",        { Effect::SHARPEN, Effect::EDGE } },
+        { "sharpen>edge>emboss", { Effect::SHARPEN, Effect::EDGE, Effect::EMBOSS } },
+        { "emboss>edge>sharpen", { Effect::EMBOSS, Effect::EDGE, Effect::SHARPEN } },
+        { "gate>mirror",         { Effect::GATE, Effect::MIRROR } },
+        { "mirror>gate",         { Effect::MIRROR, Effect::GATE } },
+        { "all (default order)", { Effect::BLUR, Effect::SHARPEN, Effect::EDGE, Effect::EMBOSS,
+                                   Effect::GATE, Effect::MIRROR, Effect::STRETCH } },
+    };
+    auto perFrame = [&](SpectralFX& fx, int C, const FXParams& p) {
+        const int reps = std::max(200, 20000 / C);
+        for (int r = 0; r < 20; ++r) fx.process(frame.data(), fused.data(), C, p, nullptr);
+        auto t0 = Clock::now();
+        for (int r = 0; r < reps; ++r) fx.process(frame.data(), fused.data(), C, p, nullptr);
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count() / reps;
+    };
+    std::printf("%-22s %3s %12s %12s %8s\n", "chain", "C", "generic ns", "fused ns", "speedup");
+    for (const Chain& ch : chains) {
+        FXParams p;
+        int n = 0;
+        for (Effect e : ch.effects) {
+            setAmount(p, e, e == Effect::STRETCH ? 0.8f : 0.3f);
+            p.order[n++] = e;
+        }
+        for (int e = 0; e < NE; ++e)        // restantes (em repouso) no fim
+            if (std::find(ch.effects.begin(), ch.effects.end(), (Effect)e) == ch.effects.end()) p.order[n++] = (Effect)e;
+        for (int C : { 1, MAXC }) {
+            const double g = perFrame(fxGeneric, C, p), f = perFrame(fxFused, C, p);
+            std::printf("%-22s %3d %12.0f %12.0f %7.2fx\n", ch.name, C, g, f, f > 0.0 ? g / f : 0.0);
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+/*
+ Erro e custo das conversões polar/cartesiano (e do tanh do limiter) por ISA. Entradas: espectros
+ com grande gama dinâmica (incl. zeros e ±0) e fases em (−π, π] e em
+ |φ| ≤ 8192 (domínio garantido do sincos).
+*/
+int verifyMath() {
+    constexpr int K = SpectroEngine::DEFAULT_N / 2 + 1;
+    constexpr int kBlocks = 256;
+    constexpr double kAtanBound = 3.0e-7, kSinCosBound = 1.2e-7, kMagBound = 1.2e-7;    // mag: relativo
+    constexpr double kTanhBound = 5.0e-7;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> uni(-1.f, 1.f);
+    std::uniform_real_distribution<float> ex(-12.f, 4.f);
+    const size_t n = (size_t)K * kBlocks;
+    std::vector<float> re(n), im(n), ph(n), phWide(n), mag(n), phase(n), outRe(n), outIm(n), ones(n, 1.f);
+    std::vector<float> lim(n), limOut(n);      // tanh: entradas do limiter (±10, com o corte da aproximação)
+    for (size_t i = 0; i < n; ++i) {
+        const float s = std::pow(10.f, ex(rng));
+        re[i] = s * uni(rng);
+        im[i] = s * uni(rng);
+        if (i % 97 == 0) re[i] = 0.f;
+        if (i % 89 == 0) im[i] = (i & 1) ? -0.f : 0.f;
+        ph[i]     = (float)M_PI * uni(rng);
+        phWide[i] = 8192.f * uni(rng);
+        lim[i]    = (i % 5 ? 4.f : 10.f) * uni(rng);
+    }
+
+    auto perBlockNs = [&](auto&& fn) {
+        auto t0 = Clock::now();
+        for (int rep = 0; rep < 8; ++rep)
+            for (int b = 0; b < kBlocks; ++b) fn((size_t)b * K);
+        auto t1 = Clock::now();
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() / (8.0 * kBlocks);
+    };
+
+    // Referência: libm escalar em float (o caminho anterior)
+    const double libPolar = perBlockNs([&](size_t o) {
+        for (int k = 0; k < K; ++k) {
+            mag[o + k]   = std::sqrt(re[o + k] * re[o + k] + im[o + k] * im[o + k]);
+            phase[o + k] = std::atan2(im[o + k], re[o + k]);
+        }
+    });
+    const double libCart = perBlockNs([&](size_t o) {
+        for (int k = 0; k < K; ++k) {
+            outRe[o + k] = mag[o + k] * std::cos(ph[o + k]);
+            outIm[o + k] = mag[o + k] * std::sin(ph[o + k]);
+        }
+    });
+    const double libTanh = perBlockNs([&](size_t o) {
+        for (int k = 0; k < K; ++k) limOut[o + k] = std::tanh(lim[o + k]);
+    });
+
+    bool ok = true;
+    const SpectralMath::Isa best = SpectralMath::bestIsa();
+    std::printf("# best ISA: %s, K=%d, libm per block: cartToPolar %.0f ns, polarToCart %.0f ns, tanh %.0f ns\n",
+                SpectralMath::isaName(best), K, libPolar, libCart, libTanh);
+    std::printf("%-7s %12s %12s %12s %12s %12s %12s %12s %12s\n", "isa", "mag relerr", "atan2 err", "sincos err", "wide err",
+                "tanh err", "polar[ns]", "cart[ns]", "tanh[ns]");
+
+    for (int i = 0; i < (int)SpectralMath::Isa::NUM_ISAS; ++i) {
+        const auto isa = (SpectralMath::Isa)i;
+        if (!SpectralMath::setIsa(isa)) continue;
+
+        double eMag = 0.0, eAtan = 0.0, eSc = 0.0, eWide = 0.0, eTanh = 0.0;
+        SpectralMath::cartToPolar(re.data(), im.data(), mag.data(), phase.data(), (int)n);
+        for (size_t j = 0; j < n; ++j) {
+            const double r = re[j], m = im[j];
+            const double h = std::hypot(r, m);
+            if (h > 0.0) eMag = std::max(eMag, std::abs(mag[j] - h) / h);
+            eAtan = std::max(eAtan, std::abs(phase[j] - std::atan2(m, r)));
+        }
+        SpectralMath::polarToCart(ones.data(), ph.data(), outRe.data(), outIm.data(), (int)n);
+        for (size_t j = 0; j < n; ++j)
+            eSc = std::max({ eSc, std::abs(outRe[j] - std::cos((double)ph[j])), std::abs(outIm[j] - std::sin((double)ph[j])) });
+        SpectralMath::polarToCart(ones.data(), phWide.data(), outRe.data(), outIm.data(), (int)n);
+        for (size_t j = 0; j < n; ++j)
+            eWide = std::max({ eWide, std::abs(outRe[j] - std::cos((double)phWide[j])), std::abs(outIm[j] - std::sin((double)phWide[j])) });
+        SpectralMath::tanhScaled(lim.data(), limOut.data(), (int)n, 1.f, 1.f);
+        for (size_t j = 0; j < n; ++j)
+            eTanh = std::max(eTanh, std::abs(limOut[j] - std::tanh((double)lim[j])));
+
+        const double tPolar = perBlockNs([&](size_t o) {
+            SpectralMath::cartToPolar(&re[o], &im[o], &mag[o], &phase[o], K);
+        });
+        const double tCart = perBlockNs([&](size_t o) {
+            SpectralMath::polarToCart(&mag[o], &ph[o], &outRe[o], &outIm[o], K);
+        });
+        const double tTanh = perBlockNs([&](size_t o) {
+            SpectralMath::tanhScaled(&lim[o], &limOut[o], K, 1.f, 1.f);
+        });
+
+        const bool fail = eMag > kMagBound || eAtan > kAtanBound || eSc > kSinCosBound || eWide > kSinCosBound
+                       || eTanh > kTanhBound;
+        ok = ok && !fail;
+        std::printf("%-7s %12.3e %12.3e %12.3e %12.3e %12.3e %12.0f %12.0f %12.0f%s\n", SpectralMath::isaName(isa),
+                    eMag, eAtan, eSc, eWide, eTanh, tPolar, tCart, tTanh, fail ? "  FAIL" : "");
+    }
+    SpectralMath::setIsa(best);
+
+    std::printf("# bounds: mag %.1e (rel), atan2 %.1e rad, sin/cos %.1e, tanh %.1e\n", kMagBound, kAtanBound, kSinCosBound, kTanhBound);
+    return ok ? 0 : 1;
+}
+
+/*
+ Backends FFT face à DFT de referência (acumulada em double), para N =
+ 256..8192 e um lote de 3 vozes, na precisão T: erro máximo da forward
+ relativo ao pico do espectro e da ida‑e‑volta relativo ao pico do sinal.
+ Mostra também os tempos do micro‑benchmark usado pelo modo AUTO e o backend
+ escolhido.
+*/
+template <typename T>
+bool verifyFFTPrecision(const char* label, double bound) {
+    using F = Fftw<T>;
+    constexpr int kVoices = 3;
+    bool ok = true;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> uni(-1.0, 1.0);
+
+    std::printf("%-6s %-6s %-16s %12s %12s %12s %12s %12s\n", "N", "prec", "backend", "fwd err", "roundtrip",
+                "pair fwd", "pair rt", "ns/pair");
+    for (int n = 256; n <= 8192; n *= 2) {
+        const int kp = ((n / 2 + 1) + 7) & ~7;
+        T* x = F::allocReal((size_t)kVoices * n);
+        T* y = F::allocReal((size_t)kVoices * n);
+        typename F::Complex* ref  = F::allocComplex((size_t)kVoices * kp);
+        typename F::Complex* spec = F::allocComplex((size_t)kVoices * kp);
+        for (int i = 0; i < kVoices * n; ++i) x[i] = (T)uni(rng);
+
+        FFTBackend::create<T>(FFTBackend::Kind::REFERENCE, n, kp)->forward(x, ref, kVoices);
+        double refPeak = 0.0;
+        for (int v = 0; v < kVoices; ++v)
+            for (int b = 0; b <= n / 2; ++b) {
+                const size_t i = (size_t)v * kp + b;
+                refPeak = std::max(refPeak, std::hypot((double)ref[i][0], (double)ref[i][1]));
+            }
+
+        const FFTBackend::Selection& sel = FFTBackend::select<T>(n, kp);
+        for (int k = 1; k < (int)FFTBackend::Kind::NUM_KINDS; ++k) {
+            const auto kind = FFTBackend::Kind(k);
+            if (kind == FFTBackend::Kind::REFERENCE && n > 2048) continue;     // O(N²)
+            auto fft = FFTBackend::create<T>(kind, n, kp, true);
+
+            double eFwd = 0.0, eRt = 0.0, ePairFwd = 0.0, ePairRt = 0.0;
+            fft->forward(x, spec, kVoices);
+            for (int v = 0; v < kVoices; ++v)
+                for (int b = 0; b <= n / 2; ++b) {
+                    const size_t i = (size_t)v * kp + b;
+                    eFwd = std::max(eFwd, std::hypot((double)spec[i][0] - ref[i][0], (double)spec[i][1] - ref[i][1]) / refPeak);
+                }
+            fft->inverse(spec, y, kVoices);
+            for (int i = 0; i < kVoices * n; ++i) eRt = std::max(eRt, std::fabs((double)y[i] / n - x[i]));
+
+            // Two‑for‑one: voz 0 (a) com voz 1 (b)
+            fft->forwardPairs(x, x + n, spec, spec + kp, 1);
+            for (int v = 0; v < 2; ++v)
+                for (int b = 0; b <= n / 2; ++b) {
+                    const size_t i = (size_t)v * kp + b;
+                    ePairFwd = std::max(ePairFwd, std::hypot((double)spec[i][0] - ref[i][0], (double)spec[i][1] - ref[i][1]) / refPeak);
+                }
+            fft->inversePairs(spec, spec + kp, y, y + n, 1);
+            for (int i = 0; i < 2 * n; ++i) ePairRt = std::max(ePairRt, std::fabs((double)y[i] / n - x[i]));
+
+            const bool fail = eFwd > bound || eRt > bound || ePairFwd > bound || ePairRt > bound;
+            ok = ok && !fail;
+            std::printf("%-6d %-6s %-16s %12.3e %12.3e %12.3e %12.3e %12.0f%s%s\n", n, label, FFTBackend::name(kind),
+                        eFwd, eRt, ePairFwd, ePairRt, sel.nsPerPair[k], kind == sel.best ? "  <- auto" : "", fail ? "  FAIL" : "");
+        }
+        F::free(x); F::free(y); F::free(ref); F::free(spec);
+    }
+    std::printf("# bound: %.0e (relative)\n", bound);
+    return ok;
+}
+
+int verifyFFT() {
+    const bool okDouble = verifyFFTPrecision<double>("double", 1e-12);
+    const bool okFloat  = verifyFFTPrecision<float>("float", 1e-5);
+    return okDouble && okFloat ? 0 : 1;
+}
+
+/*
+ Pipeline em float face ao pipeline em double: o mesmo ruído estéreo (3 s a
+ 48 kHz) processado pelos dois, por efeito, modo de fase e N/overlap.
+ Diferença entre as saídas relativa ao RMS da saída em double (RMS e pico,
+ em dB) e RTF de cada precisão. Em RAW o erro é o da FFT em float (frame a
+ frame); em PV/PV-Lock a fase acumulada deriva lentamente entre as duas
+ precisões, o que aparece como diferença maior sem ser ruído audível.
+*/
+int verifyPrecision() {
+    constexpr double kBoundDb = -80.0;      // muito abaixo do audível (ruído de 16 bits ≈ −98 dBFS)
+    struct Case { int effect, phase, fft, overlap; };
+    const Case cases[] = {
+        { 0, 0, 1024, 2 }, { 0, 0, 256, 2 }, { 0, 0, 4096, 4 }, { 0, 0, 8192, 8 },
+        { 1, 0, 1024, 2 }, { 3, 0, 1024, 2 }, { 6, 0, 1024, 2 }, { 7, 0, 1024, 2 },
+        { 0, 1, 1024, 2 }, { 0, 2, 1024, 2 }, { 7, 2, 2048, 4 },
+    };
+    const WavFile in = makeSignal("noise", 3.0, 48000);
+    bool ok = true;
+
+    std::printf("%-8s %-7s %6s %4s %12s %12s %10s %10s %8s\n", "effect", "phase", "N", "ov",
+                "diff rms", "diff peak", "rtf f64", "rtf f32", "speedup");
+    for (const Case& c : cases) {
+        StftConfig stft;
+        stft.fftSize = c.fft;
+        stft.overlap = c.overlap;
+        const SpectroParams params = makeParams(c.effect, c.phase, 0, 1.f);
+
+        WavFile outD, outF;
+        stft.precision = StftPrecision::DOUBLE;
+        const Result rd = run(in, stft, params, 64, 1, &outD);
+        stft.precision = StftPrecision::FLOAT;
+        const Result rf = run(in, stft, params, 64, 1, &outF);
+
+        double ref2 = 0.0, diff2 = 0.0, peak = 0.0, diffPeak = 0.0;
+        for (size_t i = 0; i < outD.data.size(); ++i) {
+            const double d = (double)outF.data[i] - outD.data[i];
+            ref2 += (double)outD.data[i] * outD.data[i];
+            diff2 += d * d;
+            peak = std::max(peak, (double)std::fabs(outD.data[i]));
+            diffPeak = std::max(diffPeak, std::fabs(d));
+        }
+        auto db = [](double r) { return 20.0 * std::log10(std::max(r, 1e-30)); };
+        const double rmsDb  = db(std::sqrt(diff2 / std::max(ref2, 1e-30)));
+        const double peakDb = db(diffPeak / std::max(peak, 1e-30));
+        const bool fail = rmsDb > kBoundDb;
+        ok = ok && !fail;
+        std::printf("%-8s %-7s %6d %4d %9.1f dB %9.1f dB %10.5f %10.5f %7.2fx%s\n", kEffects[c.effect], kPhases[c.phase],
+                    c.fft, c.overlap, rmsDb, peakDb, rd.rtf, rf.rtf, rf.rtf > 0.0 ? rd.rtf / rf.rtf : 0.0, fail ? "  FAIL" : "");
+    }
+    std::printf("# bound: diff rms < %.0f dB (relative to the double output)\n", kBoundDb);
+    return ok ? 0 : 1;
+}
+
+/*
+ Estéreo emparelhado face ao caminho por canal. Os hops de R emparelhados
+ ficam alinhados com os de L, logo a referência de R é o lado L de um motor
+ por canal que recebe o sinal de R em L: a comparação é exata (amostra a
+ amostra), para qualquer efeito. Ruído L/R decorrelacionado, 3 s a 48 kHz.
+*/
+int verifyPair() {
+    constexpr double kBoundDb[2] = { -120.0, -100.0 };     // double, float
+    const WavFile in = makeSignal("noise", 3.0, 48000);
+    WavFile inR = in;                               // R copiado para L (referência de R)
+    for (size_t i = 0; i < inR.frames(); ++i) inR.data[2 * i] = inR.data[2 * i + 1];
+    const SpectroParams params = makeParams(1, 0, 1, 0.5f);    // blur, RAW, spread
+
+    auto diffDb = [](const WavFile& a, const WavFile& b, int ch) {
+        double ref2 = 0.0, diff2 = 0.0;
+        for (size_t i = 0; i < a.frames(); ++i) {
+            const double x = a.data[2 * i + ch], d = (double)b.data[2 * i + ch] - x;
+            ref2 += x * x;
+            diff2 += d * d;
+        }
+        return 20.0 * std::log10(std::max(std::sqrt(diff2 / std::max(ref2, 1e-30)), 1e-30));
+    };
+
+    bool ok = true;
+    std::printf("%-16s %6s %6s %10s %10s %12s %12s %8s\n", "backend", "voices", "prec", "L diff", "R diff",
+                "ns/hop sep", "ns/hop pair", "speedup");
+    for (FFTBackend::Kind kind : { FFTBackend::Kind::FFTW, FFTBackend::Kind::RADIX }) {
+        for (int voices : { 1, 4 }) {
+            for (StftPrecision prec : { StftPrecision::DOUBLE, StftPrecision::FLOAT }) {
+                StftConfig stft;
+                stft.backend = kind;
+                stft.precision = prec;
+                WavFile sepL, sepR, pair;
+                const Result rs = run(in, stft, params, 64, voices, &sepL);
+                run(inR, stft, params, 64, voices, &sepR);
+                stft.pairStereo = true;
+                const Result rp = run(in, stft, params, 64, voices, &pair);
+
+                const double dL = diffDb(sepL, pair, 0);
+                for (size_t i = 0; i < sepR.frames(); ++i) sepR.data[2 * i + 1] = sepR.data[2 * i];
+                const double dR = diffDb(sepR, pair, 1);
+                const bool single = prec == StftPrecision::FLOAT;
+                const bool fail = dL > kBoundDb[single] || dR > kBoundDb[single];
+                ok = ok && !fail;
+                auto fmt = [](double db, char* buf) {   // saída float idêntica -> "exact"
+                    if (db < -500.0) std::snprintf(buf, 16, "exact");
+                    else             std::snprintf(buf, 16, "%.1f dB", db);
+                    return buf;
+                };
+                char bL[16], bR[16];
+                std::printf("%-16s %6d %6s %10s %10s %12.0f %12.0f %7.2fx%s\n", FFTBackend::name(kind), voices,
+                            single ? "float" : "double", fmt(dL, bL), fmt(dR, bR), rs.nsPerHop, rp.nsPerHop,
+                            rp.nsPerHop > 0.0 ? rs.nsPerHop / rp.nsPerHop : 0.0, fail ? "  FAIL" : "");
+            }
+        }
+    }
+    std::printf("# bound: diff < %.0f dB (double), %.0f dB (float)\n", kBoundDb[0], kBoundDb[1]);
+    return ok ? 0 : 1;
+}
+
+/*
+ Coluna do espectrograma (SpectrogramImage) face à fórmula por célula do
+ desenho original (log + HSL): diferença máxima por canal em magnitudes de
+ 1e−8 a 1e4 (incl. 0, NaN e os limiares entre níveis) e custo de gerar uma
+ coluna de K bins. O desenho antigo recalculava as HIST colunas por frame;
+ o novo escreve só a coluna nova.
+*/
+int verifyColormap() {
+    constexpr int K = SpectroEngine::DEFAULT_N / 2 + 1;
+    constexpr int HIST = SpectroEngine::HIST;
+    constexpr int kBoundLsb = 2;
+    const SpectrogramImage::Colormap& lut = SpectrogramImage::colormap();
+
+    std::vector<float> mags = { 0.f, std::nanf("") };
+    for (int i = 0; i <= 12 * 1000; ++i) mags.push_back(std::pow(10.f, -8.f + i / 1000.f));
+    for (float t : lut.threshold)
+        mags.insert(mags.end(), { std::nextafter(t, 0.f), t, std::nextafter(t, 1e9f) });
+
+    int maxLsb = 0;
+    bool monotonic = true;
+    for (size_t i = 0; i < mags.size(); ++i) {
+        uint8_t a[4], b[4];
+        const uint32_t ca = lut.rgba[SpectrogramImage::level(mags[i])], cb = SpectrogramImage::referenceColor(mags[i]);
+        std::memcpy(a, &ca, 4);
+        std::memcpy(b, &cb, 4);
+        for (int c = 0; c < 4; ++c) maxLsb = std::max(maxLsb, std::abs((int)a[c] - (int)b[c]));
+        if (i > 2 && mags[i] >= mags[i - 1] && SpectrogramImage::level(mags[i]) < SpectrogramImage::level(mags[i - 1]))
+            monotonic = false;
+    }
+
+    // Custo por coluna: células com log + HSL vs. LUT (imagem HIST × (K−1))
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> ex(-6.f, 3.f);
+    std::vector<float> col((size_t)K * HIST);
+    for (float& m : col) m = std::pow(10.f, ex(rng));
+    std::vector<uint8_t> image((size_t)HIST * (K - 1) * 4);
+    std::vector<uint32_t> cells((size_t)K);
+    auto perColumnNs = [&](auto&& fn) {
+        auto t0 = Clock::now();
+        for (int rep = 0; rep < 4; ++rep)
+            for (int c = 0; c < HIST; ++c) fn(c);
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count() / (4.0 * HIST);
+    };
+    const double tCells = perColumnNs([&](int c) {
+        for (int k = 0; k < K - 1; ++k) cells[k] = SpectrogramImage::referenceColor(col[(size_t)c * K + k]);
+    });
+    const double tLut = perColumnNs([&](int c) {
+        SpectrogramImage::writeColumn(&col[(size_t)c * K], K - 1, image.data(), HIST, c);
+    });
+
+    const bool fail = maxLsb > kBoundLsb || !monotonic;
+    std::printf("# K=%d, HIST=%d, %d levels, %zu magnitudes\n", K, HIST, SpectrogramImage::LEVELS, mags.size());
+    std::printf("max diff %d LSB (bound %d), monotonic %s%s\n", maxLsb, kBoundLsb, monotonic ? "yes" : "no",
+                fail ? "  FAIL" : "");
+    std::printf("per column: log+HSL %.0f ns, LUT %.0f ns (%.1fx)\n", tCells, tLut, tLut > 0.0 ? tCells / tLut : 0.0);
+    std::printf("per UI frame: old %.1f us (%d columns), new %.1f us (1 column)\n", tCells * HIST * 1e-3, HIST, tLut * 1e-3);
+    return fail ? 1 : 0;
+}
+
+/*
+ Fila de frames espectrais (SpectralStream) entre o thread de áudio e um
+ consumidor concorrente. Referência: o mesmo motor num só thread, com a fila
+ esvaziada a cada amostra (todos os frames, por instante). Cada frame lido
+ em concorrência tem de ser igual, bit a bit, ao da referência com o mesmo
+ instante, e os instantes de cada lado crescentes em múltiplos de H. Verifica
+ também que o SpectralDecimator com K−1 linhas lineares e 1 hop por coluna
+ devolve os bins tal como estão.
+*/
+int verifyStream() {
+    StftConfig stft;
+    stft.overlap = 8;
+    const WavFile in = makeSignal("noise", 4.0, 48000);
+    const SpectroParams params = makeParams(1, 0, 0, 0.5f);    // blur, RAW, immediate
+
+    auto feed = [&](SpectroEngine& e, size_t i) {
+        const float xl = kVolts * in.data[2 * i], xr = kVolts * in.data[2 * i + 1];
+        float yl, yr;
+        e.processFrame(&xl, &xr, &yl, &yr);
+    };
+
+    // Referência: todos os frames de cada lado, por instante
+    std::vector<std::pair<uint64_t, std::vector<float>>> ref[2];
+    auto engine = std::make_unique<SpectroEngine>(stft);
+    engine->setParams(params);
+    const int K = engine->bins(), H = engine->hopSize();
+    bool ok = true;
+    for (size_t i = 0; i < in.frames(); ++i) {
+        feed(*engine, i);
+        for (int g = 0; g < 2; ++g) {
+            SpectralStream& st = engine->spectra(g);
+            for (int n = st.available(), f = 0; f < n; ++f) {
+                uint64_t t;
+                const float* m = st.frame(f, &t);
+                ref[g].emplace_back(t, std::vector<float>(m, m + K));
+            }
+            st.pop(st.available());
+        }
+    }
+
+    // Decimador sem agregação: identidade nos bins 0..K−2
+    {
+        SpectralDecimator dec;
+        dec.setup(K, K - 1, false, 1);
+        SpectralStream st;
+        st.setup(K);
+        st.push(0, ref[0].back().second.data(), 1);
+        bool same = true;
+        dec.drain(st, 1, [&](const float* col) {
+            same = std::equal(col, col + K - 1, ref[0].back().second.begin());
+        });
+        ok = ok && same;
+        std::printf("decimator identity (K-1 linear rows, 1 hop/column): %s\n", same ? "ok" : "FAIL");
+    }
+
+    // Produtor (áudio) e consumidor (UI) em concorrência
+    engine = std::make_unique<SpectroEngine>(stft);
+    engine->setParams(params);
+    std::atomic<bool> done { false };
+    uint64_t received[2] = {}, mismatched[2] = {}, disordered[2] = {};
+    std::thread ui([&] {
+        size_t cursor[2] = {};
+        uint64_t last[2] = {};
+        bool any[2] = {};
+        for (bool finished = false; !finished; ) {
+            finished = done.load(std::memory_order_acquire);    // última passagem depois do fim
+            for (int g = 0; g < 2; ++g) {
+                SpectralStream& st = engine->spectra(g);
+                const int n = st.available();
+                for (int f = 0; f < n; ++f) {
+                    uint64_t t;
+                    const float* m = st.frame(f, &t);
+                    if (any[g] && (t <= last[g] || (t - last[g]) % H != 0)) ++disordered[g];
+                    any[g] = true;
+                    last[g] = t;
+                    while (cursor[g] < ref[g].size() && ref[g][cursor[g]].first < t) ++cursor[g];
+                    if (cursor[g] == ref[g].size() || ref[g][cursor[g]].first != t
+                        || !std::equal(m, m + K, ref[g][cursor[g]].second.begin()))
+                        ++mismatched[g];
+                    ++received[g];
+                }
+                st.pop(n);
+            }
+            std::this_thread::yield();
+        }
+    });
+    const auto t0 = Clock::now();
+    for (size_t i = 0; i < in.frames(); ++i) feed(*engine, i);
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    done.store(true, std::memory_order_release);
+    ui.join();
+
+    std::printf("# N=%d H=%d K=%d, %d-frame ring, %.2f s of audio in %.1f ms\n", engine->fftSize(), H, K,
+                SpectralStream::CAPACITY, (double)in.frames() / in.sampleRate, ms);
+    std::printf("%-5s %10s %10s %10s %10s %10s\n", "side", "hops", "received", "dropped", "mismatch", "order");
+    for (int g = 0; g < 2; ++g) {
+        const bool fail = mismatched[g] > 0 || disordered[g] > 0
+                       || received[g] + engine->spectra(g).dropped() != ref[g].size();
+        ok = ok && !fail;
+        std::printf("%-5s %10zu %10llu %10llu %10llu %10llu%s\n", g ? "R" : "L", ref[g].size(),
+                    (unsigned long long)received[g], (unsigned long long)engine->spectra(g).dropped(),
+                    (unsigned long long)mismatched[g], (unsigned long long)disordered[g], fail ? "  FAIL" : "");
+    }
+    return ok ? 0 : 1;
+}
+
+/*
+ Mask2D sob escrita contínua da UI. (1) Máscara isolada: a UI publica o
+ estado v (todos os pesos = v, limites e 'enabled' função de v) o mais
+ depressa que consegue; o "áudio" adquire em ciclo e verifica que cada
+ estado está completo (pesos e limites do mesmo v) e que v nunca recua.
+ (2) Motor completo a processar enquanto a UI muda limites e pesos sem
+ parar: pior tempo por amostra face ao mesmo motor sem UI.
+*/
+int verifyMask() {
+    constexpr int HIST = SpectroEngine::HIST, K = SpectroEngine::DEFAULT_N / 2 + 1;
+    constexpr double kSeconds = 0.5;
+    auto bounds = [](int v, int& lo, int& hi) { lo = v % (K / 2); hi = lo + K / 4 + v % 7; };
+
+    bool ok = true;
+    {
+        auto mask = std::make_unique<Mask2D>();
+        mask->setup(HIST, K);
+        std::atomic<bool> done { false };
+        int published = 0;
+        std::thread ui([&] {
+            for (int v = 2; !done.load(std::memory_order_relaxed); ++v) {   // 1 = pesos de setup()
+                Mask2D::State& e = mask->edit();
+                std::fill_n(e.weights, (size_t)HIST * mask->stride, (float)v);
+                bounds(v, e.lowBin, e.highBin);
+                e.enabled = v & 1;
+                mask->publish();
+                published = v;
+            }
+        });
+        uint64_t acquires = 0, states = 0, torn = 0, backwards = 0;
+        int last = 1;
+        Timing t;
+        const auto end = Clock::now() + std::chrono::duration<double>(kSeconds);
+        while (Clock::now() < end) {
+            const auto t0 = Clock::now();
+            const Mask2D::State& s = mask->acquire();
+            t.add((double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+            ++acquires;
+            const int v = (int)s.weights[0];
+            if (v == last) continue;
+            ++states;
+            if (v < last) ++backwards;
+            last = v;
+            int lo, hi;
+            bounds(v, lo, hi);
+            bool same = s.lowBin == lo && s.highBin == hi && s.enabled == (bool)(v & 1);
+            for (int c = 0; c < HIST && same; ++c) {
+                const float* col = s.column(c, mask->stride);
+                same = std::all_of(col, col + K, [&](float w) { return w == (float)v; });
+            }
+            if (!same) ++torn;
+        }
+        done.store(true);
+        ui.join();
+        const bool fail = torn > 0 || backwards > 0 || states == 0;
+        ok = ok && !fail;
+        std::printf("# Mask2D %dx%d: %d states published in %.1f s\n", HIST, K, published, kSeconds);
+        std::printf("acquire: %llu calls, mean %.0f ns, max %.0f ns; %llu states seen, %llu torn, %llu out of order%s\n",
+                    (unsigned long long)acquires, t.mean(), t.max, (unsigned long long)states,
+                    (unsigned long long)torn, (unsigned long long)backwards, fail ? "  FAIL" : "");
+    }
+
+    // Motor com e sem UI a escrever na máscara
+    const WavFile in = makeSignal("noise", 2.0, 48000);
+    const SpectroParams params = makeParams(1, 0, 0, 0.5f);    // blur, RAW, immediate
+    std::printf("# %u hardware threads (with 1, 'worst' includes preemption by the UI thread)\n",
+                std::thread::hardware_concurrency());
+    std::printf("%-10s %12s %12s %10s\n", "ui", "publishes", "worst[us]", "ns/hop");
+    for (bool hammer : { false, true }) {
+        auto engine = std::make_unique<SpectroEngine>();
+        engine->setParams(params);
+        std::atomic<bool> done { false };
+        int publishes = 0;
+        std::thread ui;
+        if (hammer)
+            ui = std::thread([&] {
+                Mask2D& m = engine->mask();
+                for (int v = 1; !done.load(std::memory_order_relaxed); ++v, publishes += 2) {
+                    int lo, hi;
+                    bounds(v, lo, hi);
+                    m.setBounds(lo, hi);
+                    m.clear((v & 1) ? 1.f : 0.5f);
+                }
+            });
+        double worst = 0.0, total = 0.0;
+        for (size_t i = 0; i < in.frames(); ++i) {
+            const float xl = kVolts * in.data[2 * i], xr = kVolts * in.data[2 * i + 1];
+            float yl, yr;
+            const auto t0 = Clock::now();
+            engine->processFrame(&xl, &xr, &yl, &yr);
+            const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+            worst = std::max(worst, ns);
+            total += ns;
+        }
+        done.store(true);
+        if (ui.joinable()) ui.join();
+        std::printf("%-10s %12d %12.2f %10.0f\n", hammer ? "writing" : "idle", publishes, worst * 1e-3,
+                    total / std::max<double>(1.0, (double)engine->hopCount()));
+    }
+    return ok ? 0 : 1;
+}
+
+/*
+ Custo de "abrir um patch" com 'count' instâncias: tempo de construção de
+ cada motor (planos do PlanCache + buffers). Depois espera pelas melhorias
+ em fundo (FFTW_PATIENT), que ficam na wisdom para a próxima execução.
+*/
+int instantiate(const StftConfig& stft, int count) {
+    std::vector<std::unique_ptr<SpectroEngine>> engines;
+    Timing t;
+    double firstMs = 0.0;
+    const auto start = Clock::now();
+    for (int i = 0; i < count; ++i) {
+        auto t0 = Clock::now();
+        engines.push_back(std::make_unique<SpectroEngine>(stft));
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        if (i == 0) firstMs = ms;
+        t.add(ms);
+    }
+    const double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::printf("# N=%d H=%d, %d instances, %d shared plans\n",
+                engines[0]->fftSize(), engines[0]->hopSize(), count, PlanCache::size());
+    std::printf("first %.2f ms, mean %.2f ms, max %.2f ms, total %.1f ms\n", firstMs, t.mean(), t.max, totalMs);
+
+    const auto w0 = Clock::now();
+    PlanCache::waitIdle();
+    std::printf("background FFTW_PATIENT upgrades: %.1f ms\n",
+                std::chrono::duration<double, std::milli>(Clock::now() - w0).count());
+    return 0;
+}
+
+int indexOf(const char* const* names, int n, const std::string& s) {
+    for (int i = 0; i < n; ++i) if (s == names[i]) return i;
+    return -1;
+}
+
+} // namespace
+
+/*
+ Atalhos IDENTITY/SILENT face ao pipeline completo (SpectroParams::fastPaths).
+ 8 s a 48 kHz, 2 vozes por lado, um troço por segundo: ruído, seno ou
+ silêncio, com o blur (RAW) ligado ou em repouso. O STFT em repouso só
+ reconstrói a entrada, logo as saídas coincidem a menos do piso MAG_EPS e do
+ arredondamento, também nas transições (cada hop entra no OLA com a sua
+ janela). No último quarto de cada troço de silêncio a saída tem de ser 0.
+*/
+int verifyFastPath() {
+    constexpr int kRate = 48000, kSeconds = 8, kVoices = 2;
+    constexpr double kBoundV = 1e-4;                        // −94 dB face a ±5 V
+    enum { NOISE, SINE, SILENCE };
+    const int signal[kSeconds] = { NOISE, NOISE, SILENCE, SINE, SILENCE, NOISE, SILENCE, NOISE };
+    const float blur[kSeconds] = { 0.f, 0.5f, 0.5f, 0.f, 0.f, 0.5f, 0.f, 0.f };
+
+    const WavFile noise = makeSignal("noise", 1.0, kRate), sine = makeSignal("sine", 1.0, kRate);
+    auto input = [&](size_t i, int ch) {
+        const int sec = (int)(i / kRate);
+        const size_t k = i % kRate;
+        return signal[sec] == NOISE ? noise.data[2 * k + ch] : signal[sec] == SINE ? sine.data[2 * k + ch] : 0.f;
+    };
+
+    // Saída [amostra][lado][voz] e nº de hops (total / por atalho)
+    struct Render { std::vector<float> out; uint64_t hops = 0, fast = 0; };
+    auto render = [&](const StftConfig& stft, HopSchedule schedule, bool fastPaths) {
+        auto engine = std::make_unique<SpectroEngine>(stft);
+        engine->setChannels(kVoices, kVoices);
+        Render r;
+        r.out.resize((size_t)kSeconds * kRate * 2 * kVoices);
+        for (size_t i = 0; i < (size_t)kSeconds * kRate; ++i) {
+            if (i % kRate == 0) {
+                SpectroParams p = makeParams(1, 0, (int)schedule, blur[i / kRate]);
+                p.fastPaths = fastPaths;
+                engine->setParams(p);
+            }
+            float x[2][kVoices], y[2][kVoices];
+            for (int g = 0; g < 2; ++g)
+                for (int v = 0; v < kVoices; ++v) x[g][v] = kVolts * (1.f - v / 32.f) * input(i, g);
+            engine->processFrame(x[0], x[1], y[0], y[1]);
+            std::memcpy(&r.out[i * 2 * kVoices], y, sizeof(y));
+        }
+        r.hops = engine->hopCount();
+        r.fast = engine->fastHopCount();
+        return r;
+    };
+
+    bool ok = true;
+    std::printf("%-10s %-9s %12s %10s %8s\n", "schedule", "stereo", "maxdiff[V]", "fast hops", "zeros");
+    for (HopSchedule schedule : { HopSchedule::IMMEDIATE, HopSchedule::SPREAD }) {
+        for (bool paired : { false, true }) {
+            StftConfig stft;
+            stft.pairStereo = paired;
+            const Render full = render(stft, schedule, false), fast = render(stft, schedule, true);
+
+            double maxDiff = 0.0;
+            for (size_t i = 0; i < full.out.size(); ++i)
+                maxDiff = std::max(maxDiff, (double)std::fabs(full.out[i] - fast.out[i]));
+            bool zeros = true;
+            for (int sec = 0; sec < kSeconds; ++sec) {
+                if (signal[sec] != SILENCE) continue;
+                const size_t from = (size_t)sec * kRate + 3 * kRate / 4, to = (size_t)(sec + 1) * kRate;
+                for (size_t i = from * 2 * kVoices; i < to * 2 * kVoices; ++i) zeros = zeros && fast.out[i] == 0.f;
+            }
+            const bool fail = maxDiff > kBoundV || !zeros || fast.fast == 0;
+            ok = ok && !fail;
+            std::printf("%-10s %-9s %12.3g %9.1f%% %8s%s\n", kSchedules[(int)schedule], paired ? "paired" : "separate",
+                        maxDiff, 100.0 * fast.fast / std::max<uint64_t>(1, fast.hops), zeros ? "ok" : "no",
+                        fail ? "  FAIL" : "");
+        }
+    }
+    std::printf("# bound: maxdiff < %.0e V; zeros = exact 0 in the last quarter of each silent second\n", kBoundV);
+
+    // Custo por amostra (4 s, 1 voz): pipeline completo vs atalhos, em repouso e em silêncio
+    WavFile silence = makeSignal("noise", 4.0, kRate);
+    std::fill(silence.data.begin(), silence.data.end(), 0.f);
+    const WavFile busy = makeSignal("noise", 4.0, kRate);
+    std::printf("%-10s %12s %12s %8s\n", "input", "full ns/smp", "fast ns/smp", "speedup");
+    for (const WavFile* w : { &busy, (const WavFile*)&silence }) {
+        double ns[2];
+        for (int f = 0; f < 2; ++f) {
+            SpectroParams p = makeParams(0, 0, 0, 0.f);     // efeitos em repouso, RAW
+            p.fastPaths = f == 1;
+            const Result r = run(*w, StftConfig(), p, 64, 1, nullptr);
+            ns[f] = r.rtf * 1e9 / kRate;
+        }
+        std::printf("%-10s %12.1f %12.1f %7.1fx\n", w == &busy ? "neutral" : "silence", ns[0], ns[1],
+                    ns[1] > 0.0 ? ns[0] / ns[1] : 0.0);
+    }
+    return ok ? 0 : 1;
+}
+
+/*
+ Condicionamento da saída por blocos (SpectroParams::limiterDrive/dcBlockHz)
+ face à cadeia anterior, amostra a amostra em double: headroom, tanh de libm
+ e DC‑block com R = 1 − 2π·fc/fs. Com RAW e efeitos em repouso o OLA é a
+ entrada atrasada de latency() (atalho IDENTITY), logo a referência é a
+ cadeia aplicada à entrada atrasada. Ruído forte (limiter a comprimir) com
+ offset DC, 2 vozes por lado, seguido de silêncio: no último quarto do
+ silêncio a saída tem de ser 0 exato (cauda do DC‑block esgotada).
+*/
+int verifyOutput() {
+    constexpr int kRate = 48000, kVoices = 2;
+    constexpr size_t kSignal = 2 * kRate, kTotal = kSignal + 3 * kRate / 2;
+    constexpr double kBoundV = 2e-6;
+    const float drives[] = { 0.f, 1.2f, 4.f }, cutoffs[] = { 0.f, 5.f, 38.2f };
+
+    const WavFile noise = makeSignal("noise", (double)kSignal / kRate, kRate);
+    auto input = [&](size_t i, int g, int v) {
+        return i < kSignal ? kVolts * (1.f - v / 32.f) * (1.6f * noise.data[2 * i + g] + 0.2f) : 0.f;
+    };
+
+    bool ok = true;
+    std::printf("%-10s %-9s %7s %8s %12s %8s\n", "schedule", "stereo", "drive", "dc[Hz]", "maxdiff[V]", "zeros");
+    for (HopSchedule schedule : { HopSchedule::IMMEDIATE, HopSchedule::SPREAD }) {
+        for (bool paired : { false, true }) {
+            for (float drive : drives) {
+                for (float fc : cutoffs) {
+                    StftConfig stft;
+                    stft.pairStereo = paired;
+                    auto engine = std::make_unique<SpectroEngine>(stft);
+                    engine->setChannels(kVoices, kVoices);
+                    SpectroParams p = makeParams(0, 0, (int)schedule, 0.f);
+                    p.limiterDrive = drive;
+                    p.dcBlockHz = fc;
+                    engine->setParams(p);
+                    const size_t lat = (size_t)engine->latency();
+
+                    const double R = fc > 0.f ? 1.0 - 2 * M_PI * fc / kRate : 0.0;
+                    double x1[2][kVoices] = {}, y1[2][kVoices] = {};
+                    double maxDiff = 0.0;
+                    bool zeros = true;
+                    for (size_t i = 0; i < kTotal; ++i) {
+                        float x[2][kVoices], y[2][kVoices];
+                        for (int g = 0; g < 2; ++g)
+                            for (int v = 0; v < kVoices; ++v) x[g][v] = input(i, g, v);
+                        engine->processFrame(x[0], x[1], y[0], y[1]);
+                        for (int g = 0; g < 2; ++g) {
+                            for (int v = 0; v < kVoices; ++v) {
+                                double r = i >= lat ? 0.5 * input(i - lat, g, v) : 0.0;
+                                if (drive > 0.f) r = std::tanh(drive * r) / std::tanh((double)drive);
+                                if (fc > 0.f) {
+                                    const double in = r;
+                                    r = in - x1[g][v] + R * y1[g][v];
+                                    x1[g][v] = in;
+                                    y1[g][v] = r;
+                                }
+                                maxDiff = std::max(maxDiff, std::fabs(y[g][v] - r));
+                                if (i >= kTotal - 3 * kRate / 8) zeros = zeros && y[g][v] == 0.f;
+                            }
+                        }
+                    }
+                    const bool fail = maxDiff > kBoundV || !zeros;
+                    ok = ok && !fail;
+                    std::printf("%-10s %-9s %7.1f %8.1f %12.3g %8s%s\n", kSchedules[(int)schedule],
+                                paired ? "paired" : "separate", drive, fc, maxDiff, zeros ? "ok" : "no", fail ? "  FAIL" : "");
+                }
+            }
+        }
+    }
+    std::printf("# bound: maxdiff < %.0e V; zeros = exact 0 in the last quarter of the silence\n", kBoundV);
+    return ok ? 0 : 1;
+}
+
+/*
+ Multi‑resolução (StftConfig::splitBand) face ao STFT único, N = 1024 a 48 kHz.
+  - Reconstrução: ruído com os efeitos em repouso (RAW), com e sem atalhos;
+    a saída split tem de ser a do caminho único atrasada de D (crossover).
+  - Pre‑echo: impulsos (0.2 × ±5 V) de 250 em 250 ms; energia da saída nos
+    N anteriores ao impulso alinhado (menos 1 ms) face à energia ±N à volta.
+  - Custo por amostra dos dois modos.
+*/
+int verifySplit() {
+    constexpr int kRate = 48000;
+    constexpr double kBound = 2e-5;                         // 1e−4 V (saída do run() em ±1)
+
+    bool ok = true;
+    StftConfig single, split;
+    split.splitBand = true;
+    const int N = SpectroEngine(single).fftSize();
+    const int D = SpectroEngine(split).latency() - SpectroEngine(single).latency();
+
+    // Reconstrução
+    const WavFile noise = makeSignal("noise", 2.0, kRate);
+    std::printf("# N=%d, fine N=%d, crossover %.0f Hz, D=%d\n", N, N / SpectroEngine::SPLIT_RATIO,
+                SpectroEngine::SPLIT_CROSSOVER_HZ, D);
+    std::printf("%-12s %12s\n", "fast paths", "maxdiff");
+    for (bool fastPaths : { false, true }) {
+        SpectroParams p = makeParams(0, 0, 0, 0.f);
+        p.fastPaths = fastPaths;
+        WavFile a, b;
+        run(noise, single, p, 64, 1, &a);
+        run(noise, split, p, 64, 1, &b);
+        double maxDiff = 0.0;
+        for (size_t i = (size_t)D; i < a.frames(); ++i)
+            for (int ch = 0; ch < 2; ++ch)
+                maxDiff = std::max(maxDiff, (double)std::fabs(b.data[2 * i + ch] - a.data[2 * (i - D) + ch]));
+        const bool fail = maxDiff > kBound;
+        ok = ok && !fail;
+        std::printf("%-12s %12.3g%s\n", fastPaths ? "on" : "off", maxDiff, fail ? "  FAIL" : "");
+    }
+
+    // Pre‑echo e custo
+    WavFile clicks;
+    clicks.sampleRate = kRate;
+    clicks.channels = 2;
+    clicks.data.assign((size_t)3 * kRate * 2, 0.f);
+    std::vector<size_t> at;
+    for (size_t i = kRate / 2; i + kRate / 4 <= (size_t)3 * kRate; i += kRate / 4) {
+        clicks.data[2 * i] = clicks.data[2 * i + 1] = 0.2f;
+        at.push_back(i);
+    }
+    auto preEcho = [&](const WavFile& out, int latency) {
+        double pre = 0.0, total = 0.0;
+        for (size_t t0 : at) {
+            const size_t c = t0 + latency;
+            for (size_t i = c - N; i < c + N && i < out.frames(); ++i) {
+                const double e = (double)out.data[2 * i] * out.data[2 * i];
+                total += e;
+                if (i + kRate / 1000 < c) pre += e;
+            }
+        }
+        return 10.0 * std::log10(std::max(pre, 1e-30) / std::max(total, 1e-30));
+    };
+    struct Case { int effect, phase; float amount; };
+    const Case cases[] = { { 1, 0, 0.5f }, { 0, 1, 0.f }, { 0, 2, 0.f }, { 1, 2, 0.5f } };
+    std::printf("%-8s %-7s %14s %14s %14s %14s\n", "effect", "phase", "pre-echo 1", "pre-echo split",
+                "ns/smp 1", "ns/smp split");
+    for (const Case& k : cases) {
+        const SpectroParams p = makeParams(k.effect, k.phase, 0, k.amount);
+        WavFile a, b;
+        const Result ra = run(clicks, single, p, 64, 1, &a);
+        const Result rb = run(clicks, split, p, 64, 1, &b);
+        const double ea = preEcho(a, SpectroEngine(single).latency()), eb = preEcho(b, SpectroEngine(split).latency());
+        const bool fail = eb >= ea;
+        ok = ok && !fail;
+        std::printf("%-8s %-7s %11.1f dB %11.1f dB %14.1f %14.1f%s\n", kEffects[k.effect], kPhases[k.phase], ea, eb,
+                    ra.rtf * 1e9 / kRate, rb.rtf * 1e9 / kRate, fail ? "  FAIL" : "");
+    }
+    std::printf("# bound: maxdiff < %.0e (= 1e-4 V); pre-echo (energy in the N samples before each click) must drop\n", kBound);
+    return ok ? 0 : 1;
+}
+
+/*
+ PhaseEngine face à versão anterior (ReferencePhase), N = 1024, H = 256.
+ Frames: DFT de 3 sinusoides fora do centro dos bins + ruído (−60 dB),
+ janela de Hann. Mono (C = 1) e 8 vozes com ganhos diferentes. Com H de
+ análise = H de síntese o PV só se afasta da análise por arredondamento, por
+ isso a coerência serve aqui de verificação do locking (φo[p±1] − φo[p] tem
+ de ser exatamente o da análise), não de comparação entre modos.
+  - RAW/PV: |Δ| relativo ao pico do frame (só arredondamento).
+  - PV_LOCK: erro de coerência |wrap(φo[k] − φo[p] − (φa[k] − φa[p]))| nos
+    vizinhos k = p±1 de cada pico p acima de −40 dB.
+  - ns por frame (por voz com C = 8).
+*/
+int verifyPhase() {
+    constexpr int N = 1024, K = N / 2 + 1, H = N / 4, F = 64, V = 8;
+    constexpr double kBound = 1e-4, kLockBound = 1e-3;
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> nd(0.f, 1.f);
+    std::vector<double> x((size_t)N + (size_t)H * F);
+    for (size_t n = 0; n < x.size(); ++n)
+        x[n] = std::sin(0.0577 * n) + 0.5 * std::sin(0.3313 * n + 1.0) + 0.25 * std::sin(1.207 * n + 2.0) + 1e-3 * nd(rng);
+    std::vector<double> cs(N), sn(N);
+    for (int i = 0; i < N; ++i) { cs[i] = std::cos(2.0 * M_PI * i / N); sn[i] = std::sin(2.0 * M_PI * i / N); }
+    std::vector<std::vector<float>> mag(F, std::vector<float>(K)), pha(F, std::vector<float>(K));
+    for (int f = 0; f < F; ++f) {
+        const double* xf = x.data() + (size_t)f * H;
+        for (int k = 0; k < K; ++k) {
+            double re = 0.0, im = 0.0;
+            for (int n = 0; n < N; ++n) {
+                const double w = 0.5 - 0.5 * cs[n], v = w * xf[n];
+                re += v * cs[(size_t)k * n % N];
+                im -= v * sn[(size_t)k * n % N];
+            }
+            mag[f][k] = (float)std::hypot(re, im);
+            pha[f][k] = (float)std::atan2(im, re);
+        }
+    }
+    auto wrapd = [](double a) { return a - 2.0 * M_PI * std::nearbyint(a / (2.0 * M_PI)); };
+
+    // [K][C] com ganhos por voz (mesma fase)
+    std::vector<std::vector<float>> magPoly(F, std::vector<float>(K * V)), phaPoly(F, std::vector<float>(K * V));
+    for (int f = 0; f < F; ++f)
+        for (int k = 0; k < K; ++k)
+            for (int c = 0; c < V; ++c) { magPoly[f][k * V + c] = mag[f][k] * (1.f - c / 32.f); phaPoly[f][k * V + c] = pha[f][k]; }
+
+    bool ok = true;
+    std::vector<float> re(K * V), im(K * V), rre(K * V), rim(K * V);
+    std::printf("%-7s %12s %12s %12s %12s %12s %14s\n", "mode", "maxdiff/pk", "coh ref", "coh new",
+                "ns/frame ref", "ns/frame new", "ns/voice C=8");
+    for (int m = 0; m < 3; ++m) {
+        const PhaseEngine::Mode mode = PhaseEngine::Mode(m);
+        PhaseEngine pe;
+        ReferencePhase ref;
+        pe.setup(V, K, H);
+        ref.setup(1, K, H);
+        double diff = 0.0, cohRef = 0.0, cohNew = 0.0;
+        for (int f = 0; f < F; ++f) {
+            pe.processFrame(mode, 1, mag[f].data(), pha[f].data(), re.data(), im.data());
+            ref.processFrame(mode, mag[f].data(), pha[f].data(), rre.data(), rim.data());
+            const float peak = *std::max_element(mag[f].begin(), mag[f].end());
+            if (mode != PhaseEngine::Mode::PV_LOCK)
+                for (int k = 0; k < K; ++k)
+                    diff = std::max(diff, (double)std::hypot(re[k] - rre[k], im[k] - rim[k]) / peak);
+            if (f < 4) continue;                                        // PV ainda a convergir
+            for (int p = 1; p < K - 1; ++p) {
+                if (!(mag[f][p] > 0.01f * peak && mag[f][p] > mag[f][p - 1] && mag[f][p] >= mag[f][p + 1])) continue;
+                for (int k : { p - 1, p + 1 }) {
+                    const double da = pha[f][k] - pha[f][p];
+                    cohNew = std::max(cohNew, std::fabs(wrapd(std::atan2(im[k], re[k]) - std::atan2(im[p], re[p]) - da)));
+                    cohRef = std::max(cohRef, std::fabs(wrapd(std::atan2(rim[k], rre[k]) - std::atan2(rim[p], rre[p]) - da)));
+                }
+            }
+        }
+        const bool fail = diff > kBound || (mode == PhaseEngine::Mode::PV_LOCK && cohNew > kLockBound);
+        ok = ok && !fail;
+
+        // Custo: 16 passagens pelos F frames
+        Timing tRef, tNew, tPoly;
+        ReferencePhase refPoly;
+        for (int pass = 0; pass < 16; ++pass)
+            for (int f = 0; f < F; ++f) {
+                auto t0 = Clock::now();
+                ref.processFrame(mode, mag[f].data(), pha[f].data(), rre.data(), rim.data());
+                auto t1 = Clock::now();
+                pe.processFrame(mode, 1, mag[f].data(), pha[f].data(), re.data(), im.data());
+                auto t2 = Clock::now();
+                tRef.add((double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+                tNew.add((double)std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count());
+            }
+        for (int pass = 0; pass < 16; ++pass)
+            for (int f = 0; f < F; ++f) {
+                auto t0 = Clock::now();
+                pe.processFrame(mode, V, magPoly[f].data(), phaPoly[f].data(), re.data(), im.data());
+                tPoly.add((double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count() / V);
+            }
+        std::printf("%-7s %12.3g %12.3g %12.3g %12.0f %12.0f %14.0f%s\n", kPhases[m],
+                    mode == PhaseEngine::Mode::PV_LOCK ? 0.0 : diff, cohRef, cohNew,
+                    tRef.mean(), tNew.mean(), tPoly.mean(), fail ? "  FAIL" : "");
+    }
+    std::printf("# bounds: maxdiff/peak < %.0e (raw, pv); pvlock coherence < %.0e rad (coh = worst phase error at peak±1)\n",
+                kBound, kLockBound);
+    return ok ? 0 : 1;
+}
+
+/*
+ PGHI face aos outros modos de fase. STFT/ISTFT offline (radix in‑tree,
+ √Hann, N = 1024, a mesma normalização do OLA do motor) de 2 s a 48 kHz:
+ tom harmónico com vibrato + cliques de 300 em 300 ms + ruído a −60 dB.
+ Magnitude pedida M = SpectralFX sobre a da análise; fase de cada modo;
+ consistência = 20·log10(‖|STFT(y)| − M‖ / ‖M‖) nos frames interiores.
+ Sem efeito ("none") RAW/PV/PV_LOCK têm a fase verdadeira e o PGHI só a
+ magnitude: fica como referência do que o PGHI consegue sozinho; o critério
+ é a média dos casos com efeito.
+ Custo: ns por frame de 1 voz e por voz com 16 vozes; orçamento = 2 lados ×
+ 16 vozes × média por voz < 50 % do período do hop a 4× (5.3 ms).
+*/
+int verifyPghi() {
+    using F = Fftw<double>;
+    constexpr int kRate = 48000, N = 1024, K = N / 2 + 1, KP = (K + 7) & ~7;
+    constexpr size_t kLen = 2 * kRate;
+
+    std::mt19937 rng(5);
+    std::normal_distribution<double> nd(0.0, 1.0);
+    std::vector<double> x(kLen);
+    double ph = 0.0;
+    for (size_t n = 0; n < kLen; ++n) {
+        const double f0 = 220.0 * (1.0 + 0.02 * std::sin(2 * M_PI * 5.0 * n / kRate));
+        ph += 2 * M_PI * f0 / kRate;
+        for (int h = 1; h <= 8; ++h) x[n] += std::sin(h * ph) / h;
+        x[n] = 0.3 * x[n] + 1e-3 * nd(rng) + ((n % (kRate * 3 / 10)) == kRate / 10 ? 1.0 : 0.0);
+    }
+
+    auto fft = FFTBackend::create<double>(FFTBackend::Kind::RADIX, N, KP);
+    double* frame = F::allocReal(N);
+    F::Complex* spec = F::allocComplex(KP);
+    std::vector<double> win(N);
+    for (int i = 0; i < N; ++i) win[i] = std::sqrt(0.5 * (1 - std::cos(2 * M_PI * i / N)));
+
+    // |X| e fase por frame ([F][K]) de um sinal com hop H
+    auto analyze = [&](const std::vector<double>& sig, int H, std::vector<float>& mag, std::vector<float>* phase) {
+        const int frames = (int)((sig.size() - N) / H) + 1;
+        mag.assign((size_t)frames * K, 0.f);
+        if (phase) phase->assign((size_t)frames * K, 0.f);
+        for (int f = 0; f < frames; ++f) {
+            for (int i = 0; i < N; ++i) frame[i] = win[i] * sig[(size_t)f * H + i];
+            fft->forward(frame, spec, 1);
+            for (int k = 0; k < K; ++k) {
+                mag[(size_t)f * K + k] = (float)std::hypot(spec[k][0], spec[k][1]);
+                if (phase) (*phase)[(size_t)f * K + k] = (float)std::atan2(spec[k][1], spec[k][0]);
+            }
+        }
+        return frames;
+    };
+
+    struct Case { const char* name; FXParams p; };
+    Case cases[4] = { { "none", {} }, { "stretch", {} }, { "blur", {} }, { "mirror", {} } };
+    cases[1].p.stretch = 0.75f;
+    cases[2].p.blur = 0.5f;
+    cases[3].p.mirror = 0.5f;
+
+    bool ok = true;
+    SpectralFX fx;
+    fx.setup(K);
+    const std::vector<float> ones(K, 1.f);
+    std::vector<float> re(K), im(K);
+    std::printf("%-8s %-8s %10s %10s %10s %10s\n", "overlap", "effect", "raw", "pv", "pvlock", "pghi");
+    for (int ov : { 2, 4 }) {
+        double meanLock = 0.0, meanPghi = 0.0;
+        const int H = N / ov;
+        const double olaScale = 2.0 / ((double)N * ov);
+        std::vector<float> magA, phaseA;
+        const int frames = analyze(x, H, magA, &phaseA);
+        for (const Case& cs : cases) {
+            std::vector<float> target((size_t)frames * K);
+            for (int f = 0; f < frames; ++f)
+                fx.process(&magA[(size_t)f * K], &target[(size_t)f * K], cs.p, ones.data());
+            double sc[4];
+            for (int m = 0; m < 4; ++m) {
+                PhaseEngine pe;
+                pe.setup(1, K, H);
+                std::vector<double> y(kLen, 0.0);
+                for (int f = 0; f < frames; ++f) {
+                    pe.processFrame(PhaseEngine::Mode(m), 1, &target[(size_t)f * K], &phaseA[(size_t)f * K], re.data(), im.data());
+                    for (int k = 0; k < K; ++k) { spec[k][0] = re[k]; spec[k][1] = im[k]; }
+                    fft->inverse(spec, frame, 1);
+                    for (int i = 0; i < N; ++i) y[(size_t)f * H + i] += win[i] * frame[i] * olaScale;
+                }
+                std::vector<float> magY;
+                analyze(y, H, magY, nullptr);
+                double num = 0.0, den = 0.0;
+                for (size_t i = (size_t)ov * K; i < (size_t)(frames - ov) * K; ++i) {
+                    num += ((double)magY[i] - target[i]) * ((double)magY[i] - target[i]);
+                    den += (double)target[i] * target[i];
+                }
+                sc[m] = 10.0 * std::log10(std::max(num, 1e-300) / den);
+            }
+            if (&cs != &cases[0]) { meanLock += sc[2] / 3; meanPghi += sc[3] / 3; }
+            std::printf("%-8d %-8s %7.1f dB %7.1f dB %7.1f dB %7.1f dB\n", ov, cs.name, sc[0], sc[1], sc[2], sc[3]);
+        }
+        const bool fail = meanPghi > meanLock;
+        ok = ok && !fail;
+        std::printf("%-8d %-8s %10s %10s %7.1f dB %7.1f dB%s\n", ov, "mean fx", "", "", meanLock, meanPghi, fail ? "  FAIL" : "");
+    }
+
+    // Custo por frame (sinal a 4×), 1 voz e 16 vozes em [K][C]
+    constexpr int V = SpectroEngine::MAX_VOICES, H = N / 4;
+    std::vector<float> magA, phaseA;
+    const int frames = analyze(x, H, magA, &phaseA);
+    std::vector<float> magPoly(K * V), phasePoly(K * V), rePoly(K * V), imPoly(K * V);
+    std::printf("%-7s %14s %14s %16s\n", "mode", "ns/frame", "max ns/frame", "ns/voice C=16");
+    double pghiPerVoice = 0.0;
+    for (int m = 0; m < 4; ++m) {
+        PhaseEngine pe;
+        pe.setup(V, K, H);
+        Timing t, tPoly;
+        for (int f = 0; f < frames; ++f) {
+            auto t0 = Clock::now();
+            pe.processFrame(PhaseEngine::Mode(m), 1, &magA[(size_t)f * K], &phaseA[(size_t)f * K], re.data(), im.data());
+            t.add((double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+        }
+        for (int f = 0; f < frames; ++f) {
+            for (int k = 0; k < K; ++k)
+                for (int c = 0; c < V; ++c) {
+                    magPoly[k * V + c]   = magA[(size_t)f * K + k] * (1.f - c / 32.f);
+                    phasePoly[k * V + c] = phaseA[(size_t)f * K + k];
+                }
+            auto t0 = Clock::now();
+            pe.processFrame(PhaseEngine::Mode(m), V, magPoly.data(), phasePoly.data(), rePoly.data(), imPoly.data());
+            tPoly.add((double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count() / V);
+        }
+        if (m == 3) pghiPerVoice = tPoly.mean();
+        std::printf("%-7s %14.0f %14.0f %16.0f\n", kPhases[m], t.mean(), t.max, tPoly.mean());
+    }
+    const double hopNs = 1e9 * H / kRate, load = 2.0 * V * pghiPerVoice / hopNs;
+    const bool slow = load > 0.5;
+    ok = ok && !slow;
+    std::printf("# pghi, 2 sides x %d voices: %.1f%% of the %.2f ms hop (budget 50%%)%s\n", V, 100.0 * load, hopNs * 1e-6,
+                slow ? "  FAIL" : "");
+    F::free(frame);
+    F::free(spec);
+    return ok ? 0 : 1;
+}
+
+/*
+ Instrumentação ao vivo (HotPathStats). Histogramas: cada valor cai no seu
+ balde e p50/p99 de uma janela (View) ficam dentro do erro de um balde
+ (12.5%) dos percentis exatos. Com SPECTROFX_PROFILE (make PROFILE=1),
+ também o motor: nº de hops e amostras medidos face a hopCount(), trace
+ completo e gravado em JSON, e custo de um Scope face ao de um hop.
+*/
+int verifyStats() {
+    bool ok = true;
+    HotPathStats stats;
+    HotPathStats::Histogram& h = stats.histogram(HotPathStats::SAMPLE);
+
+    // Baldes: low ≤ v < low + width
+    std::mt19937_64 rng(20);
+    int badBucket = 0;
+    for (int i = 0; i < 200000; ++i) {
+        const uint64_t v = rng() >> (rng() % 64);
+        const int b = HotPathStats::Histogram::bucketOf(v);
+        const double lo = HotPathStats::Histogram::bucketLow(b), w = HotPathStats::Histogram::bucketWidth(b);
+        badBucket += !(b >= 0 && b < HotPathStats::Histogram::BUCKETS && lo <= (double)v && (double)v < lo + w);
+    }
+    std::printf("buckets: %d misplaced of 200000%s\n", badBucket, badBucket ? "  FAIL" : "");
+    ok = ok && !badBucket;
+
+    // Percentis de uma janela (log‑normal, ~1..100 µs em ticks)
+    HotPathStats::View view;
+    view.budgetNs[HotPathStats::SAMPLE] = 1e300;
+    view.update(stats, 0.0);
+    std::lognormal_distribution<double> ln(std::log(5000.0), 1.0);
+    std::vector<uint64_t> values(100000);
+    for (uint64_t& v : values) { v = (uint64_t)ln(rng); h.add(v); }
+    view.update(stats, 0.0);
+    std::sort(values.begin(), values.end());
+    const double tick = stats.nsPerTick();
+    const HotPathStats::View::Row& r = view.rows[HotPathStats::SAMPLE];
+    const double p50 = values[values.size() / 2], p99 = values[values.size() * 99 / 100], mx = values.back();
+    const double e50 = std::fabs(r.p50 / tick / p50 - 1.0), e99 = std::fabs(r.p99 / tick / p99 - 1.0), eMax = std::fabs(r.max / tick / mx - 1.0);
+    const bool badPct = r.count != values.size() || e50 > 0.125 || e99 > 0.125 || eMax > 1e-2;   // máx: só a calibração (nsPerTick) muda
+    std::printf("window: %llu events, p50 err %.1f%%, p99 err %.1f%%, max err %.1g%s\n", (unsigned long long)r.count,
+                100 * e50, 100 * e99, eMax, badPct ? "  FAIL" : "");
+    ok = ok && !badPct;
+
+    // Custo de um Scope (2 leituras do relógio + histograma + hop)
+    constexpr int kScopes = 1000000;
+    const auto t0 = Clock::now();
+    for (int i = 0; i < kScopes; ++i) { HotPathStats::Scope s(stats, i % 7, i & 1); }
+    const double scopeNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / kScopes;
+    std::printf("scope: %.1f ns (8 per hop and side incl. process())\n", scopeNs);
+
+#if SPECTROFX_PROFILE
+    // Motor: 2 s de ruído com PV, 1 voz, sem atalhos
+    StftConfig cfg;
+    auto engine = std::make_unique<SpectroEngine>(cfg);
+    SpectroParams p = makeParams(1, 1, 0, 0.5f);
+    p.fastPaths = false;
+    engine->setParams(p);
+    HotPathStats& es = engine->stats();
+    es.clear();
+    HotPathStats::View ev;
+    ev.update(es, 0.0);
+    es.armCapture(20000);
+    std::uniform_real_distribution<float> uni(-kVolts, kVolts);
+    constexpr int kFrames = 2 * 48000;
+    for (int i = 0; i < kFrames; ++i) {
+        float xl = uni(rng), xr = uni(rng), yl, yr;
+        HotPathStats::Scope sample(es, HotPathStats::SAMPLE, 0);       // como SpectroFXModule::process()
+        engine->processFrame(&xl, &xr, &yl, &yr);
+    }
+    ev.update(es, 0.0);
+    const uint64_t hops = ev.rows[HotPathStats::HOP].count, samples = ev.rows[HotPathStats::SAMPLE].count;
+    const bool badCount = hops != engine->hopCount() || samples != (uint64_t)kFrames
+                       || ev.rows[HotPathStats::FFT].count != hops;
+    std::printf("engine: %llu hops (hopCount %llu), %llu samples; hop p50 %.1f p99 %.1f max %.1f us, sample max %.1f us%s\n",
+                (unsigned long long)hops, (unsigned long long)engine->hopCount(), (unsigned long long)samples,
+                ev.rows[HotPathStats::HOP].p50 * 1e-3, ev.rows[HotPathStats::HOP].p99 * 1e-3, ev.rows[HotPathStats::HOP].max * 1e-3,
+                ev.rows[HotPathStats::SAMPLE].max * 1e-3, badCount ? "  FAIL" : "");
+    ok = ok && !badCount;
+    std::printf("scope cost: %.2f%% of a hop\n", 100.0 * 8 * scopeNs / std::max(ev.rows[HotPathStats::HOP].p50, 1.0));
+
+    const std::string path = "spectrofx-trace-test.json";
+    std::string err;
+    const bool wrote = es.captureDone() && es.writeChromeTrace(path, &err);
+    int events = 0;
+    if (FILE* f = std::fopen(path.c_str(), "r")) {
+        char line[256];
+        while (std::fgets(line, sizeof line, f)) events += std::strstr(line, "\"ph\":\"X\"") != nullptr;
+        std::fclose(f);
+        std::remove(path.c_str());
+    }
+    std::printf("trace: %d events written%s%s\n", events, err.empty() ? "" : (" (" + err + ")").c_str(),
+                wrote && events == 20000 ? "" : "  FAIL");
+    ok = ok && wrote && events == 20000;
+#else
+    std::printf("engine: not instrumented (build with PROFILE=1)\n");
+#endif
+    return ok ? 0 : 1;
+}
+
+/*
+ Render offline em lote (BatchRenderer) face a um motor estéreo por par de
+ canais (o canal ímpar que sobra vai para L de um motor com R em silêncio),
+ com o mesmo preset, a latência compensada e o WAV lido por WavFile.
+ Dois ficheiros (3 canais PCM 16 bits a 48 kHz, estéreo float a 96 kHz),
+ 1 e 4 threads, blocos de tamanho "torto" e janela de 2 blocos (os grupos
+ estacionam e são reagendados). Backend radix: resultado determinístico.
+*/
+int verifyRender() {
+    namespace fs = std::filesystem;
+    constexpr double kBound = 1e-6;
+    const fs::path dir = fs::temp_directory_path() / ("spectrofx-render-" + std::to_string((long long)Clock::now().time_since_epoch().count()));
+    fs::create_directories(dir / "in");
+
+    // Entradas: makeSignal() em canais, com ganhos diferentes
+    struct Source { const char* name; int rate, channels; double seconds; bool pcm16; };
+    const Source sources[] = { { "a.wav", 48000, 3, 2.5, true }, { "b.wav", 96000, 2, 1.0, false } };
+    const char* const signals[] = { "noise", "sweep", "sine" };
+    std::vector<std::string> inputs, outputs;
+    for (const Source& src : sources) {
+        WavFile w;
+        w.sampleRate = src.rate;
+        w.channels = src.channels;
+        w.data.resize((size_t)(src.seconds * src.rate) * src.channels);
+        for (int c = 0; c < src.channels; ++c) {
+            const WavFile m = makeSignal(signals[c % 3], src.seconds, src.rate);
+            for (size_t i = 0; i < w.frames(); ++i) w.data[i * src.channels + c] = m.data[2 * i] * (1.f - 0.2f * c);
+        }
+        const std::string path = (dir / "in" / src.name).string();
+        if (src.pcm16) {
+            // WavFile só grava float: PCM 16 bits à mão
+            FILE* f = std::fopen(path.c_str(), "wb");
+            const uint32_t bytes = (uint32_t)w.data.size() * 2, riff = 36 + bytes, fmtSize = 16;
+            const uint32_t rate = (uint32_t)src.rate, byteRate = rate * 2 * src.channels;
+            const uint16_t tag = 1, ch = (uint16_t)src.channels, align = (uint16_t)(2 * src.channels), bits = 16;
+            std::fwrite("RIFF", 1, 4, f); std::fwrite(&riff, 4, 1, f); std::fwrite("WAVE", 1, 4, f);
+            std::fwrite("fmt ", 1, 4, f); std::fwrite(&fmtSize, 4, 1, f);
+            std::fwrite(&tag, 2, 1, f); std::fwrite(&ch, 2, 1, f); std::fwrite(&rate, 4, 1, f);
+            std::fwrite(&byteRate, 4, 1, f); std::fwrite(&align, 2, 1, f); std::fwrite(&bits, 2, 1, f);
+            std::fwrite("data", 1, 4, f); std::fwrite(&bytes, 4, 1, f);
+            for (float x : w.data) {
+                const int16_t v = (int16_t)std::clamp(std::lround(x * 32767.0), -32768L, 32767L);
+                std::fwrite(&v, 2, 1, f);
+            }
+            std::fclose(f);
+        } else {
+            w.save(path);
+        }
+        inputs.push_back(path);
+    }
+
+    BatchRenderer::Options opt;
+    const char* const preset[][2] = {
+        { "blur", "0.4" }, { "gate.R", "0.3" }, { "stretch.L", "0.6" }, { "phase", "pvlock" }, { "backend", "radix" },
+        { "mask.band", "100 12000" }, { "mask.weight", "0 1  4000 0.3  16000 1" },
+    };
+    for (const auto& kv : preset) opt.preset.set(kv[0], kv[1]);
+
+    // Referência: motor estéreo por par de canais, bloco a bloco
+    std::vector<WavFile> expected;
+    for (const std::string& path : inputs) {
+        WavFile in, out;
+        in.load(path);
+        out.sampleRate = in.sampleRate;
+        out.channels = in.channels;
+        out.data.assign(in.data.size(), 0.f);
+        StftConfig cfg = opt.preset.stft;
+        cfg.sampleRate = (float)in.sampleRate;
+        for (int c0 = 0; c0 < in.channels; c0 += 2) {
+            SpectroEngine e(cfg);
+            e.setParams(opt.preset.params);
+            opt.preset.applyMask(e, cfg.sampleRate);
+            const int L = e.latency();
+            const bool pair = c0 + 1 < in.channels;
+            for (size_t t = 0; t < in.frames() + L; ++t) {
+                const bool inside = t < in.frames();
+                const float x[2] = { inside ? kVolts * in.data[t * in.channels + c0] : 0.f,
+                                     inside && pair ? kVolts * in.data[t * in.channels + c0 + 1] : 0.f };
+                float y[2];
+                e.processSample(x, y);
+                if (t < (size_t)L) continue;
+                out.data[(t - L) * in.channels + c0] = y[0] / kVolts;
+                if (pair) out.data[(t - L) * in.channels + c0 + 1] = y[1] / kVolts;
+            }
+        }
+        expected.push_back(std::move(out));
+    }
+
+    bool ok = true;
+    struct Run { int threads, chunk, window; };
+    const Run runs[] = { { 1, 1 << 16, 4 }, { 4, 1000, 2 }, { 4, 333, 2 } };
+    std::printf("%-8s %-7s %-7s %12s %14s\n", "threads", "chunk", "window", "maxdiff", "ch-s / s");
+    for (const Run& r : runs) {
+        opt.threads = r.threads;
+        opt.chunk = r.chunk;
+        opt.window = r.window;
+        outputs.clear();
+        for (const Source& src : sources) outputs.push_back((dir / ("out-" + std::to_string(r.chunk) + "-" + src.name)).string());
+        BatchRenderer renderer(opt);
+        const auto t0 = Clock::now();
+        const std::vector<BatchRenderer::FileResult> results = renderer.run(inputs, outputs);
+        const double wall = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        double maxDiff = 0.0, audio = 0.0;
+        bool fail = false;
+        for (size_t f = 0; f < results.size(); ++f) {
+            WavFile got;
+            if (!results[f].error.empty() || !got.load(outputs[f]) || got.channels != expected[f].channels
+                || got.sampleRate != expected[f].sampleRate || got.data.size() != expected[f].data.size()) {
+                std::printf("# %s: %s\n", outputs[f].c_str(), results[f].error.empty() ? "wrong output format" : results[f].error.c_str());
+                fail = true;
+                continue;
+            }
+            for (size_t i = 0; i < got.data.size(); ++i)
+                maxDiff = std::max(maxDiff, (double)std::fabs(got.data[i] - expected[f].data[i]));
+            audio += (double)got.frames() * got.channels / got.sampleRate;
+        }
+        fail = fail || maxDiff > kBound;
+        ok = ok && !fail;
+        std::printf("%-8d %-7d %-7d %12.3g %14.1f%s\n", r.threads, r.chunk, r.window, maxDiff, audio / wall, fail ? "  FAIL" : "");
+    }
+    std::printf("# bound: maxdiff <= %.0e; ch-s / s = channel-seconds rendered per wall second\n", kBound);
+    fs::remove_all(dir);
+    return ok ? 0 : 1;
+}
+
+/*
+ Teste de carga (--load): M instâncias do DSP do módulo (SpectroEngine +
+ leitura de knobs/CV como SpectroFXModule::process()) em T threads, como o
+ motor do Rack: a cada amostra os threads tiram instâncias de um contador
+ atómico até se esgotarem e esperam uns pelos outros numa barreira (spin e
+ depois yield). Cada bloco de --block amostras tem o prazo block/fs; um
+ bloco que demore mais conta como falha. Os primeiros 0.25 s (caches,
+ planos) não contam.
+
+ Cenários (instâncias com parâmetros aleatórios, semente fixa):
+    - static : knobs fixos, modo de fase aleatório
+    - lfo    : knobs modulados por CV (LFO triangular 0.05–2 Hz por knob)
+    - random : saltos de knobs a cada ~0.5 s e troca de modo de fase
+    - mask   : lfo + um thread de UI a pintar e publicar a máscara de
+               todas as instâncias a 60 Hz
+    - worst  : todos os efeitos a 1, PGHI e máscara
+ Cada instância lê a entrada (WAV ou sinal) desfasada e com --voices vozes.
+
+ Com --load M corre só M instâncias; com --load auto procura o maior M com
+ taxa de falhas ≤ --max-miss % (0.1 por omissão): duplica M até falhar e
+ depois bissecta.
+*/
+struct LoadResult {
+    double missRate = 0.0;                  // blocos fora do prazo / blocos
+    double p99 = 0.0, worst = 0.0;          // tempo de bloco / prazo
+    std::vector<double> util;               // por thread: tempo a processar / tempo disponível
+    size_t blocks = 0;
+};
+
+// Barreira reutilizável: sentido alternado, espera ativa curta e depois yield
+class LoadBarrier {
+public:
+    explicit LoadBarrier(int n) : count(n) {}
+    void wait() {
+        const uint32_t gen = generation.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            arrived.store(0, std::memory_order_relaxed);
+            generation.store(gen + 1, std::memory_order_release);
+            return;
+        }
+        for (int spin = 0; generation.load(std::memory_order_acquire) == gen; ++spin)
+            if (spin > 64) std::this_thread::yield();
+    }
+private:
+    const int count;
+    std::atomic<int> arrived { 0 };
+    std::atomic<uint32_t> generation { 0 };
+};
+
+const char* const kLoadScenarios[] = { "static", "lfo", "random", "mask", "worst" };
+
+// Uma instância: motor + "patch" (knobs, CV, modo de fase) do cenário
+struct LoadInstance {
+    std::unique_ptr<SpectroEngine> engine;
+    float knob[2][7] = {}, depth[2][7] = {};
+    float lfo[7] = {}, lfoInc[7] = {};      // fase ∈ [0, 1) e incremento por amostra
+    int phaseMode = 0;
+    size_t offset = 0;                      // desfasamento na entrada
+    uint64_t nextJump = 0;                  // random: próxima mudança (amostra)
+    std::mt19937 rng;
+
+    // Como SpectroFXModule::readParams(): clamp(knob + 0.1·CV), CV = LFO ±10 V·depth
+    SpectroParams params(int scenario, uint64_t t, float rate, HopSchedule schedule) {
+        if (scenario == 2 && t >= nextJump) {
+            std::uniform_real_distribution<float> u(0.f, 1.f);
+            for (auto& side : knob) for (float& k : side) k = u(rng) < 0.5f ? 0.f : u(rng);
+            if (u(rng) < 0.3f) phaseMode = (int)(u(rng) * 4) & 3;
+            nextJump = t + (uint64_t)((0.25f + 0.5f * u(rng)) * rate);
+        }
+        SpectroParams p;
+        float cv[7] = {};
+        if (scenario == 1 || scenario == 3) {
+            for (int e = 0; e < 7; ++e) {
+                lfo[e] += lfoInc[e];
+                if (lfo[e] >= 1.f) lfo[e] -= 1.f;
+                cv[e] = 4.f * std::fabs(lfo[e] - 0.5f) - 1.f;       // triangular ±1
+            }
+        }
+        for (int ch = 0; ch < 2; ++ch) {
+            float v[7];
+            for (int e = 0; e < 7; ++e) v[e] = std::clamp(knob[ch][e] + depth[ch][e] * cv[e], 0.f, 1.f);
+            FXParams& c = p.ch[ch];
+            c.blur = v[0]; c.sharpen = v[1]; c.edge = v[2]; c.emboss = v[3];
+            c.mirror = v[4]; c.gate = v[5]; c.stretch = v[6];
+        }
+        p.phaseMode = PhaseEngine::Mode((uint8_t)phaseMode);
+        p.schedule = schedule;
+        return p;
+    }
+};
+
+LoadResult runLoad(const WavFile& in, const StftConfig& cfg, int scenario, int M, int T, int block, int voices,
+                   double seconds, HopSchedule schedule) {
+    const float rate = (float)in.sampleRate;
+    std::vector<LoadInstance> inst(M);
+    std::mt19937 rng(21);
+    std::uniform_real_distribution<float> u(0.f, 1.f);
+    for (LoadInstance& x : inst) {
+        x.engine = std::make_unique<SpectroEngine>(cfg);
+        x.engine->setChannels(voices, voices);
+        x.rng.seed(rng());
+        x.offset = (size_t)(u(rng) * in.frames());
+        x.phaseMode = scenario == 4 ? 3 : (int)(u(rng) * 4) & 3;
+        for (int ch = 0; ch < 2; ++ch)
+            for (int e = 0; e < 7; ++e) {
+                const bool on = scenario == 4 || u(rng) < 0.4f;            // ~3 efeitos ligados por lado
+                x.knob[ch][e] = scenario == 4 ? 1.f : e == 6 ? (on ? u(rng) : 0.5f) : (on ? u(rng) : 0.f);
+                x.depth[ch][e] = (scenario == 1 || scenario == 3) && on ? 0.5f * u(rng) : 0.f;
+            }
+        for (int e = 0; e < 7; ++e) x.lfoInc[e] = (0.05f + 1.95f * u(rng)) / rate;
+    }
+
+    // UI: pinceladas aleatórias em todas as máscaras, publicadas a 60 Hz
+    std::atomic<bool> stop { false };
+    std::thread ui;
+    if (scenario >= 3) {
+        ui = std::thread([&] {
+            std::mt19937 r(7);
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (LoadInstance& x : inst) {
+                    Mask2D& m = x.engine->mask();
+                    const int k0 = (int)(r() % (unsigned)m.K), col = (int)(r() % (unsigned)m.HIST);
+                    m.paint(col, k0, k0 + 24, (r() & 1) ? 1.f : 0.f, [&](int k) { return 1.f - (float)std::abs(k - k0 - 12) / 12.f; });
+                    m.publish();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(16));
+            }
+        });
+    }
+
+    const size_t frames = (size_t)(seconds * rate), warmup = (size_t)(0.25 * rate);
+    const size_t blocks = frames / block;
+    const double budgetNs = 1e9 * block / rate;
+    const int chIn = in.channels;
+    std::atomic<uint64_t> next { 0 };
+    LoadBarrier barrier(T);
+    std::vector<double> busy(T, 0.0);       // ns a processar, depois do aquecimento
+    std::vector<double> blockNs;
+    blockNs.reserve(blocks);
+
+    auto worker = [&](int id) {
+        double mine = 0.0;
+        Clock::time_point blockStart;
+        for (size_t b = 0; b < blocks; ++b) {
+            if (id == 0) blockStart = Clock::now();
+            for (int f = 0; f < block; ++f) {
+                const uint64_t t = (uint64_t)b * block + f;
+                const uint64_t base = t * (uint64_t)(M + T), end = base + M;    // cada thread gasta 1 índice a mais por amostra
+                const auto t0 = Clock::now();
+                for (uint64_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < end; ) {
+                    LoadInstance& x = inst[i - base];
+                    const float* s = &in.data[((t + x.offset) % in.frames()) * chIn];
+                    float xl[SpectroEngine::MAX_VOICES], xr[SpectroEngine::MAX_VOICES];
+                    float yl[SpectroEngine::MAX_VOICES], yr[SpectroEngine::MAX_VOICES];
+                    for (int v = 0; v < voices; ++v) {
+                        xl[v] = kVolts * (1.f - v / 32.f) * s[0];
+                        xr[v] = kVolts * (1.f - v / 32.f) * s[chIn > 1 ? 1 : 0];
+                    }
+                    x.engine->setParams(x.params(scenario, t, rate, schedule));
+                    x.engine->processFrame(xl, xr, yl, yr);
+                }
+                if (t >= warmup) mine += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+                barrier.wait();
+            }
+            if (id == 0 && (size_t)(b + 1) * block > warmup)
+                blockNs.push_back(std::chrono::duration<double, std::nano>(Clock::now() - blockStart).count());
+        }
+        busy[id] = mine;
+    };
+    std::vector<std::thread> threads;
+    for (int id = 1; id < T; ++id) threads.emplace_back(worker, id);
+    worker(0);
+    for (std::thread& th : threads) th.join();
+    stop.store(true);
+    if (ui.joinable()) ui.join();
+
+    LoadResult r;
+    r.blocks = blockNs.size();
+    if (!r.blocks) return r;
+    size_t misses = 0;
+    for (double ns : blockNs) misses += ns > budgetNs;
+    r.missRate = (double)misses / r.blocks;
+    r.worst = *std::max_element(blockNs.begin(), blockNs.end()) / budgetNs;
+    auto nth = blockNs.begin() + (ptrdiff_t)((r.blocks - 1) * 99 / 100);
+    std::nth_element(blockNs.begin(), nth, blockNs.end());
+    r.p99 = *nth / budgetNs;
+    for (double ns : busy) r.util.push_back(ns / (r.blocks * budgetNs));
+    return r;
+}
+
+int loadTest(const WavFile& in, const StftConfig& cfg, const std::vector<int>& scenarios, int count, int threads,
+             int block, int voices, double seconds, double maxMiss, HopSchedule schedule) {
+    std::printf("%-8s %6s %4s %8s %8s %8s %8s %10s\n", "scenario", "rate", "M", "miss%", "p99", "worst", "util", "util-max");
+    auto report = [&](int sc, int M, const LoadResult& r) {
+        double mean = 0.0, mx = 0.0;
+        for (double x : r.util) { mean += x / r.util.size(); mx = std::max(mx, x); }
+        std::printf("%-8s %6d %4d %8.3f %8.2f %8.2f %7.1f%% %9.1f%%\n", kLoadScenarios[sc], in.sampleRate, M,
+                    100.0 * r.missRate, r.p99, r.worst, 100.0 * mean, 100.0 * mx);
+        std::fflush(stdout);
+        return r.missRate * 100.0 <= maxMiss;
+    };
+    for (int sc : scenarios) {
+        if (count > 0) {
+            report(sc, count, runLoad(in, cfg, sc, count, threads, block, voices, seconds, schedule));
+            continue;
+        }
+        // Maior M sustentável: duplica até falhar, depois bissecta entre o último bom e o primeiro mau.
+        // Uma falha só conta se se repetir (um bloco atrasado pelo SO não decide a procura).
+        auto sustains = [&](int M) {
+            return report(sc, M, runLoad(in, cfg, sc, M, threads, block, voices, seconds, schedule))
+                || report(sc, M, runLoad(in, cfg, sc, M, threads, block, voices, seconds, schedule));
+        };
+        int good = 0, bad = 0;
+        for (int M = 1; !bad && M <= 4096; M *= 2) (sustains(M) ? good : bad) = M;
+        while (bad - good > 1) {
+            const int M = (good + bad) / 2;
+            (sustains(M) ? good : bad) = M;
+        }
+        std::printf("# %s @ %d Hz: max sustainable %d instance(s) on %d thread(s) (miss <= %.2f%%)\n",
+                    kLoadScenarios[sc], in.sampleRate, good, threads, maxMiss);
+    }
+    return 0;
+}
+
+/*
+ Micro‑benchmark por estágio (--kernels): SpectroEngine::profileStages() em
+ N ∈ {256, 1024, 4096} × vozes por lado ∈ {1, 4, 16}, sem atalhos e com o
+ motor já cheio de ruído. Linhas (ns por hop de L, todas as vozes):
+    - window, fft, analyze, ifft, ola, output : com efeitos em repouso e RAW
+    - fx:<efeito>@<valor>                     : o estágio EFFECTS só com esse efeito
+    - synth:<modo>                            : o estágio SYNTH em cada modo de fase
+ Cada valor é o melhor de 3 médias, em 3 passagens por toda a grelha (uma
+ quebra de velocidade da máquina com alguns segundos só estraga uma). Com --report FILE grava as linhas em TSV
+ (kernel, N, voices, ns); com --baseline FILE compara com um relatório
+ anterior e falha (código 1) se algum kernel ficar mais de --threshold %
+ (25 por omissão) acima da base, com 50 ns de folga para os kernels curtos.
+*/
+int kernels(const StftConfig& base, const std::string& reportFile, const std::string& baselineFile, double threshold) {
+    struct Row { std::string kernel; int N, voices; double ns; };
+    std::vector<Row> rows;
+
+    // Base anterior: "kernel N voices ns" por linha (# = comentário)
+    std::vector<Row> baseline;
+    if (!baselineFile.empty()) {
+        FILE* f = std::fopen(baselineFile.c_str(), "r");
+        if (!f) { std::fprintf(stderr, "error: cannot read %s\n", baselineFile.c_str()); return 2; }
+        char line[256], name[128];
+        Row r;
+        while (std::fgets(line, sizeof line, f))
+            if (line[0] != '#' && std::sscanf(line, "%127s %d %d %lf", name, &r.N, &r.voices, &r.ns) == 4) {
+                r.kernel = name;
+                baseline.push_back(r);
+            }
+        std::fclose(f);
+    }
+
+    constexpr int kStages = SpectroEngine::PROFILE_STAGES;
+    enum { WINDOW = 0, FFT, ANALYZE, EFFECTS, SYNTH, IFFT, OLA, OUTPUT };
+    static_assert(kStages == OUTPUT + 1, "estágios de profileStages()");
+    const float kAmounts[][3] = { {}, { 0.25f, 0.5f, 1.f }, { 0.25f, 0.5f, 1.f }, { 0.25f, 0.5f, 1.f },
+                                  { 0.25f, 0.5f, 1.f }, { 0.25f, 0.5f, 1.f }, { 0.25f, 0.5f, 1.f },
+                                  { 0.f, 0.25f, 1.f } };       // stretch: 0.5 = repouso
+
+    std::mt19937 rng(19);
+    std::uniform_real_distribution<float> uni(-kVolts, kVolts);
+    for (int pass = 0; pass < 3; ++pass) {
+        size_t row = 0;
+        for (int N : { 256, 1024, 4096 }) {
+            for (int V : { 1, 4, 16 }) {
+                StftConfig stft = base;
+                stft.fftSize = N;
+                stft.sampleRate = 48000.f;
+                auto engine = std::make_unique<SpectroEngine>(stft);
+                engine->setChannels(V, V);
+
+                // Média de ~10 ms (nº de hops estimado por 4 hops de aquecimento)
+                auto profile = [&](const SpectroParams& p, double* ns) {
+                    engine->setParams(p);
+                    engine->profileStages(4, ns);
+                    double hopNs = 0.0;
+                    for (int st = 0; st < kStages; ++st) hopNs += ns[st];
+                    const int hops = std::clamp((int)(1e7 / std::max(hopNs, 1.0)), 4, 2000);
+                    engine->reset();
+                    float xl[SpectroEngine::MAX_VOICES], xr[SpectroEngine::MAX_VOICES];
+                    float yl[SpectroEngine::MAX_VOICES], yr[SpectroEngine::MAX_VOICES];
+                    for (int i = 0; i < 2 * N; ++i) {           // buffers e histórico de fase com sinal
+                        for (int v = 0; v < V; ++v) { xl[v] = uni(rng); xr[v] = uni(rng); }
+                        engine->processFrame(xl, xr, yl, yr);
+                    }
+                    engine->profileStages(hops, ns);
+                };
+                auto add = [&](const std::string& kernel, double ns) {
+                    if (pass == 0) rows.push_back({ kernel, engine->fftSize(), V, ns });
+                    else           rows[row].ns = std::min(rows[row].ns, ns);
+                    ++row;
+                };
+
+                double ns[kStages];
+                SpectroParams p = makeParams(0, 0, 0, 0.f);
+                p.fastPaths = false;
+                profile(p, ns);
+                add("window", ns[WINDOW]);
+                add("fft", ns[FFT]);
+                add("analyze", ns[ANALYZE]);
+                add("fx:none", ns[EFFECTS]);
+                add("ifft", ns[IFFT]);
+                add("ola", ns[OLA]);
+                add("output", ns[OUTPUT]);
+                for (int e = 1; e < 8; ++e) {
+                    for (float a : kAmounts[e]) {
+                        p = makeParams(e, 0, 0, a);
+                        p.fastPaths = false;
+                        profile(p, ns);
+                        char name[64];
+                        std::snprintf(name, sizeof name, "fx:%s@%.2f", kEffects[e], a);
+                        add(name, ns[EFFECTS]);
+                    }
+                }
+                for (int m = 0; m < 4; ++m) {
+                    p = makeParams(0, m, 0, 0.f);
+                    p.fastPaths = false;
+                    profile(p, ns);
+                    add(std::string("synth:") + kPhases[m], ns[SYNTH]);
+                }
+            }
+        }
+    }
+
+    // Tabela (e comparação com a base, se houver)
+    std::printf("# %s, %s, ns per hop of one side (all voices)%s\n", FFTBackend::name(base.backend),
+                kPrecisions[(int)base.precision], baseline.empty() ? "" : ", vs baseline");
+    std::printf("%-18s %5s %6s %12s %12s %8s\n", "kernel", "N", "voices", "ns", "baseline", "delta");
+    int regressions = 0;
+    for (const Row& r : rows) {
+        const Row* b = nullptr;
+        for (const Row& x : baseline)
+            if (x.kernel == r.kernel && x.N == r.N && x.voices == r.voices) { b = &x; break; }
+        if (!b) {
+            std::printf("%-18s %5d %6d %12.0f %12s %8s\n", r.kernel.c_str(), r.N, r.voices, r.ns, "-", baseline.empty() ? "" : "new");
+            continue;
+        }
+        const bool slow = r.ns > b->ns * (1.0 + threshold / 100.0) + 50.0;
+        regressions += slow;
+        std::printf("%-18s %5d %6d %12.0f %12.0f %+7.1f%%%s\n", r.kernel.c_str(), r.N, r.voices, r.ns, b->ns,
+                    b->ns > 0.0 ? 100.0 * (r.ns / b->ns - 1.0) : 0.0, slow ? "  REGRESSION" : "");
+    }
+
+    if (!reportFile.empty()) {
+        FILE* f = std::fopen(reportFile.c_str(), "w");
+        if (!f) { std::fprintf(stderr, "error: cannot write %s\n", reportFile.c_str()); return 2; }
+        std::fprintf(f, "# kernel\tN\tvoices\tns\n");
+        for (const Row& r : rows) std::fprintf(f, "%s\t%d\t%d\t%.1f\n", r.kernel.c_str(), r.N, r.voices, r.ns);
+        std::fclose(f);
+    }
+    if (!baseline.empty())
+        std::printf("# %d regression(s) above %.0f%% (+50 ns)\n", regressions, threshold);
+    return regressions ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) { usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if      (a == "--wav")     o.wav = next();
+        else if (a == "--signal")  o.signal = next();
+        else if (a == "--seconds") { o.seconds = std::atof(next().c_str()); o.secondsSet = true; }
+        else if (a == "--rate")    { o.rate = std::atoi(next().c_str()); o.rateSet = true; }
+        else if (a == "--effect")  o.effect = next();
+        else if (a == "--phase")   o.phase = next();
+        else if (a == "--amount")  o.amount = (float)std::atof(next().c_str());
+        else if (a == "--out")     o.out = next();
+        else if (a == "--schedule") o.schedule = next();
+        else if (a == "--block")   o.block = std::max(1, std::atoi(next().c_str()));
+        else if (a == "--voices")  o.voices = std::clamp(std::atoi(next().c_str()), 1, SpectroEngine::MAX_VOICES);
+        else if (a == "--fft")     o.fft = std::clamp(std::atoi(next().c_str()), 256, 8192);
+        else if (a == "--overlap") o.overlap = std::clamp(std::atoi(next().c_str()), 2, 8);
+        else if (a == "--wisdom")  o.wisdom = next();
+        else if (a == "--fft-backend") o.backend = next();
+        else if (a == "--precision") o.precision = next();
+        else if (a == "--pair-stereo") o.pairStereo = true;
+        else if (a == "--split-band") o.splitBand = true;
+        else if (a == "--limiter")  o.limiter = std::clamp((float)std::atof(next().c_str()), 0.f, 8.f);
+        else if (a == "--dc-block") o.dcBlock = std::clamp((float)std::atof(next().c_str()), 0.f, 200.f);
+        else if (a == "--instantiate") o.instantiate = std::max(1, std::atoi(next().c_str()));
+        else if (a == "--kernels")   o.kernels = true;
+        else if (a == "--report")    o.report = next();
+        else if (a == "--baseline")  o.baseline = next();
+        else if (a == "--threshold") o.threshold = std::max(0.0, std::atof(next().c_str()));
+        else if (a == "--load")      { const std::string v = next(); o.load = v == "auto" ? 0 : std::max(1, std::atoi(v.c_str())); }
+        else if (a == "--threads")   o.threads = std::clamp(std::atoi(next().c_str()), 1, 256);
+        else if (a == "--scenario")  o.scenario = next();
+        else if (a == "--max-miss")  o.maxMiss = std::max(0.0, std::atof(next().c_str()));
+        else if (a == "--verify-fx") return verifyFX();
+        else if (a == "--verify-chain") return verifyChain();
+        else if (a == "--verify-math") return verifyMath();
+        else if (a == "--verify-fft") return verifyFFT();
+        else if (a == "--verify-precision") return verifyPrecision();
+        else if (a == "--verify-pair") return verifyPair();
+        else if (a == "--verify-colormap") return verifyColormap();
+        else if (a == "--verify-stream") return verifyStream();
+        else if (a == "--verify-mask") return verifyMask();
+        else if (a == "--verify-fastpath") return verifyFastPath();
+        else if (a == "--verify-output") return verifyOutput();
+        else if (a == "--verify-split") return verifySplit();
+        else if (a == "--verify-phase") return verifyPhase();
+        else if (a == "--verify-pghi") return verifyPghi();
+        else if (a == "--verify-stats") return verifyStats();
+        else if (a == "--verify-render") return verifyRender();
+        else { usage(); return a == "--help" || a == "-h" ? 0 : 2; }
+    }
+
+    const int precision = indexOf(kPrecisions, 2, o.precision);
+    if (precision < 0) { usage(); return 2; }
+    if (!o.wisdom.empty()) {
+        PlanCache::setWisdomFile(o.wisdom);
+        PlanCache::setWisdomFile(o.wisdom + ".float", true);
+    }
+    if (o.instantiate > 0) {
+        StftConfig stft;
+        stft.fftSize = o.fft;
+        stft.overlap = o.overlap;
+        stft.precision = StftPrecision(precision);
+        stft.pairStereo = o.pairStereo;
+        return instantiate(stft, o.instantiate);
+    }
+    if (o.kernels) {
+        StftConfig stft;
+        stft.overlap = o.overlap;
+        stft.precision = StftPrecision(precision);
+        if (int b = indexOf(kBackends, 5, o.backend); b >= 0) stft.backend = FFTBackend::Kind(b);
+        else { usage(); return 2; }
+        return kernels(stft, o.report, o.baseline, o.threshold);
+    }
+    if (o.load >= 0) {
+        std::vector<int> scenarios;
+        if (o.scenario == "all") { for (int sc = 0; sc < 5; ++sc) scenarios.push_back(sc); }
+        else if (int sc = indexOf(kLoadScenarios, 5, o.scenario); sc >= 0) scenarios.push_back(sc);
+        else { usage(); return 2; }
+        const int b = indexOf(kBackends, 5, o.backend);
+        if (b < 0) { usage(); return 2; }
+        const int threads = o.threads > 0 ? o.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+        const double seconds = o.secondsSet ? o.seconds : 3.0;
+        std::vector<int> rates = { 48000, 96000, 192000 };
+        if (o.rateSet) rates = { o.rate };
+        std::printf("# load: %d thread(s), block %d, %d voice(s) per side, fft %d overlap %d, %.1f s per run\n",
+                    threads, o.block, o.voices, o.fft, o.overlap, seconds);
+        for (int rate : o.wav.empty() ? rates : std::vector<int> { 0 }) {
+            WavFile in;
+            if (!o.wav.empty()) {
+                std::string err;
+                if (!in.load(o.wav, &err)) { std::fprintf(stderr, "error: %s: %s\n", o.wav.c_str(), err.c_str()); return 1; }
+            } else {
+                in = makeSignal(o.signal, std::min(seconds, 10.0), rate);
+            }
+            StftConfig stft;
+            stft.fftSize    = o.fft;
+            stft.overlap    = o.overlap;
+            stft.sampleRate = (float)in.sampleRate;
+            stft.precision  = StftPrecision(precision);
+            stft.pairStereo = o.pairStereo;
+            stft.splitBand  = o.splitBand;
+            stft.backend    = FFTBackend::Kind(b);
+            loadTest(in, stft, scenarios, o.load, threads, o.block, o.voices, seconds, o.maxMiss,
+                     o.schedule == "spread" ? HopSchedule::SPREAD : HopSchedule::IMMEDIATE);
+        }
+        return 0;
+    }
+
+    WavFile in;
+    if (!o.wav.empty()) {
+        std::string err;
+        if (!in.load(o.wav, &err)) { std::fprintf(stderr, "error: %s: %s\n", o.wav.c_str(), err.c_str()); return 1; }
+    } else {
+        if (o.signal != "noise" && o.signal != "sine" && o.signal != "sweep" && o.signal != "impulse") { usage(); return 2; }
+        in = makeSignal(o.signal, o.seconds, o.rate);
+    }
+
+    std::vector<int> effects, phases, schedules;
+    if (o.effect == "all") { for (int e = 0; e < 8; ++e) effects.push_back(e); }
+    else if (int e = indexOf(kEffects, 8, o.effect); e >= 0) effects.push_back(e);
+    else { usage(); return 2; }
+    if (o.phase == "all") { for (int p = 0; p < 4; ++p) phases.push_back(p); }
+    else if (int p = indexOf(kPhases, 4, o.phase); p >= 0) phases.push_back(p);
+    else { usage(); return 2; }
+    if (o.schedule == "all") { schedules = { 0, 1 }; }
+    else if (int sc = indexOf(kSchedules, 2, o.schedule); sc >= 0) schedules.push_back(sc);
+    else { usage(); return 2; }
+
+    // Mesma regra do módulo: o N efetivo acompanha a frequência de amostragem
+    StftConfig stft;
+    stft.fftSize    = o.fft;
+    stft.overlap    = o.overlap;
+    stft.sampleRate = (float)in.sampleRate;
+    stft.precision  = StftPrecision(precision);
+    stft.pairStereo = o.pairStereo;
+    stft.splitBand  = o.splitBand;
+    if (int b = indexOf(kBackends, 5, o.backend); b >= 0) stft.backend = FFTBackend::Kind(b);
+    else { usage(); return 2; }
+    {
+        SpectroEngine probe(stft);
+        std::printf("# input: %s, %zu frames @ %d Hz (%.2f s), N=%d H=%d latency=%d, fft=%s %s%s%s, block=%d, voices=%d+%d\n",
+                    o.wav.empty() ? o.signal.c_str() : o.wav.c_str(), in.frames(), in.sampleRate,
+                    (double)in.frames() / in.sampleRate, probe.fftSize(), probe.hopSize(), probe.latency(),
+                    FFTBackend::name(probe.fftBackend()), kPrecisions[precision], o.pairStereo ? " paired" : "",
+                    o.splitBand ? " split" : "", o.block, o.voices, o.voices);
+    }
+    std::printf("%-8s %-7s %-9s %10s %10s %12s %10s %10s %10s\n", "effect", "phase", "schedule",
+                "rtf", "x-realtime", "ns/hop", "worst[us]", "p99.9[us]", "block[us]");
+
+    WavFile rendered;
+    for (int e : effects) {
+        for (int p : phases) {
+            for (int sc : schedules) {
+                const bool last = (e == effects.back() && p == phases.back() && sc == schedules.back());
+                SpectroParams params = makeParams(e, p, sc, o.amount);
+                params.limiterDrive = o.limiter;
+                params.dcBlockHz    = o.dcBlock;
+                Result r = run(in, stft, params, o.block, o.voices, (last && !o.out.empty()) ? &rendered : nullptr);
+                std::printf("%-8s %-7s %-9s %10.5f %10.1f %12.0f %10.2f %10.2f %10.2f\n", kEffects[e], kPhases[p], kSchedules[sc],
+                            r.rtf, r.rtf > 0.0 ? 1.0 / r.rtf : 0.0, r.nsPerHop, r.worstNs * 1e-3, r.p999Ns * 1e-3, r.worstBlockNs * 1e-3);
+            }
+        }
+    }
+
+    if (!o.out.empty() && !rendered.save(o.out)) {
+        std::fprintf(stderr, "error: cannot write %s\n", o.out.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ spectrofx-render
+
+ Render offline (sem Rack) de pastas ou ficheiros WAV pelo pipeline do
+ SpectroFX, com um preset de parâmetros/máscara. Ficheiros e canais são
+ repartidos por um pool de threads com roubo de trabalho; a entrada é lida
+ por memória mapeada e a saída escrita em streaming (float 32 bits, RF64
+ acima de 4 GiB), logo a memória não cresce com o tamanho dos ficheiros.
+ Ver BatchRender.hpp.
+
+ Uso:
+    spectrofx-render [--preset FILE] [--set KEY=VALUE]... --out DIR
+                     [--threads T] [--chunk FRAMES] [--window CHUNKS]
+                     INPUT...
+
+ INPUT é um WAV ou uma pasta (todos os *.wav dela, sem recursão). Cada saída
+ fica em DIR com o nome da entrada. --set acrescenta/substitui uma chave do
+ preset (a mesma sintaxe, p.ex. --set blur=0.4 --set phase=pvlock). Sai com
+ código 1 se algum ficheiro falhar.
+ */
+#include "BatchRender.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: spectrofx-render [--preset FILE] [--set KEY=VALUE]... --out DIR\n"
+        "                        [--threads T] [--chunk FRAMES] [--window CHUNKS]\n"
+        "                        INPUT...  (WAV files or folders of *.wav)\n");
+}
+
+bool isWav(const fs::path& p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return ext == ".wav";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BatchRenderer::Options opt;
+    std::string outDir;
+    std::vector<std::string> sources;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) { usage(); std::exit(2); }
+            return argv[++i];
+        };
+        std::string err;
+        if (a == "--preset") {
+            if (!opt.preset.load(next(), &err)) { std::fprintf(stderr, "preset: %s\n", err.c_str()); return 2; }
+        }
+        else if (a == "--set") {
+            const std::string kv = next();
+            const size_t eq = kv.find('=');
+            if (eq == std::string::npos || !opt.preset.set(kv.substr(0, eq), kv.substr(eq + 1), &err)) {
+                std::fprintf(stderr, "--set %s: %s\n", kv.c_str(), err.empty() ? "expected KEY=VALUE" : err.c_str());
+                return 2;
+            }
+        }
+        else if (a == "--out") outDir = next();
+        else if (a == "--threads") opt.threads = std::atoi(next().c_str());
+        else if (a == "--chunk") opt.chunk = std::atoi(next().c_str());
+        else if (a == "--window") opt.window = std::atoi(next().c_str());
+        else if (a == "--help" || a == "-h") { usage(); return 0; }
+        else if (!a.empty() && a[0] == '-') { usage(); return 2; }
+        else sources.push_back(a);
+    }
+    if (outDir.empty() || sources.empty()) { usage(); return 2; }
+
+    std::vector<std::string> inputs, outputs;
+    std::error_code ec;
+    for (const std::string& s : sources) {
+        std::vector<fs::path> found;
+        if (fs::is_directory(s, ec)) {
+            for (const auto& e : fs::directory_iterator(s, ec))
+                if (e.is_regular_file() && isWav(e.path())) found.push_back(e.path());
+            std::sort(found.begin(), found.end());
+        } else {
+            found.push_back(s);
+        }
+        for (const fs::path& p : found) {
+            inputs.push_back(p.string());
+            outputs.push_back((fs::path(outDir) / p.filename()).string());
+        }
+    }
+    if (inputs.empty()) { std::fprintf(stderr, "no WAV files found\n"); return 2; }
+    fs::create_directories(outDir, ec);
+    for (size_t i = 0; i < inputs.size(); ++i)
+        if (fs::exists(inputs[i], ec) && fs::equivalent(inputs[i], outputs[i], ec)) {
+            std::fprintf(stderr, "%s: output would overwrite the input\n", inputs[i].c_str());
+            return 2;
+        }
+
+    BatchRenderer renderer(opt);
+    std::mutex printing;
+    size_t completed = 0;
+    renderer.onFile = [&](const BatchRenderer::FileResult& r) {
+        std::lock_guard<std::mutex> lock(printing);
+        ++completed;
+        if (r.error.empty())
+            std::printf("[%zu/%zu] %s: %d ch, %.1f s @ %d Hz\n", completed, inputs.size(), r.output.c_str(),
+                        r.channels, (double)r.frames / std::max(1, r.sampleRate), r.sampleRate);
+        else
+            std::fprintf(stderr, "[%zu/%zu] %s: %s\n", completed, inputs.size(), r.input.c_str(), r.error.c_str());
+        std::fflush(stdout);
+    };
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::vector<BatchRenderer::FileResult> results = renderer.run(inputs, outputs);
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    double audio = 0.0;         // segundos de áudio × canais
+    int failed = 0;
+    for (const auto& r : results) {
+        if (!r.error.empty()) { ++failed; continue; }
+        audio += (double)r.frames * r.channels / std::max(1, r.sampleRate);
+    }
+    std::printf("%zu file(s), %d failed: %.1f channel-seconds in %.2f s (%.1f× real time per channel)\n",
+                results.size(), failed, audio, wall, wall > 0.0 ? audio / wall : 0.0);
+    return failed ? 1 : 0;
+}